@@ -0,0 +1,318 @@
+#include "CashGen/Public/CGGenerationSubsystem.h"
+#include "CashGen/Public/CGTerrainGeneratorWorker.h"
+#include "CashGen/Public/CGTerrainManager.h"
+
+// Totals across every registered manager, and across the distinct pool sets for the mesh data stats
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ PendingJobs"), STAT_PendingJobs, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ PrefetchJobs"), STAT_PrefetchJobs, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ UpdateJobs"), STAT_UpdateJobs, STATGROUP_CashGenStat);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("CashGenStat ~ JobsPerSecond"), STAT_JobsPerSecond, STATGROUP_CashGenStat);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("CashGenStat ~ SecondsSinceTerrainComplete"), STAT_SecondsSinceTerrainComplete, STATGROUP_CashGenStat);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataFreeSlotsLOD0"), STAT_MeshDataFreeSlotsLOD0, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataFreeSlotsLOD1"), STAT_MeshDataFreeSlotsLOD1, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataFreeSlotsLOD2"), STAT_MeshDataFreeSlotsLOD2, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataFreeSlotsLOD3+"), STAT_MeshDataFreeSlotsLOD3, STATGROUP_CashGenStat);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ TilesSpawned"), STAT_TilesSpawned, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ TilesRequested"), STAT_TilesRequested, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ TilesTransition"), STAT_TilesTransition, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ TilesIdle"), STAT_TilesIdle, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ FreeTiles"), STAT_FreeTiles, STATGROUP_CashGenStat);
+
+DECLARE_MEMORY_STAT(TEXT("CashGenStat ~ TileSectionMemory"), STAT_TileSectionMemory, STATGROUP_CashGenStat);
+DECLARE_MEMORY_STAT(TEXT("CashGenStat ~ CollisionMemory"), STAT_CollisionMemory, STATGROUP_CashGenStat);
+DECLARE_MEMORY_STAT(TEXT("CashGenStat ~ SplatTextureMemory"), STAT_SplatTextureMemory, STATGROUP_CashGenStat);
+DECLARE_MEMORY_STAT(TEXT("CashGenStat ~ MeshDataPoolMemory"), STAT_MeshDataPoolMemory, STATGROUP_CashGenStat);
+DECLARE_MEMORY_STAT(TEXT("CashGenStat ~ HeightFieldMemory"), STAT_HeightFieldMemory, STATGROUP_CashGenStat);
+DECLARE_MEMORY_STAT(TEXT("CashGenStat ~ TotalMemory"), STAT_TotalMemory, STATGROUP_CashGenStat);
+
+void UCGGenerationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	myTickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UCGGenerationSubsystem::Tick));
+}
+
+void UCGGenerationSubsystem::Deinitialize()
+{
+	FTicker::GetCoreTicker().RemoveTicker(myTickHandle);
+
+	StopWorkerThreads();
+	{
+		FScopeLock lock(&myClientsLock);
+		myClients.Empty();
+	}
+	myMeshDataPools.Empty();
+
+	Super::Deinitialize();
+}
+
+/************************************************************************
+  Managers with the same tile layouts get the same pools. The pool
+		sizes come from whichever of them registered first
+************************************************************************/
+FCGMeshDataPoolsPtr UCGGenerationSubsystem::RegisterManager(ACGTerrainManager* aManager)
+{
+	const FString layoutKey = FCGMeshDataPools::GetLayoutKey(aManager->myTerrainConfig);
+
+	FCGGenerationClientPtr existingClient;
+	{
+		FScopeLock lock(&myClientsLock);
+		const FCGGenerationClientPtr* found = myClients.FindByPredicate([aManager](const FCGGenerationClientPtr& aClient) { return aClient->myManager == aManager; });
+		if (found)
+		{
+			existingClient = *found;
+		}
+	}
+
+	if (existingClient.IsValid())
+	{
+		// Same layout, so everything it already has still fits. It may want more threads than before though
+		const FCGMeshDataPoolsPtr* layoutPools = myMeshDataPools.Find(layoutKey);
+		if (layoutPools && *layoutPools == existingClient->myMeshDataPools)
+		{
+			StartWorkerThreads();
+			return existingClient->myMeshDataPools;
+		}
+
+		// The layout changed, only this manager's client goes. The workers stay for the new one
+		RemoveClient(aManager);
+	}
+
+	FCGMeshDataPoolsPtr& pools = myMeshDataPools.FindOrAdd(layoutKey);
+	if (!pools.IsValid())
+	{
+		pools = MakeShared<FCGMeshDataPools, ESPMode::ThreadSafe>(aManager->myTerrainConfig);
+	}
+
+	FCGGenerationClientPtr client = MakeShared<FCGGenerationClient, ESPMode::ThreadSafe>();
+	client->myManager = aManager;
+	client->myMeshDataPools = pools;
+	{
+		FScopeLock lock(&myClientsLock);
+		myClients.Add(client);
+	}
+
+	StartWorkerThreads();
+
+	return pools;
+}
+
+void UCGGenerationSubsystem::UnregisterManager(ACGTerrainManager* aManager)
+{
+	if (RemoveClient(aManager) && myClients.Num() == 0)
+	{
+		StopWorkerThreads();
+	}
+}
+
+bool UCGGenerationSubsystem::RemoveClient(ACGTerrainManager* aManager)
+{
+	FCGGenerationClientPtr client;
+	{
+		FScopeLock lock(&myClientsLock);
+		const int32 index = myClients.IndexOfByPredicate([aManager](const FCGGenerationClientPtr& aClient) { return aClient->myManager == aManager; });
+		if (index == INDEX_NONE)
+		{
+			return false;
+		}
+		client = myClients[index];
+		myClients.RemoveAt(index);
+	}
+
+	// Workers blocked borrowing for it give up on seeing this, the rest are a job away from done. The last one to
+	// finish wakes us, it can't have missed the flag because it checks it after taking the count to zero
+	client->myIsRegistered = false;
+	if (client->myNumActiveJobs.GetValue() > 0)
+	{
+		client->myJobsDoneEvent->Wait();
+	}
+
+	// Pools nobody else is using go once the manager lets go of them too
+	const bool isPoolShared = myClients.ContainsByPredicate([&client](const FCGGenerationClientPtr& aClient) { return aClient->myMeshDataPools == client->myMeshDataPools; });
+	if (!isPoolShared)
+	{
+		for (auto it = myMeshDataPools.CreateIterator(); it; ++it)
+		{
+			if (it.Value() == client->myMeshDataPools)
+			{
+				it.RemoveCurrent();
+			}
+		}
+	}
+
+	return true;
+}
+
+void UCGGenerationSubsystem::FinishJob(FCGGenerationClient& aClient)
+{
+	if (aClient.myNumActiveJobs.Decrement() == 0 && !aClient.myIsRegistered)
+	{
+		aClient.myJobsDoneEvent->Trigger();
+	}
+}
+
+/************************************************************************
+  Round robin over the managers, starting after the one the last job
+		came from. Pending jobs of every manager are looked at before
+		any prefetch job, so prefetching never holds up what's needed
+************************************************************************/
+FCGGenerationClientPtr UCGGenerationSubsystem::DequeueJob(FCGJob& aOutJob)
+{
+	FScopeLock lock(&myClientsLock);
+
+	const int32 numClients = myClients.Num();
+	for (int32 pass = 0; pass < 2; ++pass)
+	{
+		for (int32 i = 0; i < numClients; ++i)
+		{
+			const int32 index = (myNextClient + i) % numClients;
+			const FCGGenerationClientPtr& client = myClients[index];
+			ACGTerrainManager* manager = client->myManager;
+			if (pass == 0 ? manager->myPendingJobQueue.Dequeue(aOutJob) : manager->myPrefetchJobQueue.Dequeue(aOutJob))
+			{
+				myNextClient = (index + 1) % numClients;
+				client->myNumActiveJobs.Increment();
+				return client;
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+bool UCGGenerationSubsystem::Tick(float aDeltaSeconds)
+{
+	ReportManagerStats();
+
+	myTimeSinceLastPoolUpdate += aDeltaSeconds;
+	if (myTimeSinceLastPoolUpdate > myPoolUpdateTime)
+	{
+		FCGMeshDataPoolTotals totals;
+		for (auto& pools : myMeshDataPools)
+		{
+			pools.Value->Update(myTimeSinceLastPoolUpdate, totals);
+		}
+		FCGMeshDataPools::ReportStats(totals);
+
+		myTimeSinceLastPoolUpdate = 0.0f;
+	}
+
+	return true;
+}
+
+/************************************************************************
+  Sums every manager's load into the stats, so several managers in a
+		level add up instead of each overwriting the last. Pools are
+		counted once per set, however many managers share it
+************************************************************************/
+void UCGGenerationSubsystem::ReportManagerStats()
+{
+#if STATS
+	FCGTerrainStats totals;
+	bool isTerrainComplete = myClients.Num() > 0;
+	double secondsSinceTerrainComplete = MAX_dbl;
+	for (const FCGGenerationClientPtr& client : myClients)
+	{
+		const FCGTerrainStats stats = client->myManager->GetStats();
+		totals.PendingJobs += stats.PendingJobs;
+		totals.PrefetchJobs += stats.PrefetchJobs;
+		totals.UpdateJobs += stats.UpdateJobs;
+		totals.JobsPerSecond += stats.JobsPerSecond;
+		totals.TilesSpawned += stats.TilesSpawned;
+		totals.TilesRequested += stats.TilesRequested;
+		totals.TilesTransition += stats.TilesTransition;
+		totals.TilesIdle += stats.TilesIdle;
+		totals.FreeTiles += stats.FreeTiles;
+		totals.SectionBytes += stats.SectionBytes;
+		totals.CollisionBytes += stats.CollisionBytes;
+		totals.TextureBytes += stats.TextureBytes;
+		totals.HeightFieldBytes += stats.HeightFieldBytes;
+
+		// Complete once every manager is, as of the most recent of them
+		isTerrainComplete &= stats.SecondsSinceTerrainComplete > 0.0;
+		secondsSinceTerrainComplete = FMath::Min(secondsSinceTerrainComplete, stats.SecondsSinceTerrainComplete);
+	}
+
+	// Fixed stat names, so LODs past the third are lumped together
+	int32 freeSlots[4] = { 0, 0, 0, 0 };
+	int64 poolBytes = 0;
+	for (const auto& pools : myMeshDataPools)
+	{
+		for (int32 lod = 0; lod < pools.Value->NumLODs(); ++lod)
+		{
+			freeSlots[FMath::Min(lod, 3)] += pools.Value->GetPool(lod).NumFree();
+		}
+		poolBytes += pools.Value->GetAllocatedBytes();
+	}
+
+	SET_DWORD_STAT(STAT_PendingJobs, totals.PendingJobs);
+	SET_DWORD_STAT(STAT_PrefetchJobs, totals.PrefetchJobs);
+	SET_DWORD_STAT(STAT_UpdateJobs, totals.UpdateJobs);
+	SET_FLOAT_STAT(STAT_JobsPerSecond, totals.JobsPerSecond);
+	SET_FLOAT_STAT(STAT_SecondsSinceTerrainComplete, isTerrainComplete ? secondsSinceTerrainComplete : 0.0);
+
+	SET_DWORD_STAT(STAT_MeshDataFreeSlotsLOD0, freeSlots[0]);
+	SET_DWORD_STAT(STAT_MeshDataFreeSlotsLOD1, freeSlots[1]);
+	SET_DWORD_STAT(STAT_MeshDataFreeSlotsLOD2, freeSlots[2]);
+	SET_DWORD_STAT(STAT_MeshDataFreeSlotsLOD3, freeSlots[3]);
+
+	SET_DWORD_STAT(STAT_TilesSpawned, totals.TilesSpawned);
+	SET_DWORD_STAT(STAT_TilesRequested, totals.TilesRequested);
+	SET_DWORD_STAT(STAT_TilesTransition, totals.TilesTransition);
+	SET_DWORD_STAT(STAT_TilesIdle, totals.TilesIdle);
+	SET_DWORD_STAT(STAT_FreeTiles, totals.FreeTiles);
+
+	SET_MEMORY_STAT(STAT_TileSectionMemory, totals.SectionBytes);
+	SET_MEMORY_STAT(STAT_CollisionMemory, totals.CollisionBytes);
+	SET_MEMORY_STAT(STAT_SplatTextureMemory, totals.TextureBytes);
+	SET_MEMORY_STAT(STAT_MeshDataPoolMemory, poolBytes);
+	SET_MEMORY_STAT(STAT_HeightFieldMemory, totals.HeightFieldBytes);
+	SET_MEMORY_STAT(STAT_TotalMemory, totals.SectionBytes + totals.CollisionBytes + totals.TextureBytes + totals.HeightFieldBytes + poolBytes);
+#endif
+}
+
+/************************************************************************
+  As many threads as the most any registered manager asks for, up to
+		the core count. Threads are only added here, never taken away
+		until the last manager goes
+************************************************************************/
+void UCGGenerationSubsystem::StartWorkerThreads()
+{
+	int32 numThreads = 1;
+	for (const FCGGenerationClientPtr& client : myClients)
+	{
+		numThreads = FMath::Max<int32>(numThreads, client->myManager->myTerrainConfig.NumberOfThreads);
+	}
+	// Make sure there's no daft number of threads
+	numThreads = FMath::Min(numThreads, FPlatformMisc::NumberOfCores());
+
+	while (myWorkerThreads.Num() < numThreads)
+	{
+		const FString threadName = FString::Printf(TEXT("TerrainWorkerThread%d"), myWorkerThreads.Num());
+		FCGTerrainGeneratorWorker* worker = new FCGTerrainGeneratorWorker(*this);
+		myWorkers.Add(worker);
+		myWorkerThreads.Add(FRunnableThread::Create(worker, *threadName, 0, EThreadPriority::TPri_Normal, FPlatformAffinity::GetNoAffinityMask()));
+	}
+}
+
+void UCGGenerationSubsystem::StopWorkerThreads()
+{
+	for (auto& thread : myWorkerThreads)
+	{
+		if (thread != nullptr)
+		{
+			thread->Kill();
+			delete thread;
+			thread = nullptr;
+		}
+	}
+	myWorkerThreads.Empty();
+
+	for (FCGTerrainGeneratorWorker* worker : myWorkers)
+	{
+		delete worker;
+	}
+	myWorkers.Empty();
+}
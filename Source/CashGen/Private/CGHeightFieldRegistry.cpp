@@ -0,0 +1,336 @@
+#include "CashGen/Public/CGHeightFieldRegistry.h"
+#include "CashGen/Public/CGCoreAdapter.h"
+#include "CashGen/Public/Struct/CGTerrainConfig.h"
+
+FCGHeightFieldRegistry::FReadScope::FReadScope(const FCGHeightFieldRegistry& aRegistry)
+	: myRegistry(aRegistry)
+{
+	// Registering has to happen inside the epoch that was read, or the writer could miss this reader
+	for (;;)
+	{
+		const uint64 epoch = myRegistry.myEpoch.load();
+		myEpochSlot = epoch & 1;
+		myRegistry.myNumReaders[myEpochSlot].fetch_add(1);
+		if (myRegistry.myEpoch.load() == epoch)
+		{
+			break;
+		}
+		myRegistry.myNumReaders[myEpochSlot].fetch_sub(1);
+	}
+
+	mySnapshot = myRegistry.mySnapshot.load();
+}
+
+FCGHeightFieldRegistry::FReadScope::~FReadScope()
+{
+	myRegistry.myNumReaders[myEpochSlot].fetch_sub(1);
+}
+
+FCGHeightFieldRegistry::FCGHeightFieldRegistry()
+	: myEpoch(0)
+	, mySnapshot(nullptr)
+	, myIsDirty(false)
+	, myTileSizeX(1.0f)
+	, myTileSizeY(1.0f)
+	, myInvTileSizeX(1.0f)
+	, myInvTileSizeY(1.0f)
+	, myTileOffsetX(0.0f)
+	, myTileOffsetY(0.0f)
+	, myAmplitude(1.0f)
+{
+	myNumReaders[0] = 0;
+	myNumReaders[1] = 0;
+}
+
+FCGHeightFieldRegistry::~FCGHeightFieldRegistry()
+{
+	Reset();
+}
+
+void FCGHeightFieldRegistry::Init(const FCGTerrainConfig& aConfig, const int32 aGridSize)
+{
+	Reset();
+	myWorkingSet.Init(aGridSize);
+
+	myTileSizeX = aConfig.TileXUnits * aConfig.UnitSize;
+	myTileSizeY = aConfig.TileYUnits * aConfig.UnitSize;
+	myInvTileSizeX = 1.0f / myTileSizeX;
+	myInvTileSizeY = 1.0f / myTileSizeY;
+	myTileOffsetX = aConfig.TileOffset.X;
+	myTileOffsetY = aConfig.TileOffset.Y;
+	myAmplitude = aConfig.Amplitude;
+
+	myInvSampleSpacings.SetNum(FMath::Max(aConfig.LODs.Num(), 1));
+	for (int32 lod = 0; lod < myInvSampleSpacings.Num(); ++lod)
+	{
+		myInvSampleSpacings[lod] = 1.0f / (aConfig.UnitSize * FCGCoreAdapter::GetDivisor(aConfig, lod));
+	}
+}
+
+void FCGHeightFieldRegistry::Set(const FIntVector2& aSector, const FHeightFieldPtr& aHeightField)
+{
+	myWorkingSet.FindOrAdd(aSector) = aHeightField;
+	myIsDirty = true;
+}
+
+void FCGHeightFieldRegistry::Remove(const FIntVector2& aSector)
+{
+	myIsDirty |= myWorkingSet.Remove(aSector);
+}
+
+void FCGHeightFieldRegistry::Publish()
+{
+	if (myIsDirty)
+	{
+		const FSnapshot* previous = mySnapshot.exchange(new FSnapshot(myWorkingSet));
+		if (previous)
+		{
+			myRetiredSnapshots.Add({ previous, myEpoch.load() });
+		}
+		myIsDirty = false;
+	}
+
+	if (myRetiredSnapshots.Num() == 0)
+	{
+		return;
+	}
+
+	// The epoch can move on once nobody is left in the one before it, which shares the next one's slot
+	const uint64 epoch = myEpoch.load();
+	if (myNumReaders[(epoch + 1) & 1].load() == 0)
+	{
+		myEpoch.store(epoch + 1);
+	}
+
+	// Anyone who could have seen a snapshot retired in epoch e registered in e or earlier, and has gone by e + 2
+	const uint64 currentEpoch = myEpoch.load();
+	int32 numFreed = 0;
+	while (numFreed < myRetiredSnapshots.Num() && myRetiredSnapshots[numFreed].myEpoch + 2 <= currentEpoch)
+	{
+		delete myRetiredSnapshots[numFreed].mySnapshot;
+		numFreed++;
+	}
+	myRetiredSnapshots.RemoveAt(0, numFreed, false);
+}
+
+void FCGHeightFieldRegistry::Reset()
+{
+	for (const FRetiredSnapshot& retired : myRetiredSnapshots)
+	{
+		delete retired.mySnapshot;
+	}
+	myRetiredSnapshots.Reset();
+	delete mySnapshot.exchange(nullptr);
+	myWorkingSet.Init(1);
+	myIsDirty = false;
+}
+
+bool FCGHeightFieldRegistry::GetGroundInfo(const float aX, const float aY, FCGGroundInfo& aOutGroundInfo) const
+{
+	FReadScope readScope(*this);
+	return readScope.GetSnapshot() && GetGroundInfo(*readScope.GetSnapshot(), aX, aY, aOutGroundInfo);
+}
+
+/************************************************************************
+  Bilinear height and gradient from the four samples around the point.
+		Tiles are laid out from their origin, which is sample 1, the
+		border ring is only there for the edge normals
+************************************************************************/
+bool FCGHeightFieldRegistry::GetGroundInfo(const FSnapshot& aSnapshot, const float aX, const float aY, FCGGroundInfo& aOutGroundInfo) const
+{
+	const float tileX = (aX + myTileOffsetX) * myInvTileSizeX;
+	const float tileY = (aY + myTileOffsetY) * myInvTileSizeY;
+	const FIntVector2 sector(FMath::FloorToInt(tileX), FMath::FloorToInt(tileY));
+
+	const FHeightFieldPtr* heightFieldPtr = aSnapshot.Find(sector);
+	if (!heightFieldPtr || !heightFieldPtr->IsValid())
+	{
+		return false;
+	}
+
+	const FCGHeightField& heightField = **heightFieldPtr;
+	const int32 rowLength = heightField.mySize;
+	const int32 numRows = heightField.myHeights.Num() / FMath::Max(rowLength, 1);
+	if (rowLength < 4 || numRows < 4 || !myInvSampleSpacings.IsValidIndex(heightField.myLOD))
+	{
+		return false;
+	}
+
+	const float invSpacing = myInvSampleSpacings[heightField.myLOD];
+	const float sampleX = (tileX - sector.X) * myTileSizeX * invSpacing + 1.0f;
+	const float sampleY = (tileY - sector.Y) * myTileSizeY * invSpacing + 1.0f;
+
+	float gradientX;
+	float gradientY;
+	const float height = CashGenCore::SampleBilinear(heightField.myHeights.GetData(), rowLength, numRows, sampleX, sampleY, gradientX, gradientY);
+	gradientX *= myAmplitude * invSpacing;
+	gradientY *= myAmplitude * invSpacing;
+
+	aOutGroundInfo.Height = height * myAmplitude;
+	aOutGroundInfo.Normal = FVector(-gradientX, -gradientY, 1.0f).GetSafeNormal();
+	aOutGroundInfo.Slope = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(aOutGroundInfo.Normal.Z, -1.0f, 1.0f)));
+	return true;
+}
+
+/************************************************************************
+  Same maths as GetGroundInfo, four points to a vector. Only the tile
+		lookups and the height fetches are per point, since the four
+		points can each be on a different tile at a different LOD
+************************************************************************/
+int32 FCGHeightFieldRegistry::GetGroundInfoBatch(TArrayView<const FVector2D> aPositions, TArrayView<float> aOutHeights, TArrayView<FVector> aOutNormals, TArrayView<bool> aOutResolved) const
+{
+	const int32 numPositions = aPositions.Num();
+	check(aOutHeights.Num() >= numPositions && aOutNormals.Num() >= numPositions && aOutResolved.Num() >= numPositions);
+
+	FReadScope readScope(*this);
+	const FSnapshot* snapshot = readScope.GetSnapshot();
+	if (!snapshot)
+	{
+		for (int32 i = 0; i < numPositions; ++i)
+		{
+			aOutResolved[i] = false;
+		}
+		return 0;
+	}
+
+	const VectorRegister tileOffsetX = VectorSetFloat1(myTileOffsetX);
+	const VectorRegister tileOffsetY = VectorSetFloat1(myTileOffsetY);
+	const VectorRegister invTileSizeX = VectorSetFloat1(myInvTileSizeX);
+	const VectorRegister invTileSizeY = VectorSetFloat1(myInvTileSizeY);
+	const VectorRegister tileSizeX = VectorSetFloat1(myTileSizeX);
+	const VectorRegister tileSizeY = VectorSetFloat1(myTileSizeY);
+	const VectorRegister amplitude = VectorSetFloat1(myAmplitude);
+	const VectorRegister one = VectorOne();
+	const VectorRegister zero = VectorZero();
+
+	// Points tend to come in clusters, so most lookups hit the tile the last one was on
+	FIntVector2 cachedSector;
+	const FCGHeightField* cachedHeightField = nullptr;
+	bool hasCachedSector = false;
+
+	int32 numResolved = 0;
+	for (int32 first = 0; first < numPositions; first += 4)
+	{
+		const int32 numLanes = FMath::Min(numPositions - first, 4);
+
+		float lanesX[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float lanesY[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int32 lane = 0; lane < numLanes; ++lane)
+		{
+			lanesX[lane] = aPositions[first + lane].X;
+			lanesY[lane] = aPositions[first + lane].Y;
+		}
+
+		const VectorRegister tileX = VectorMultiply(VectorAdd(VectorLoad(lanesX), tileOffsetX), invTileSizeX);
+		const VectorRegister tileY = VectorMultiply(VectorAdd(VectorLoad(lanesY), tileOffsetY), invTileSizeY);
+		const VectorRegister sectorX = VectorFloor(tileX);
+		const VectorRegister sectorY = VectorFloor(tileY);
+
+		float sectorsX[4];
+		float sectorsY[4];
+		VectorStore(sectorX, sectorsX);
+		VectorStore(sectorY, sectorsY);
+
+		// Lanes without a tile keep a zero spacing, which pins them to a harmless sample
+		const FCGHeightField* heightFields[4] = { nullptr, nullptr, nullptr, nullptr };
+		float invSpacings[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float maxSamplesX[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		float maxSamplesY[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int32 lane = 0; lane < numLanes; ++lane)
+		{
+			const FIntVector2 sector((int32)sectorsX[lane], (int32)sectorsY[lane]);
+			if (!hasCachedSector || sector != cachedSector)
+			{
+				const FHeightFieldPtr* heightFieldPtr = snapshot->Find(sector);
+				cachedHeightField = heightFieldPtr ? heightFieldPtr->Get() : nullptr;
+				cachedSector = sector;
+				hasCachedSector = true;
+			}
+
+			const FCGHeightField* heightField = cachedHeightField;
+			const int32 numRows = heightField ? heightField->myHeights.Num() / FMath::Max(heightField->mySize, 1) : 0;
+			if (heightField && heightField->mySize >= 4 && numRows >= 4 && myInvSampleSpacings.IsValidIndex(heightField->myLOD))
+			{
+				heightFields[lane] = heightField;
+				invSpacings[lane] = myInvSampleSpacings[heightField->myLOD];
+				maxSamplesX[lane] = heightField->mySize - 3;
+				maxSamplesY[lane] = numRows - 3;
+			}
+		}
+
+		const VectorRegister invSpacing = VectorLoad(invSpacings);
+		const VectorRegister sampleX = VectorMultiplyAdd(VectorMultiply(VectorSubtract(tileX, sectorX), tileSizeX), invSpacing, one);
+		const VectorRegister sampleY = VectorMultiplyAdd(VectorMultiply(VectorSubtract(tileY, sectorY), tileSizeY), invSpacing, one);
+		const VectorRegister x0 = VectorMin(VectorMax(VectorFloor(sampleX), one), VectorLoad(maxSamplesX));
+		const VectorRegister y0 = VectorMin(VectorMax(VectorFloor(sampleY), one), VectorLoad(maxSamplesY));
+		const VectorRegister fx = VectorMin(VectorMax(VectorSubtract(sampleX, x0), zero), one);
+		const VectorRegister fy = VectorMin(VectorMax(VectorSubtract(sampleY, y0), zero), one);
+
+		float samplesX[4];
+		float samplesY[4];
+		VectorStore(x0, samplesX);
+		VectorStore(y0, samplesY);
+
+		float heights00[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float heights10[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float heights01[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float heights11[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int32 lane = 0; lane < numLanes; ++lane)
+		{
+			if (const FCGHeightField* heightField = heightFields[lane])
+			{
+				const int32 rowLength = heightField->mySize;
+				const float* heights = &heightField->myHeights[(int32)samplesX[lane] + rowLength * (int32)samplesY[lane]];
+				heights00[lane] = heights[0];
+				heights10[lane] = heights[1];
+				heights01[lane] = heights[rowLength];
+				heights11[lane] = heights[rowLength + 1];
+			}
+		}
+
+		const VectorRegister h00 = VectorLoad(heights00);
+		const VectorRegister h10 = VectorLoad(heights10);
+		const VectorRegister h01 = VectorLoad(heights01);
+		const VectorRegister h11 = VectorLoad(heights11);
+
+		const VectorRegister top = VectorMultiplyAdd(VectorSubtract(h10, h00), fx, h00);
+		const VectorRegister bottom = VectorMultiplyAdd(VectorSubtract(h11, h01), fx, h01);
+		const VectorRegister height = VectorMultiply(VectorMultiplyAdd(VectorSubtract(bottom, top), fy, top), amplitude);
+
+		const VectorRegister gradientScale = VectorMultiply(amplitude, invSpacing);
+		const VectorRegister dx0 = VectorSubtract(h10, h00);
+		const VectorRegister dx1 = VectorSubtract(h11, h01);
+		const VectorRegister dy0 = VectorSubtract(h01, h00);
+		const VectorRegister dy1 = VectorSubtract(h11, h10);
+		const VectorRegister gradientX = VectorMultiply(VectorMultiplyAdd(VectorSubtract(dx1, dx0), fy, dx0), gradientScale);
+		const VectorRegister gradientY = VectorMultiply(VectorMultiplyAdd(VectorSubtract(dy1, dy0), fx, dy0), gradientScale);
+
+		// Normal is (-gx, -gy, 1) normalised, and the length is never below one
+		const VectorRegister invLength = VectorReciprocalSqrtAccurate(VectorMultiplyAdd(gradientX, gradientX, VectorMultiplyAdd(gradientY, gradientY, one)));
+		const VectorRegister normalX = VectorNegate(VectorMultiply(gradientX, invLength));
+		const VectorRegister normalY = VectorNegate(VectorMultiply(gradientY, invLength));
+
+		float outHeights[4];
+		float outNormalsX[4];
+		float outNormalsY[4];
+		float outNormalsZ[4];
+		VectorStore(height, outHeights);
+		VectorStore(normalX, outNormalsX);
+		VectorStore(normalY, outNormalsY);
+		VectorStore(invLength, outNormalsZ);
+
+		for (int32 lane = 0; lane < numLanes; ++lane)
+		{
+			const int32 index = first + lane;
+			aOutResolved[index] = heightFields[lane] != nullptr;
+			if (heightFields[lane])
+			{
+				aOutHeights[index] = outHeights[lane];
+				aOutNormals[index] = FVector(outNormalsX[lane], outNormalsY[lane], outNormalsZ[lane]);
+				numResolved++;
+			}
+		}
+	}
+
+	return numResolved;
+}
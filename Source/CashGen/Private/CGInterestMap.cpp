@@ -0,0 +1,97 @@
+#include "CashGen/Public/CGInterestMap.h"
+
+FCGInterestMap::FCGInterestMap()
+	: myNumLODs(0)
+{
+}
+
+void FCGInterestMap::Init(const int32 aNumLODs, const int32 aRadius)
+{
+	myNumLODs = aNumLODs;
+	// A footprint and the one it moved from both fit without sharing slots
+	myCoverage.Init((aRadius * 2 + 1) * 2);
+}
+
+void FCGInterestMap::AddFootprint(const FCGSectorStencil& aStencil, const FIntVector2& aSector, TArray<FCGSector>& aOutChanged)
+{
+	for (const FCGSector& cell : aStencil.GetCells())
+	{
+		AddRef(aSector + cell.mySector, cell.myLOD, aOutChanged);
+	}
+}
+
+void FCGInterestMap::RemoveFootprint(const FCGSectorStencil& aStencil, const FIntVector2& aSector, TArray<FCGSector>& aOutChanged, TArray<FIntVector2>& aOutUncovered)
+{
+	for (const FCGSector& cell : aStencil.GetCells())
+	{
+		RemoveRef(aSector + cell.mySector, cell.myLOD, aOutChanged, aOutUncovered);
+	}
+}
+
+void FCGInterestMap::MoveFootprint(const FCGSectorStencil& aStencil, const FIntVector2& aOldSector, const FIntVector2& aNewSector, FCGSectorStencilDelta& aScratch, TArray<FCGSector>& aOutChanged, TArray<FIntVector2>& aOutUncovered)
+{
+	const FCGSectorStencilDelta& delta = aStencil.GetDelta(aNewSector - aOldSector, aScratch);
+
+	for (const FCGSector& cell : delta.Entering)
+	{
+		const FIntVector2 sector = aNewSector + cell.mySector;
+		const int32 oldLOD = aStencil.GetLODAtOffset(sector - aOldSector);
+
+		// Add before removing so a sector that only changed LOD never looks uncovered
+		AddRef(sector, cell.myLOD, aOutChanged);
+		if (oldLOD > -1)
+		{
+			RemoveRef(sector, oldLOD, aOutChanged, aOutUncovered);
+		}
+	}
+
+	for (const FIntVector2& cell : delta.Leaving)
+	{
+		RemoveRef(aOldSector + cell, aStencil.GetLODAtOffset(cell), aOutChanged, aOutUncovered);
+	}
+}
+
+void FCGInterestMap::AddRef(const FIntVector2& aSector, const int32 aLOD, TArray<FCGSector>& aOutChanged)
+{
+	FCGSectorCoverage& coverage = myCoverage.FindOrAdd(aSector);
+	if (coverage.myLODRefs.Num() == 0)
+	{
+		coverage.myLODRefs.SetNumZeroed(myNumLODs);
+	}
+
+	const int32 previousLOD = coverage.GetFinestLOD();
+	coverage.myLODRefs[aLOD]++;
+	coverage.myTotalRefs++;
+
+	if (previousLOD < 0 || aLOD < previousLOD)
+	{
+		aOutChanged.Add(FCGSector(aSector, (uint8)aLOD));
+	}
+}
+
+void FCGInterestMap::RemoveRef(const FIntVector2& aSector, const int32 aLOD, TArray<FCGSector>& aOutChanged, TArray<FIntVector2>& aOutUncovered)
+{
+	FCGSectorCoverage* coverage = myCoverage.Find(aSector);
+	if (!coverage || aLOD < 0 || coverage->myLODRefs[aLOD] == 0)
+	{
+		checkNoEntry();
+		return;
+	}
+
+	coverage->myLODRefs[aLOD]--;
+	coverage->myTotalRefs--;
+
+	if (coverage->myTotalRefs == 0)
+	{
+		myCoverage.Remove(aSector);
+		aOutUncovered.Add(aSector);
+	}
+	else if (coverage->myLODRefs[aLOD] == 0)
+	{
+		const int32 finestLOD = coverage->GetFinestLOD();
+		if (finestLOD > aLOD)
+		{
+			aOutChanged.Add(FCGSector(aSector, (uint8)finestLOD));
+		}
+	}
+}
@@ -0,0 +1,228 @@
+#include "CashGen/Public/CGLatencyStats.h"
+
+#include <Runtime/Core/Public/HAL/IConsoleManager.h>
+#include <Runtime/Core/Public/Misc/FileHelper.h>
+#include <Runtime/Core/Public/Misc/Paths.h>
+#include <Runtime/TraceLog/Public/Trace/Trace.h>
+
+static TAutoConsoleVariable<float> CVarLatencyWindow(
+	TEXT("CashGen.LatencyWindow"),
+	60.0f,
+	TEXT("Seconds of jobs the CashGen latency percentiles cover"));
+
+static FAutoConsoleCommand DumpLatencyCommand(
+	TEXT("CashGen.DumpLatency"),
+	TEXT("Writes CashGen job stage latency percentiles to a CSV file. Optional argument: file name, defaults to Profiling/CashGen/Latency-<timestamp>.csv"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& aArgs)
+	{
+		const FString filename = aArgs.Num() > 0 ? aArgs[0] : FPaths::ProfilingDir() / TEXT("CashGen") / FString::Printf(TEXT("Latency-%s.csv"), *FDateTime::Now().ToString());
+		FCGLatencyStats::Get().DumpCSV(filename);
+	}));
+
+static FAutoConsoleCommand ResetLatencyCommand(
+	TEXT("CashGen.ResetLatency"),
+	TEXT("Clears the CashGen job stage latency histograms"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FCGLatencyStats::Get().Reset();
+	}));
+
+#if UE_TRACE_ENABLED
+UE_TRACE_CHANNEL(CashGenChannel)
+
+// One event per finished job, stage durations are in cycles
+UE_TRACE_EVENT_BEGIN(CashGen, Job)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(int32, SectorX)
+	UE_TRACE_EVENT_FIELD(int32, SectorY)
+	UE_TRACE_EVENT_FIELD(uint8, LOD)
+	UE_TRACE_EVENT_FIELD(bool, IsCollisionJob)
+	UE_TRACE_EVENT_FIELD(uint64, QueueWait)
+	UE_TRACE_EVENT_FIELD(uint64, BorrowWait)
+	UE_TRACE_EVENT_FIELD(uint64, Sampling)
+	UE_TRACE_EVENT_FIELD(uint64, Geometry)
+	UE_TRACE_EVENT_FIELD(uint64, Normals)
+	UE_TRACE_EVENT_FIELD(uint64, Skirts)
+	UE_TRACE_EVENT_FIELD(uint64, Scatter)
+	UE_TRACE_EVENT_FIELD(uint64, UpdateWait)
+	UE_TRACE_EVENT_FIELD(uint64, Upload)
+	UE_TRACE_EVENT_FIELD(uint64, CollisionCook)
+UE_TRACE_EVENT_END()
+#endif
+
+FCGLatencyHistogram::FCGLatencyHistogram()
+	: myCurrent(0)
+{
+	FMemory::Memzero(myCounts);
+	FMemory::Memzero(mySumSeconds);
+	FMemory::Memzero(myMaxSeconds);
+}
+
+void FCGLatencyHistogram::Add(const double aSeconds)
+{
+	myCounts[myCurrent][GetBucket(aSeconds)]++;
+	mySumSeconds[myCurrent] += aSeconds;
+	myMaxSeconds[myCurrent] = FMath::Max(myMaxSeconds[myCurrent], aSeconds);
+}
+
+void FCGLatencyHistogram::Rotate()
+{
+	myCurrent = 1 - myCurrent;
+	FMemory::Memzero(myCounts[myCurrent]);
+	mySumSeconds[myCurrent] = 0.0;
+	myMaxSeconds[myCurrent] = 0.0;
+}
+
+int64 FCGLatencyHistogram::Num() const
+{
+	int64 total = 0;
+	for (int32 i = 0; i < NumBuckets; ++i)
+	{
+		total += myCounts[0][i] + myCounts[1][i];
+	}
+	return total;
+}
+
+double FCGLatencyHistogram::GetMean() const
+{
+	const int64 total = Num();
+	return total > 0 ? (mySumSeconds[0] + mySumSeconds[1]) / total : 0.0;
+}
+
+double FCGLatencyHistogram::GetMax() const
+{
+	return FMath::Max(myMaxSeconds[0], myMaxSeconds[1]);
+}
+
+double FCGLatencyHistogram::GetPercentile(const float aPercentile) const
+{
+	const int64 total = Num();
+	if (total == 0)
+	{
+		return 0.0;
+	}
+
+	const int64 rank = FMath::Max<int64>(FMath::CeilToInt(aPercentile * total), 1);
+	int64 seen = 0;
+	for (int32 i = 0; i < NumBuckets; ++i)
+	{
+		seen += myCounts[0][i] + myCounts[1][i];
+		if (seen >= rank)
+		{
+			// Bucket edges overshoot, never report past the slowest sample
+			return FMath::Min(GetBucketUpperSeconds(i), GetMax());
+		}
+	}
+	return GetMax();
+}
+
+int32 FCGLatencyHistogram::GetBucket(const double aSeconds)
+{
+	const double micros = aSeconds * 1000000.0;
+	if (micros < 1.0)
+	{
+		return 0;
+	}
+	return FMath::Min(1 + FMath::FloorToInt(4.0 * FMath::Log2(micros)), NumBuckets - 1);
+}
+
+double FCGLatencyHistogram::GetBucketUpperSeconds(const int32 aBucket)
+{
+	return FMath::Pow(2.0f, aBucket * 0.25f) / 1000000.0;
+}
+
+FCGLatencyStats& FCGLatencyStats::Get()
+{
+	static FCGLatencyStats stats;
+	return stats;
+}
+
+FCGLatencyStats::FCGLatencyStats()
+	: myLastRotateSeconds(FPlatformTime::Seconds())
+{
+}
+
+FCGLatencyHistogram& FCGLatencyStats::GetHistogram(const uint8 aLOD, const ECGJobStage aStage)
+{
+	const int32 numStages = (int32)ECGJobStage::Num;
+	if (myHistograms.Num() < (aLOD + 1) * numStages)
+	{
+		myHistograms.SetNum((aLOD + 1) * numStages);
+	}
+	return myHistograms[aLOD * numStages + (int32)aStage];
+}
+
+void FCGLatencyStats::AddJob(const FIntVector2& aSector, const uint8 aLOD, const bool aIsCollisionJob, const FCGJobTimings& aTimings)
+{
+	// Slide the window along by half its length at a time
+	const double now = FPlatformTime::Seconds();
+	if (now - myLastRotateSeconds >= CVarLatencyWindow.GetValueOnGameThread() * 0.5f)
+	{
+		for (FCGLatencyHistogram& histogram : myHistograms)
+		{
+			histogram.Rotate();
+		}
+		myLastRotateSeconds = now;
+	}
+
+	for (uint8 stage = 0; stage < (uint8)ECGJobStage::Num; ++stage)
+	{
+		if (aTimings.HasRun((ECGJobStage)stage))
+		{
+			GetHistogram(aLOD, (ECGJobStage)stage).Add(aTimings.GetStageSeconds((ECGJobStage)stage));
+		}
+	}
+
+#if UE_TRACE_ENABLED
+	UE_TRACE_LOG(CashGen, Job, CashGenChannel)
+		<< Job.Cycle(FPlatformTime::Cycles64())
+		<< Job.SectorX(aSector.X)
+		<< Job.SectorY(aSector.Y)
+		<< Job.LOD(aLOD)
+		<< Job.IsCollisionJob(aIsCollisionJob)
+		<< Job.QueueWait(aTimings.GetStageCycles(ECGJobStage::QueueWait))
+		<< Job.BorrowWait(aTimings.GetStageCycles(ECGJobStage::BorrowWait))
+		<< Job.Sampling(aTimings.GetStageCycles(ECGJobStage::Sampling))
+		<< Job.Geometry(aTimings.GetStageCycles(ECGJobStage::Geometry))
+		<< Job.Normals(aTimings.GetStageCycles(ECGJobStage::Normals))
+		<< Job.Skirts(aTimings.GetStageCycles(ECGJobStage::Skirts))
+		<< Job.Scatter(aTimings.GetStageCycles(ECGJobStage::Scatter))
+		<< Job.UpdateWait(aTimings.GetStageCycles(ECGJobStage::UpdateWait))
+		<< Job.Upload(aTimings.GetStageCycles(ECGJobStage::Upload))
+		<< Job.CollisionCook(aTimings.GetStageCycles(ECGJobStage::CollisionCook));
+#endif
+}
+
+bool FCGLatencyStats::DumpCSV(const FString& aFilename) const
+{
+	FString csv = TEXT("Stage,LOD,Count,MeanMs,P50Ms,P95Ms,P99Ms,MaxMs\n");
+
+	const int32 numStages = (int32)ECGJobStage::Num;
+	for (int32 i = 0; i < myHistograms.Num(); ++i)
+	{
+		const FCGLatencyHistogram& histogram = myHistograms[i];
+		const int64 count = histogram.Num();
+		if (count == 0)
+		{
+			continue;
+		}
+
+		csv += FString::Printf(TEXT("%s,%d,%lld,%.3f,%.3f,%.3f,%.3f,%.3f\n"),
+			FCGJobTimings::GetStageName((ECGJobStage)(i % numStages)),
+			i / numStages,
+			count,
+			histogram.GetMean() * 1000.0,
+			histogram.GetPercentile(0.5f) * 1000.0,
+			histogram.GetPercentile(0.95f) * 1000.0,
+			histogram.GetPercentile(0.99f) * 1000.0,
+			histogram.GetMax() * 1000.0);
+	}
+
+	return FFileHelper::SaveStringToFile(csv, *aFilename);
+}
+
+void FCGLatencyStats::Reset()
+{
+	myHistograms.Reset();
+	myLastRotateSeconds = FPlatformTime::Seconds();
+}
@@ -0,0 +1,242 @@
+#include "CashGen/Public/CGMeshDataPools.h"
+#include "CashGen/Public/CGCoreAdapter.h"
+
+#include <Runtime/Core/Public/Async/Async.h>
+
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataBorrowWaitMs"), STAT_MeshDataBorrowWaitMs, STATGROUP_CashGenStat);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataPoolOccupancy"), STAT_MeshDataPoolOccupancy, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataPoolSlots"), STAT_MeshDataPoolSlots, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataPoolGrowths"), STAT_MeshDataPoolGrowths, STATGROUP_CashGenStat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CashGenStat ~ MeshDataPoolShrinks"), STAT_MeshDataPoolShrinks, STATGROUP_CashGenStat);
+
+FCGMeshDataPools::FCGMeshDataPools(const FCGTerrainConfig& aConfig)
+	: myConfig(aConfig)
+{
+	const int32 numLODs = myConfig.LODs.Num();
+	myMeshData.SetNum(numLODs);
+	// The allocation tasks hold pointers to the pools, so they can't move once those start
+	myFreeMeshData.Reserve(numLODs);
+	myAllocations.SetNum(numLODs);
+	myTopologies.SetNum(numLODs);
+
+	for (uint8 lod = 0; lod < numLODs; ++lod)
+	{
+		myFreeMeshData.Emplace();
+
+		const int32 lodPoolSize = myConfig.LODs[lod].MeshDataPoolSize > 0 ? myConfig.LODs[lod].MeshDataPoolSize : myConfig.MeshDataPoolSize;
+		// Collision only mode never borrows anything but the collision LOD
+		const int32 poolSize = myConfig.IsCollisionOnly && lod != myConfig.Collision.LOD ? 0 : lodPoolSize;
+
+		myMeshData[lod].Data.Reserve(poolSize);
+		myMinSizes.Add(poolSize);
+		myIdleTimes.Add(0.0f);
+
+		if (poolSize == 0)
+		{
+			continue;
+		}
+
+		// Filling the pools is the slow part of setup, so it's done on the task pool. Each slot goes into
+		// its pool as soon as it's built, workers can start on the first jobs while the rest are allocated
+		TCGObjectPool<FCGMeshData>* pool = &myFreeMeshData[lod];
+		FLODTopology* topology = &myTopologies[lod];
+		myAllocations[lod] = Async(EAsyncExecution::ThreadPool, [this, pool, topology, lod, poolSize]()
+		{
+			BuildTopology(*topology, myConfig, lod);
+
+			TArray<FCGMeshData*> allocated;
+			allocated.Reserve(poolSize);
+			for (int32 j = 0; j < poolSize; ++j)
+			{
+				FCGMeshData* meshData = new FCGMeshData();
+				AllocateDataStructuresForLOD(meshData, myConfig, lod, *topology);
+				allocated.Add(meshData);
+				pool->Add(meshData);
+			}
+			return allocated;
+		});
+	}
+}
+
+FCGMeshDataPools::~FCGMeshDataPools()
+{
+	// Startup allocations still running hold pointers to the pools
+	CollectAllocations(true);
+}
+
+FString FCGMeshDataPools::GetLayoutKey(const FCGTerrainConfig& aConfig)
+{
+	// Tile size and each LOD's divisor decide the stream sizes, the rest decide which streams and pools are used at all
+	FString key = FString::Printf(TEXT("%dx%d"), aConfig.TileXUnits, aConfig.TileYUnits);
+	for (uint8 lod = 0; lod < aConfig.LODs.Num(); ++lod)
+	{
+		key += FString::Printf(TEXT("/%d"), FCGCoreAdapter::GetDivisor(aConfig, lod));
+	}
+	if (aConfig.IsCollisionOnly)
+	{
+		key += FString::Printf(TEXT("/Collision%d"), aConfig.Collision.LOD);
+	}
+	if (aConfig.GenerateSplatMap)
+	{
+		key += TEXT("/Splat");
+	}
+	return key;
+}
+
+/************************************************************************
+  Takes ownership of the mesh data from startup allocations that have
+		finished. Until a LOD's allocation is collected its pool is
+		left alone by the resizing
+************************************************************************/
+void FCGMeshDataPools::CollectAllocations(const bool aWait)
+{
+	for (uint8 lod = 0; lod < myAllocations.Num(); ++lod)
+	{
+		TFuture<TArray<FCGMeshData*>>& allocation = myAllocations[lod];
+		if (!allocation.IsValid() || (!aWait && !allocation.IsReady()))
+		{
+			continue;
+		}
+
+		for (FCGMeshData* meshData : allocation.Get())
+		{
+			myMeshData[lod].Data.Add(meshData);
+			myAllocatedBytes += meshData->GetAllocatedSize();
+		}
+		allocation = TFuture<TArray<FCGMeshData*>>();
+	}
+}
+
+void FCGMeshDataPools::AddMeshData(const uint8 aLOD)
+{
+	FCGMeshData* meshData = new FCGMeshData();
+	AllocateDataStructuresForLOD(meshData, myConfig, aLOD, myTopologies[aLOD]);
+
+	myMeshData[aLOD].Data.Add(meshData);
+	myAllocatedBytes += meshData->GetAllocatedSize();
+	myFreeMeshData[aLOD].Add(meshData);
+}
+
+/************************************************************************
+  Grows a LOD's pool while workers are kept waiting on it, up to the
+		LOD's limit, and gives grown slots back once it's been idle for
+		a while
+************************************************************************/
+void FCGMeshDataPools::Update(const float aElapsedSeconds, FCGMeshDataPoolTotals& aTotals)
+{
+	CollectAllocations(false);
+
+	for (uint8 lod = 0; lod < myFreeMeshData.Num(); ++lod)
+	{
+		TCGObjectPool<FCGMeshData>& pool = myFreeMeshData[lod];
+		const FCGObjectPoolStats stats = pool.ConsumeStats();
+		if (myAllocations[lod].IsValid())
+		{
+			continue;
+		}
+		aTotals.NumBorrows += stats.NumBorrows;
+		aTotals.WaitSeconds += stats.WaitSeconds;
+
+		const int32 minSize = myMinSizes[lod];
+		const int32 maxSize = FMath::Max<int32>(myConfig.LODs[lod].MaxMeshDataPoolSize, minSize);
+		const double averageWaitMs = stats.NumBorrows > 0 ? stats.WaitSeconds * 1000.0 / stats.NumBorrows : 0.0;
+
+		if (stats.NumWaits > 0 && averageWaitMs >= myConfig.MeshDataPoolGrowWaitMs && pool.Num() < maxSize && minSize > 0)
+		{
+			// One more slot for each borrow that had to wait
+			const int32 numToAdd = FMath::Min(stats.NumWaits, maxSize - pool.Num());
+			for (int32 i = 0; i < numToAdd; ++i)
+			{
+				AddMeshData(lod);
+			}
+			INC_DWORD_STAT_BY(STAT_MeshDataPoolGrowths, numToAdd);
+			myIdleTimes[lod] = 0.0f;
+		}
+		else if (stats.NumWaits == 0 && pool.Num() > minSize && pool.NumFree() > 0)
+		{
+			myIdleTimes[lod] += aElapsedSeconds;
+			if (myIdleTimes[lod] >= myConfig.MeshDataPoolShrinkDelay)
+			{
+				if (FCGMeshData* meshData = pool.Remove())
+				{
+					myAllocatedBytes -= meshData->GetAllocatedSize();
+					for (int32 i = 0; i < myMeshData[lod].Data.Num(); ++i)
+					{
+						if (&myMeshData[lod].Data[i] == meshData)
+						{
+							myMeshData[lod].Data.RemoveAt(i);
+							break;
+						}
+					}
+					INC_DWORD_STAT(STAT_MeshDataPoolShrinks);
+				}
+				myIdleTimes[lod] = 0.0f;
+			}
+		}
+		else
+		{
+			myIdleTimes[lod] = 0.0f;
+		}
+
+		aTotals.NumSlots += pool.Num();
+		aTotals.NumBorrowed += pool.Num() - pool.NumFree();
+	}
+}
+
+void FCGMeshDataPools::ReportStats(const FCGMeshDataPoolTotals& aTotals)
+{
+	SET_FLOAT_STAT(STAT_MeshDataBorrowWaitMs, aTotals.NumBorrows > 0 ? aTotals.WaitSeconds * 1000.0 / aTotals.NumBorrows : 0.0);
+	SET_FLOAT_STAT(STAT_MeshDataPoolOccupancy, aTotals.NumSlots > 0 ? (float)aTotals.NumBorrowed / aTotals.NumSlots : 0.0f);
+	SET_DWORD_STAT(STAT_MeshDataPoolSlots, aTotals.NumSlots);
+}
+
+/************************************************************************
+  Grid and skirt triangles in vertex cache friendly order, and the
+		vertex order that goes with them. Tens of milliseconds for the
+		biggest tiles, which is why it's done once per LOD
+************************************************************************/
+void FCGMeshDataPools::BuildTopology(FLODTopology& aTopology, const FCGTerrainConfig& aConfig, const uint8 aLOD)
+{
+	const CashGenCore::TileLayout tileLayout = FCGCoreAdapter::GetTileLayout(aConfig, aLOD);
+
+	aTopology.Triangles.SetNumUninitialized(tileLayout.NumIndices);
+	aTopology.VertexOrder.SetNumUninitialized(tileLayout.NumVertices);
+	CashGenCore::BuildOptimizedTileIndices(tileLayout, aTopology.Triangles.GetData(), aTopology.VertexOrder.GetData());
+}
+
+/************************************************************************
+  Allocates all the data structures for a single LOD mesh data
+		Includes setting up triangles etc.
+************************************************************************/
+void FCGMeshDataPools::AllocateDataStructuresForLOD(FCGMeshData* aData, const FCGTerrainConfig& aConfig, const uint8 aLOD, const FLODTopology& aTopology)
+{
+	const CashGenCore::TileLayout tileLayout = FCGCoreAdapter::GetTileLayout(aConfig, aLOD);
+
+	// Collision only needs positions and triangles, leave the render streams empty
+	const bool isRenderData = !aConfig.IsCollisionOnly;
+
+	FCGMeshDataLayout layout;
+	layout.NumVertices = tileLayout.NumVertices;
+	layout.NumRenderVertices = isRenderData ? tileLayout.NumVertices : 0;
+	layout.NumIndices = tileLayout.NumIndices;
+	layout.NumHeights = tileLayout.NumHeights;
+	layout.NumTexels = aConfig.GenerateSplatMap ? aConfig.TileXUnits * aConfig.TileYUnits : 0;
+
+	// One zeroed block for every stream, the triangles and UVs are written straight into it below
+	aData->Allocate(layout);
+
+	// Workers only write tangents for the grid, the skirts keep the default
+	const FProcMeshTangent defaultTangent;
+	for (FProcMeshTangent& tangent : aData->MyTangents)
+	{
+		tangent = defaultTangent;
+	}
+
+	// Triangles, vertex order and UVs never change, the workers only write the vertex streams
+	FMemory::Memcpy(aData->MyTriangles.GetData(), aTopology.Triangles.GetData(), aTopology.Triangles.Num() * sizeof(int32));
+	FMemory::Memcpy(aData->MyVertexOrder.GetData(), aTopology.VertexOrder.GetData(), aTopology.VertexOrder.Num() * sizeof(int32));
+	if (isRenderData)
+	{
+		CashGenCore::BuildGridUVs(tileLayout, FCGCoreAdapter::ToCore(aData->MyUV0));
+	}
+}
@@ -0,0 +1,138 @@
+#include "CashGen/Public/CGSectorStencil.h"
+
+FCGSectorStencil::FCGSectorStencil()
+	: myRadius(0)
+	, myGridSize(0)
+{
+}
+
+void FCGSectorStencil::Build(const TArray<FCGLODConfig>& aLODs)
+{
+	if (aLODs.Num() < 1)
+	{
+		Reset(-1);
+		return;
+	}
+
+	Reset(aLODs[aLODs.Num() - 1].SectorRadius);
+
+	for (int32 y = -myRadius; y <= myRadius; ++y)
+	{
+		for (int32 x = -myRadius; x <= myRadius; ++x)
+		{
+			// Always include the sector the pawn is in
+			AddCell(x, y, (x == 0 && y == 0) ? 0 : GetLODForRange(aLODs, x * x + y * y));
+		}
+	}
+
+	Finish();
+}
+
+void FCGSectorStencil::BuildDisc(const int32 aRadius, const uint8 aLOD)
+{
+	if (aRadius <= 0)
+	{
+		Reset(-1);
+		return;
+	}
+
+	Reset(aRadius);
+
+	// Unlike the LOD rings, the edge of a collision radius is inclusive
+	for (int32 y = -myRadius; y <= myRadius; ++y)
+	{
+		for (int32 x = -myRadius; x <= myRadius; ++x)
+		{
+			AddCell(x, y, x * x + y * y <= myRadius * myRadius ? aLOD : -1);
+		}
+	}
+
+	Finish();
+}
+
+void FCGSectorStencil::Reset(const int32 aRadius)
+{
+	myCells.Reset();
+	myLODGrid.Reset();
+	for (FCGSectorStencilDelta& delta : myUnitDeltas)
+	{
+		delta.Entering.Reset();
+		delta.Leaving.Reset();
+	}
+
+	// A negative radius leaves the stencil empty
+	myRadius = FMath::Max(aRadius, 0);
+	myGridSize = aRadius < 0 ? 0 : myRadius * 2 + 1;
+	myLODGrid.Init(-1, myGridSize * myGridSize);
+}
+
+void FCGSectorStencil::AddCell(const int32 aX, const int32 aY, const int32 aLOD)
+{
+	if (aLOD > -1)
+	{
+		myLODGrid[(aX + myRadius) + (aY + myRadius) * myGridSize] = aLOD;
+		myCells.Add(FCGSector(aX, aY, aLOD));
+	}
+}
+
+void FCGSectorStencil::Finish()
+{
+	// Nearest first, so anything queued from the stencil goes out closest to the actor first
+	myCells.StableSort([](const FCGSector& A, const FCGSector& B) {
+		return (A.mySector.X * A.mySector.X + A.mySector.Y * A.mySector.Y) < (B.mySector.X * B.mySector.X + B.mySector.Y * B.mySector.Y);
+	});
+
+	for (int32 y = -1; y <= 1; ++y)
+	{
+		for (int32 x = -1; x <= 1; ++x)
+		{
+			ComputeDelta(FIntVector2(x, y), myUnitDeltas[(x + 1) + (y + 1) * 3]);
+		}
+	}
+}
+
+const FCGSectorStencilDelta& FCGSectorStencil::GetDelta(const FIntVector2& aMove, FCGSectorStencilDelta& aScratch) const
+{
+	if (FMath::Abs(aMove.X) <= 1 && FMath::Abs(aMove.Y) <= 1)
+	{
+		return myUnitDeltas[(aMove.X + 1) + (aMove.Y + 1) * 3];
+	}
+
+	// Teleports and the like, compare the two footprints directly
+	aScratch.Entering.Reset();
+	aScratch.Leaving.Reset();
+	ComputeDelta(aMove, aScratch);
+	return aScratch;
+}
+
+void FCGSectorStencil::ComputeDelta(const FIntVector2& aMove, FCGSectorStencilDelta& aOutDelta) const
+{
+	for (const FCGSector& cell : myCells)
+	{
+		// The same sector, relative to where the actor was
+		if (GetLODAtOffset(cell.mySector.X + aMove.X, cell.mySector.Y + aMove.Y) != cell.myLOD)
+		{
+			aOutDelta.Entering.Add(cell);
+		}
+
+		// And relative to where the actor is now
+		if (GetLODAtOffset(cell.mySector.X - aMove.X, cell.mySector.Y - aMove.Y) < 0)
+		{
+			aOutDelta.Leaving.Add(cell.mySector);
+		}
+	}
+}
+
+int32 FCGSectorStencil::GetLODForRange(const TArray<FCGLODConfig>& aLODs, const int32 aRange) const
+{
+	int lowestLOD = 999;
+	for (int i = aLODs.Num() - 1; i >= 0; i--)
+	{
+		if (aRange < (aLODs[i].SectorRadius * aLODs[i].SectorRadius) && lowestLOD > i)
+		{
+			lowestLOD = i;
+		}
+	}
+
+	return lowestLOD != 999 ? lowestLOD : -1;
+}
@@ -1,434 +1,365 @@
-#include "CashGen/Public/CGTerrainGeneratorWorker.h"
-#include "CashGen/Public/CGTile.h"
-
-#include <ProceduralMeshComponent/Public/ProceduralMeshComponent.h>
-
-#include <chrono>
-
-DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ HeightMap"), STAT_HeightMap, STATGROUP_CashGenStat);
-DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ Normals"), STAT_Normals, STATGROUP_CashGenStat);
-DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ Erosion"), STAT_Erosion, STATGROUP_CashGenStat);
-
-FCGTerrainGeneratorWorker::FCGTerrainGeneratorWorker(ACGTerrainManager& aTerrainManager, FCGTerrainConfig& aTerrainConfig, TArray<TCGObjectPool<FCGMeshData>>& meshDataPoolPerLOD) 
-	: pTerrainManager(aTerrainManager)
-	, pTerrainConfig(aTerrainConfig)
-	, pMeshDataPoolsPerLOD(meshDataPoolPerLOD)
-{
-}
-
-FCGTerrainGeneratorWorker::~FCGTerrainGeneratorWorker()
-{
-}
-
-bool FCGTerrainGeneratorWorker::Init()
-{
-	IsThreadFinished = false;
-	return true;
-}
-
-uint32 FCGTerrainGeneratorWorker::Run()
-{
-	// Here's the loop
-	while (!IsThreadFinished)
-	{
-		if (pTerrainManager.myPendingJobQueue.Dequeue(workJob))
-		{
-			workLOD = workJob.LOD;
-
-			try
-			{
-				workJob.Data = pMeshDataPoolsPerLOD[workLOD].Borrow([&] { return !IsThreadFinished; });
-			}
-			catch (const std::exception&)
-			{
-				if (IsThreadFinished)
-				{
-					// seems borrowing aborted because IsThreadFinished got true. Let's just return
-					return 1;
-				}
-				// and in any other case, rethrow
-				throw;
-			}
-
-			pMeshData = workJob.Data.Get();
-
-			std::chrono::milliseconds startMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-				std::chrono::system_clock::now().time_since_epoch());
-
-			prepMaps();
-			ProcessTerrainMap();
-
-			workJob.HeightmapGenerationDuration = (std::chrono::duration_cast<std::chrono::milliseconds>(
-													   std::chrono::system_clock::now().time_since_epoch()) -
-												   startMs)
-													  .count();
-
-			ProcessPerBlockGeometry();
-			ProcessPerVertexTasks();
-			ProcessSkirtGeometry();
-
-			pTerrainManager.myUpdateJobQueue.Enqueue(workJob);
-		}
-		// Otherwise, take a nap
-		else
-		{
-			FPlatformProcess::Sleep(0.01f);
-		}
-	}
-
-	return 1;
-}
-
-void FCGTerrainGeneratorWorker::Stop()
-{
-	IsThreadFinished = true;
-}
-
-void FCGTerrainGeneratorWorker::Exit()
-{
-}
-
-void FCGTerrainGeneratorWorker::prepMaps()
-{
-	// TODO : VERTEX COLORS
-	for (int32 i = 0; i < pMeshData->MyColours.Num(); ++i)
-	{
-		pMeshData->MyColours[i].R = 0;
-		pMeshData->MyColours[i].G = 0;
-		pMeshData->MyColours[i].B = 0;
-		pMeshData->MyColours[i].A = 0;
-	}
-}
-
-void FCGTerrainGeneratorWorker::ProcessTerrainMap()
-{
-	SCOPE_CYCLE_COUNTER(STAT_HeightMap);
-	// Size of the noise sampling (larger than the actual mesh so we can have seamless normals)
-	int32 exX = GetNumberOfNoiseSamplePoints();
-	int32 exY = exX;
-
-	const int32 XYunits = workLOD == 0 ? pTerrainConfig.TileXUnits : pTerrainConfig.TileXUnits / pTerrainConfig.LODs[workLOD].ResolutionDivisor;
-	const int32 exUnitSize = workLOD == 0 ? pTerrainConfig.UnitSize : pTerrainConfig.UnitSize * pTerrainConfig.LODs[workLOD].ResolutionDivisor;
-
-	UObject* WorldInterfaceObject = pTerrainConfig.WorldHeightInterface.GetObject();
-	// Calculate the new noisemap
-	for (int y = 0; y < exY; ++y)
-	{
-		for (int x = 0; x < exX; ++x)
-		{
-			int32 worldX = (((workJob.mySector.X * XYunits) + x) * exUnitSize) - exUnitSize;
-			int32 worldY = (((workJob.mySector.Y * XYunits) + y) * exUnitSize) - exUnitSize;
-
-			pMeshData->HeightMap[x + (exX * y)] = IWorldHeightInterface::Execute_GetHeightAtPoint(WorldInterfaceObject, worldX, worldY);
-		}
-	}
-	// Put heightmap into Red channel
-
-	if (pTerrainConfig.GenerateSplatMap && workLOD == 0)
-	{
-		int i = 0;
-		for (int y = 0; y < pTerrainConfig.TileYUnits; ++y)
-		{
-			for (int x = 0; x < pTerrainConfig.TileXUnits; ++x)
-			{
-				float& noiseValue = pMeshData->HeightMap[(x + 1) + (exX * (y + 1))];
-
-				pMeshData->myTextureData[i].R = (uint8)FMath::GetMappedRangeValueClamped(FVector2D(0.0f, 1.0f), FVector2D(0.0f, 255.0f), noiseValue);
-
-				pMeshData->myTextureData[i].G = (uint8)FMath::GetMappedRangeValueClamped(FVector2D(-1.0f, 0.0f), FVector2D(0.0f, 255.0f), noiseValue);
-
-				pMeshData->myTextureData[i].B = i;
-
-				pMeshData->myTextureData[i].A = 0;
-
-				i++;
-			}
-		}
-	}
-
-	// Then put the biome map into the Green vertex colour channel
-	/*
-	if (pTerrainConfig.BiomeBlendGenerator)
-	{
-		exX -= 2;
-		exY -= 2;
-		for (int y = 0; y < exY; ++y)
-		{
-			for (int x = 0; x < exX; ++x)
-			{
-				int32 worldX = (((workJob.mySector.X * (exX - 1)) + x) * exUnitSize);
-				int32 worldY = (((workJob.mySector.Y * (exX - 1)) + y) * exUnitSize);
-				float val = pTerrainConfig.BiomeBlendGenerator->GetNoise2D(worldX, worldY);
-
-				pMeshData->MyColours[x + (exX * y)].G = FMath::Clamp(FMath::RoundToInt(((val + 1.0f) / 2.0f) * 256), 0, 255);
-			}
-		}
-	}
-	*/
-}
-
-void FCGTerrainGeneratorWorker::ProcessPerBlockGeometry()
-{
-	int32 vertCounter = 0;
-	int32 triCounter = 0;
-
-	int32 xUnits = workLOD == 0 ? pTerrainConfig.TileXUnits : (pTerrainConfig.TileXUnits / pTerrainConfig.LODs[workLOD].ResolutionDivisor);
-	int32 yUnits = workLOD == 0 ? pTerrainConfig.TileYUnits : (pTerrainConfig.TileYUnits / pTerrainConfig.LODs[workLOD].ResolutionDivisor);
-
-	// Generate the mesh data for each block
-	for (int32 y = 0; y < yUnits; ++y)
-	{
-		for (int32 x = 0; x < xUnits; ++x)
-		{
-			UpdateOneBlockGeometry(x, y, vertCounter, triCounter);
-		}
-	}
-}
-
-void FCGTerrainGeneratorWorker::ProcessPerVertexTasks()
-{
-	SCOPE_CYCLE_COUNTER(STAT_Normals);
-	int32 xUnits = workLOD == 0 ? pTerrainConfig.TileXUnits : (pTerrainConfig.TileXUnits / pTerrainConfig.LODs[workLOD].ResolutionDivisor);
-	int32 yUnits = workLOD == 0 ? pTerrainConfig.TileYUnits : (pTerrainConfig.TileYUnits / pTerrainConfig.LODs[workLOD].ResolutionDivisor);
-
-	int32 rowLength = workLOD == 0 ? pTerrainConfig.TileXUnits + 1 : (pTerrainConfig.TileXUnits / (pTerrainConfig.LODs[workLOD].ResolutionDivisor) + 1);
-
-	for (int32 y = 0; y < yUnits + 1; ++y)
-	{
-		for (int32 x = 0; x < xUnits + 1; ++x)
-		{
-			FVector normal;
-			FProcMeshTangent tangent(0.0f, 1.0f, 0.f);
-
-			GetNormalFromHeightMapForVertex(x, y, normal);
-
-			uint8 slopeChan = FMath::RoundToInt((1.0f - FMath::Abs(FVector::DotProduct(normal, FVector::UpVector))) * 256);
-			pMeshData->MyColours[x + (y * rowLength)].R = slopeChan;
-			pMeshData->MyNormals[x + (y * rowLength)] = normal;
-			pMeshData->MyTangents[x + (y * rowLength)] = tangent;
-		}
-	}
-}
-
-// Generates the 'skirt' geometry that falls down from the edges of each tile
-void FCGTerrainGeneratorWorker::ProcessSkirtGeometry()
-{
-	// Going to do this the simple way, keep code easy to understand!
-
-	int32 numXVerts = workLOD == 0 ? pTerrainConfig.TileXUnits + 1 : (pTerrainConfig.TileXUnits / pTerrainConfig.LODs[workLOD].ResolutionDivisor) + 1;
-	int32 numYVerts = workLOD == 0 ? pTerrainConfig.TileYUnits + 1 : (pTerrainConfig.TileYUnits / pTerrainConfig.LODs[workLOD].ResolutionDivisor) + 1;
-
-	int32 startIndex = numXVerts * numYVerts;
-	int32 triStartIndex = ((numXVerts - 1) * (numYVerts - 1) * 6);
-
-	// Bottom Edge verts
-	for (int i = 0; i < numXVerts; ++i)
-	{
-		pMeshData->MyPositions[startIndex + i].X = pMeshData->MyPositions[i].X;
-		pMeshData->MyPositions[startIndex + i].Y = pMeshData->MyPositions[i].Y;
-		pMeshData->MyPositions[startIndex + i].Z = -30000.0f;
-
-		pMeshData->MyNormals[startIndex + i] = pMeshData->MyNormals[i];
-	}
-	// bottom edge triangles
-	for (int i = 0; i < ((numXVerts - 1)); ++i)
-	{
-		pMeshData->MyTriangles[triStartIndex + (i * 6)] = i;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 1] = startIndex + i + 1;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 2] = startIndex + i;
-
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 3] = i + 1;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 4] = startIndex + i + 1;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 5] = i;
-	}
-	triStartIndex += ((numXVerts - 1) * 6);
-
-	startIndex = ((numXVerts) * (numYVerts + 1));
-	// Top Edge verts
-	for (int i = 0; i < numXVerts; ++i)
-	{
-		pMeshData->MyPositions[startIndex + i].X = pMeshData->MyPositions[i + startIndex - (numXVerts * 2)].X;
-		pMeshData->MyPositions[startIndex + i].Y = pMeshData->MyPositions[i + startIndex - (numXVerts * 2)].Y;
-		pMeshData->MyPositions[startIndex + i].Z = -30000.0f;
-
-		pMeshData->MyNormals[startIndex + i] = pMeshData->MyNormals[i + startIndex - (numXVerts * 2)];
-	}
-	// top edge triangles
-
-	for (int i = 0; i < ((numXVerts - 1)); ++i)
-	{
-		pMeshData->MyTriangles[triStartIndex + (i * 6)] = i + startIndex - (numXVerts * 2);
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 1] = startIndex + i;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 2] = i + startIndex - (numXVerts * 2) + 1;
-
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 3] = i + startIndex - (numXVerts * 2) + 1;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 4] = startIndex + i;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 5] = startIndex + i + 1;
-	}
-	triStartIndex += ((numXVerts - 1) * 6);
-
-	startIndex = numXVerts * (numYVerts + 2);
-	// Right edge - bit different
-	for (int i = 0; i < numYVerts - 2; ++i)
-	{
-		pMeshData->MyPositions[startIndex + i].X = pMeshData->MyPositions[(i + 1) * numXVerts].X;
-		pMeshData->MyPositions[startIndex + i].Y = pMeshData->MyPositions[(i + 1) * numXVerts].Y;
-		pMeshData->MyPositions[startIndex + i].Z = -30000.0f;
-
-		pMeshData->MyNormals[startIndex + i] = pMeshData->MyNormals[(i + 1) * numXVerts];
-	}
-	// Bottom right corner
-
-	pMeshData->MyTriangles[triStartIndex] = 0;
-	pMeshData->MyTriangles[triStartIndex + 1] = numXVerts * numYVerts;
-	pMeshData->MyTriangles[triStartIndex + 2] = numXVerts;
-
-	pMeshData->MyTriangles[triStartIndex + 3] = numXVerts;
-	pMeshData->MyTriangles[triStartIndex + 4] = numXVerts * numYVerts;
-	pMeshData->MyTriangles[triStartIndex + 5] = numXVerts * (numYVerts + 2);
-
-	// Top right corner
-	triStartIndex += 6;
-
-	pMeshData->MyTriangles[triStartIndex] = numXVerts * (numYVerts - 1);
-	pMeshData->MyTriangles[triStartIndex + 1] = (numXVerts * (numYVerts + 2)) + numYVerts - 3;
-	pMeshData->MyTriangles[triStartIndex + 2] = numXVerts * (numYVerts + 1);
-
-	pMeshData->MyTriangles[triStartIndex + 3] = numXVerts * (numYVerts - 1);
-	pMeshData->MyTriangles[triStartIndex + 4] = numXVerts * (numYVerts - 2);
-	pMeshData->MyTriangles[triStartIndex + 5] = (numXVerts * (numYVerts + 2)) + numYVerts - 3;
-
-	// Middle right part!
-	startIndex = numXVerts * (numYVerts + 2);
-	triStartIndex += 6;
-
-	for (int i = 0; i < numYVerts - 3; ++i)
-	{
-		pMeshData->MyTriangles[triStartIndex + (i * 6)] = numXVerts * (i + 1);
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 1] = startIndex + i;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 2] = numXVerts * (i + 2);
-
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 3] = numXVerts * (i + 2);
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 4] = startIndex + i;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 5] = startIndex + i + 1;
-	}
-	triStartIndex += ((numYVerts - 3) * 6);
-
-	startIndex += (numYVerts - 2);
-	// Left edge - bit different
-	for (int i = 0; i < numYVerts - 2; ++i)
-	{
-		pMeshData->MyPositions[startIndex + i].X = pMeshData->MyPositions[((i + 1) * numXVerts) + numXVerts - 1].X;
-		pMeshData->MyPositions[startIndex + i].Y = pMeshData->MyPositions[((i + 1) * numXVerts) + numXVerts - 1].Y;
-		pMeshData->MyPositions[startIndex + i].Z = -30000.0f;
-
-		pMeshData->MyNormals[startIndex + i] = pMeshData->MyNormals[((i + 1) * numXVerts) + numXVerts - 1];
-	}
-	// Bottom left corner
-
-	pMeshData->MyTriangles[triStartIndex] = numXVerts - 1;
-	pMeshData->MyTriangles[triStartIndex + 1] = (numXVerts * 2) - 1;
-	pMeshData->MyTriangles[triStartIndex + 2] = startIndex;
-
-	pMeshData->MyTriangles[triStartIndex + 3] = startIndex;
-	pMeshData->MyTriangles[triStartIndex + 4] = (numXVerts * numYVerts) + numXVerts - 1;
-	pMeshData->MyTriangles[triStartIndex + 5] = numXVerts - 1;
-
-	// Top left corner
-	triStartIndex += 6;
-
-	pMeshData->MyTriangles[triStartIndex] = (numXVerts * numYVerts) - 1;
-	pMeshData->MyTriangles[triStartIndex + 1] = (numXVerts * (numYVerts + 2)) - 1;
-	pMeshData->MyTriangles[triStartIndex + 2] = (numXVerts * (numYVerts + 2)) + ((numYVerts - 2) * 2) - 1;
-
-	pMeshData->MyTriangles[triStartIndex + 3] = (numXVerts * numYVerts) - 1;
-	pMeshData->MyTriangles[triStartIndex + 4] = (numXVerts * (numYVerts + 2)) + ((numYVerts - 2) * 2) - 1;
-	pMeshData->MyTriangles[triStartIndex + 5] = (numXVerts * (numYVerts - 2)) + numXVerts - 1;
-
-	// Middle left part!
-
-	triStartIndex += 6;
-
-	for (int i = 0; i < numYVerts - 3; ++i)
-	{
-		pMeshData->MyTriangles[triStartIndex + (i * 6)] = (numXVerts * (i + 1)) + numXVerts - 1;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 1] = (numXVerts * (i + 2)) + numXVerts - 1;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 2] = startIndex + i + 1;
-
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 3] = (numXVerts * (i + 1)) + numXVerts - 1;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 4] = startIndex + i + 1;
-		pMeshData->MyTriangles[triStartIndex + (i * 6) + 5] = startIndex + i;
-	}
-}
-
-void FCGTerrainGeneratorWorker::GetNormalFromHeightMapForVertex(const int32& vertexX, const int32& vertexY, FVector& aOutNormal) //, FVector& aOutTangent)
-{
-	FVector result;
-
-	FVector tangentVec, bitangentVec;
-
-	const int32 rowLength = workLOD == 0 ? pTerrainConfig.TileXUnits + 1 : (pTerrainConfig.TileXUnits / (pTerrainConfig.LODs[workLOD].ResolutionDivisor) + 1);
-	const int32 heightMapRowLength = rowLength + 2;
-
-	// the heightmapIndex for this vertex index
-	const int32 heightMapIndex = vertexX + 1 + ((vertexY + 1) * heightMapRowLength);
-	const float worldTileX = workJob.mySector.X * pTerrainConfig.TileXUnits;
-	const float worldTileY = workJob.mySector.Y * pTerrainConfig.TileYUnits;
-	const float& unitSize = workLOD == 0 ? pTerrainConfig.UnitSize : pTerrainConfig.UnitSize * pTerrainConfig.LODs[workLOD].ResolutionDivisor;
-	const float& ampl = pTerrainConfig.Amplitude;
-
-	FVector origin = FVector((worldTileX + vertexX) * unitSize, (worldTileY + vertexY) * unitSize, pMeshData->HeightMap[heightMapIndex] * ampl);
-
-	// Get the 4 neighbouring points
-	FVector up, down, left, right;
-
-	up = FVector((worldTileX + vertexX) * unitSize, (worldTileY + vertexY + 1) * unitSize, pMeshData->HeightMap[heightMapIndex + heightMapRowLength] * ampl) - origin;
-	down = FVector((worldTileX + vertexX) * unitSize, (worldTileY + vertexY - 1) * unitSize, pMeshData->HeightMap[heightMapIndex - heightMapRowLength] * ampl) - origin;
-	left = FVector((worldTileX + vertexX + 1) * unitSize, (worldTileY + vertexY) * unitSize, pMeshData->HeightMap[heightMapIndex + 1] * ampl) - origin;
-	right = FVector((worldTileX + vertexX - 1) * unitSize, (worldTileY + vertexY) * unitSize, pMeshData->HeightMap[heightMapIndex - 1] * ampl) - origin;
-
-	FVector n1, n2, n3, n4;
-
-	n1 = FVector::CrossProduct(left, up);
-	n2 = FVector::CrossProduct(up, right);
-	n3 = FVector::CrossProduct(right, down);
-	n4 = FVector::CrossProduct(down, left);
-
-	result = n1 + n2 + n3 + n4;
-
-	aOutNormal = result.GetSafeNormal();
-}
-
-void FCGTerrainGeneratorWorker::UpdateOneBlockGeometry(const int32& aX, const int32& aY, int32& aVertCounter, int32& triCounter)
-{
-	int32 thisX = aX;
-	int32 thisY = aY;
-	int32 heightMapX = thisX + 1;
-	int32 heightMapY = thisY + 1;
-	// LOD adjusted dimensions
-	int32 rowLength = workLOD == 0 ? pTerrainConfig.TileXUnits + 1 : (pTerrainConfig.TileXUnits / (pTerrainConfig.LODs[workLOD].ResolutionDivisor) + 1);
-	int32 heightMapRowLength = rowLength + 2;
-	// LOD adjusted unit size
-	int32 exUnitSize = workLOD == 0 ? pTerrainConfig.UnitSize : pTerrainConfig.UnitSize * (pTerrainConfig.LODs[workLOD].ResolutionDivisor);
-
-	const int blockX = 0;
-	const int blockY = 0;
-	const float& unitSize = pTerrainConfig.UnitSize;
-	const float& ampl = pTerrainConfig.Amplitude;
-
-	FVector heightMapToWorldOffset = FVector(0.0f, 0.0f, 0.0f);
-
-	// TL
-	pMeshData->MyPositions[thisX + (thisY * rowLength)] = FVector((blockX + thisX) * exUnitSize, (blockY + thisY) * exUnitSize, pMeshData->HeightMap[heightMapX + (heightMapY * heightMapRowLength)] * ampl) - heightMapToWorldOffset;
-	// TR
-	pMeshData->MyPositions[thisX + ((thisY + 1) * rowLength)] = FVector((blockX + thisX) * exUnitSize, (blockY + thisY + 1) * exUnitSize, pMeshData->HeightMap[heightMapX + ((heightMapY + 1) * heightMapRowLength)] * ampl) - heightMapToWorldOffset;
-	// BL
-	pMeshData->MyPositions[(thisX + 1) + (thisY * rowLength)] = FVector((blockX + thisX + 1) * exUnitSize, (blockY + thisY) * exUnitSize, pMeshData->HeightMap[(heightMapX + 1) + (heightMapY * heightMapRowLength)] * ampl) - heightMapToWorldOffset;
-	// BR
-	pMeshData->MyPositions[(thisX + 1) + ((thisY + 1) * rowLength)] = FVector((blockX + thisX + 1) * exUnitSize, (blockY + thisY + 1) * exUnitSize, pMeshData->HeightMap[(heightMapX + 1) + ((heightMapY + 1) * heightMapRowLength)] * ampl) - heightMapToWorldOffset;
-}
-
-int32 FCGTerrainGeneratorWorker::GetNumberOfNoiseSamplePoints()
-{
-	return workLOD == 0 ? pTerrainConfig.TileXUnits + 3 : (pTerrainConfig.TileXUnits / (pTerrainConfig.LODs[workLOD].ResolutionDivisor)) + 3;
-}
+#include "CashGen/Public/CGTerrainGeneratorWorker.h"
+#include "CashGen/Public/CGCoreAdapter.h"
+#include "CashGen/Public/CGTile.h"
+
+#include <ProceduralMeshComponent/Public/ProceduralMeshComponent.h>
+#include <Runtime/Core/Public/Math/RandomStream.h>
+
+DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ HeightMap"), STAT_HeightMap, STATGROUP_CashGenStat);
+DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ Normals"), STAT_Normals, STATGROUP_CashGenStat);
+DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ Erosion"), STAT_Erosion, STATGROUP_CashGenStat);
+
+FCGTerrainGeneratorWorker::FCGTerrainGeneratorWorker(UCGGenerationSubsystem& aSubsystem)
+	: pSubsystem(aSubsystem)
+	, pTerrainManager(nullptr)
+	, pTerrainConfig(nullptr)
+	, pMeshDataPools(nullptr)
+	, workKernels(nullptr)
+{
+}
+
+FCGTerrainGeneratorWorker::~FCGTerrainGeneratorWorker()
+{
+}
+
+bool FCGTerrainGeneratorWorker::Init()
+{
+	IsThreadFinished = false;
+	return true;
+}
+
+uint32 FCGTerrainGeneratorWorker::Run()
+{
+	// Here's the loop
+	while (!IsThreadFinished)
+	{
+		// Managers take turns, and prefetch jobs only get a look in once every actor's actual needs are met
+		FCGGenerationClientPtr client = pSubsystem.DequeueJob(workJob);
+		if (client.IsValid())
+		{
+			// Don't bother generating anything the game thread no longer wants, but hand it back so the manager stops counting it
+			if (workJob.IsCancelled())
+			{
+				client->myManager->myUpdateJobQueue.Enqueue(workJob);
+				client->myManager->myUpdateJobQueueDepth.Increment();
+				pSubsystem.FinishJob(*client);
+				continue;
+			}
+
+			pTerrainManager = client->myManager;
+			pTerrainConfig = &pTerrainManager->myTerrainConfig;
+			pMeshDataPools = client->myMeshDataPools.Get();
+
+			workLOD = workJob.LOD;
+			workLayout = FCGCoreAdapter::GetTileLayout(*pTerrainConfig, workLOD);
+			workKernels = &CashGenCore::GetTileKernels(workLayout);
+			uint64 stageStart = workJob.Timings.EndStage(ECGJobStage::QueueWait, workJob.Timings.myQueuedCycles);
+
+			try
+			{
+				workJob.Data = pMeshDataPools->GetPool(workLOD).Borrow([&] { return !IsThreadFinished && client->myIsRegistered; });
+			}
+			catch (const std::exception&)
+			{
+				pSubsystem.FinishJob(*client);
+				if (IsThreadFinished)
+				{
+					// seems borrowing aborted because IsThreadFinished got true. Let's just return
+					return 1;
+				}
+				if (!client->myIsRegistered)
+				{
+					// The manager is going away, and is waiting on us to let go of it
+					continue;
+				}
+				// and in any other case, rethrow
+				throw;
+			}
+
+			pMeshData = workJob.Data.Get();
+			stageStart = workJob.Timings.EndStage(ECGJobStage::BorrowWait, stageStart);
+
+			prepMaps();
+			if (workJob.IsDowngrade && CanSubsampleHeightField())
+			{
+				ProcessSubsampledTerrainMap();
+			}
+			else
+			{
+				ProcessTerrainMap();
+			}
+
+			if (!workJob.IsCollisionJob)
+			{
+				ProcessCurvature();
+			}
+			CaptureHeightField();
+
+			stageStart = workJob.Timings.EndStage(ECGJobStage::Sampling, stageStart);
+
+			ProcessPerBlockGeometry();
+			stageStart = workJob.Timings.EndStage(ECGJobStage::Geometry, stageStart);
+			// Collision only needs positions and triangles
+			if (!workJob.IsCollisionJob)
+			{
+				ProcessPerVertexTasks();
+				stageStart = workJob.Timings.EndStage(ECGJobStage::Normals, stageStart);
+			}
+			ProcessSkirtGeometry();
+			stageStart = workJob.Timings.EndStage(ECGJobStage::Skirts, stageStart);
+
+			if (!workJob.IsCollisionJob && pTerrainConfig->ScatterRules.Num() > 0)
+			{
+				ProcessScatter();
+				stageStart = workJob.Timings.EndStage(ECGJobStage::Scatter, stageStart);
+			}
+			workJob.Timings.myQueuedCycles = stageStart;
+
+			pTerrainManager->myWorkerBusyCycles.Add(workJob.Timings.GetStageCycles(ECGJobStage::Sampling) + workJob.Timings.GetStageCycles(ECGJobStage::Geometry) +
+				workJob.Timings.GetStageCycles(ECGJobStage::Normals) + workJob.Timings.GetStageCycles(ECGJobStage::Skirts) + workJob.Timings.GetStageCycles(ECGJobStage::Scatter));
+			pTerrainManager->myUpdateJobQueue.Enqueue(workJob);
+			pTerrainManager->myUpdateJobQueueDepth.Increment();
+			pSubsystem.FinishJob(*client);
+		}
+		// Otherwise, take a nap
+		else
+		{
+			FPlatformProcess::Sleep(0.01f);
+		}
+	}
+
+	return 1;
+}
+
+void FCGTerrainGeneratorWorker::Stop()
+{
+	IsThreadFinished = true;
+}
+
+void FCGTerrainGeneratorWorker::Exit()
+{
+}
+
+void FCGTerrainGeneratorWorker::prepMaps()
+{
+	// TODO : VERTEX COLORS
+	for (int32 i = 0; i < pMeshData->MyColours.Num(); ++i)
+	{
+		pMeshData->MyColours[i].R = 0;
+		pMeshData->MyColours[i].G = 0;
+		pMeshData->MyColours[i].B = 0;
+		pMeshData->MyColours[i].A = 0;
+	}
+}
+
+void FCGTerrainGeneratorWorker::ProcessTerrainMap()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HeightMap);
+	// The heightmap is larger than the actual mesh so we can have seamless normals
+	const int32 exX = workLayout.HeightMapRowLength;
+
+	UObject* WorldInterfaceObject = pTerrainConfig->WorldHeightInterface.GetObject();
+	CashGenCore::SampleHeights(workLayout, workJob.mySector.X, workJob.mySector.Y, GetSampleSpacing(),
+		[WorldInterfaceObject](const int32 aWorldX, const int32 aWorldY) { return IWorldHeightInterface::Execute_GetHeightAtPoint(WorldInterfaceObject, aWorldX, aWorldY); },
+		pMeshData->HeightMap.GetData());
+	// Put heightmap into Red channel
+
+	if (pTerrainConfig->GenerateSplatMap && workLOD == 0 && !workJob.IsCollisionJob)
+	{
+		int i = 0;
+		for (int y = 0; y < pTerrainConfig->TileYUnits; ++y)
+		{
+			for (int x = 0; x < pTerrainConfig->TileXUnits; ++x)
+			{
+				float& noiseValue = pMeshData->HeightMap[(x + 1) + (exX * (y + 1))];
+
+				pMeshData->myTextureData[i].R = (uint8)FMath::GetMappedRangeValueClamped(FVector2D(0.0f, 1.0f), FVector2D(0.0f, 255.0f), noiseValue);
+
+				pMeshData->myTextureData[i].G = (uint8)FMath::GetMappedRangeValueClamped(FVector2D(-1.0f, 0.0f), FVector2D(0.0f, 255.0f), noiseValue);
+
+				pMeshData->myTextureData[i].B = i;
+
+				pMeshData->myTextureData[i].A = 0;
+
+				i++;
+			}
+		}
+	}
+
+	// Then put the biome map into the Green vertex colour channel
+	/*
+	if (pTerrainConfig->BiomeBlendGenerator)
+	{
+		exX -= 2;
+		exY -= 2;
+		for (int y = 0; y < exY; ++y)
+		{
+			for (int x = 0; x < exX; ++x)
+			{
+				int32 worldX = (((workJob.mySector.X * (exX - 1)) + x) * exUnitSize);
+				int32 worldY = (((workJob.mySector.Y * (exX - 1)) + y) * exUnitSize);
+				float val = pTerrainConfig->BiomeBlendGenerator->GetNoise2D(worldX, worldY);
+
+				pMeshData->MyColours[x + (exX * y)].G = FMath::Clamp(FMath::RoundToInt(((val + 1.0f) / 2.0f) * 256), 0, 255);
+			}
+		}
+	}
+	*/
+}
+
+/************************************************************************
+  A downgrade can reuse the tile's heights if they're finer and the
+		coarse sample spacing is a whole multiple of theirs
+************************************************************************/
+bool FCGTerrainGeneratorWorker::CanSubsampleHeightField() const
+{
+	const FCGHeightField* heightField = workJob.myTileHandle.myHeightField.Get();
+	if (!heightField || heightField->myLOD >= workLOD)
+	{
+		return false;
+	}
+
+	const int32 sourceDivisor = heightField->myLOD == 0 ? 1 : pTerrainConfig->LODs[heightField->myLOD].ResolutionDivisor;
+	const int32 targetDivisor = pTerrainConfig->LODs[workLOD].ResolutionDivisor;
+	return sourceDivisor > 0 && targetDivisor % sourceDivisor == 0;
+}
+
+/************************************************************************
+  Fills the heightmap for a downgrade from the finer height field.
+		Only the border ring lies outside the finer tile's samples, so
+		only that goes through the height interface
+************************************************************************/
+void FCGTerrainGeneratorWorker::ProcessSubsampledTerrainMap()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HeightMap);
+	const FCGHeightField& heightField = *workJob.myTileHandle.myHeightField;
+	const int32 ratio = FCGCoreAdapter::GetDivisor(*pTerrainConfig, workLOD) / FCGCoreAdapter::GetDivisor(*pTerrainConfig, heightField.myLOD);
+
+	UObject* WorldInterfaceObject = pTerrainConfig->WorldHeightInterface.GetObject();
+	CashGenCore::SubsampleHeights(workLayout, workJob.mySector.X, workJob.mySector.Y, GetSampleSpacing(),
+		heightField.myHeights.GetData(), heightField.mySize, ratio,
+		[WorldInterfaceObject](const int32 aWorldX, const int32 aWorldY) { return IWorldHeightInterface::Execute_GetHeightAtPoint(WorldInterfaceObject, aWorldX, aWorldY); },
+		pMeshData->HeightMap.GetData());
+}
+
+/************************************************************************
+  Hands a copy of the heights back with the job, for ground queries
+		and so the tile can be downgraded later without resampling.
+		A downgrade's field only replaces the finer one once nothing
+		else needs that. Collision jobs only have one to give when
+		they're all the tile gets
+************************************************************************/
+void FCGTerrainGeneratorWorker::CaptureHeightField()
+{
+	if (workJob.IsCollisionJob && !pTerrainConfig->IsCollisionOnly)
+	{
+		return;
+	}
+
+	TSharedRef<FCGHeightField, ESPMode::ThreadSafe> heightField = MakeShared<FCGHeightField, ESPMode::ThreadSafe>();
+	heightField->myLOD = workLOD;
+	heightField->mySize = workLayout.HeightMapRowLength;
+	heightField->myHeights.Append(pMeshData->HeightMap.GetData(), pMeshData->HeightMap.Num());
+	workJob.HeightField = heightField;
+}
+
+/************************************************************************
+  RMS of the heightmap's second differences, scaled back to unit
+		spacing. Interpolating over a span of d units is then off by
+		roughly curvature * d^2 / 8, which is what LOD selection uses
+************************************************************************/
+void FCGTerrainGeneratorWorker::ProcessCurvature()
+{
+	const float divisor = FCGCoreAdapter::GetDivisor(*pTerrainConfig, workLOD);
+	workJob.Curvature = workKernels->MeasureCurvature(workLayout, pMeshData->HeightMap.GetData()) * pTerrainConfig->Amplitude / (divisor * divisor);
+}
+
+void FCGTerrainGeneratorWorker::ProcessPerBlockGeometry()
+{
+	// Vertex positions have always been laid out on whole world units
+	workKernels->BuildPositions(workLayout, pMeshData->HeightMap.GetData(), (float)GetSampleSpacing(), pTerrainConfig->Amplitude, FCGCoreAdapter::ToCore(pMeshData->MyPositions));
+}
+
+void FCGTerrainGeneratorWorker::ProcessPerVertexTasks()
+{
+	SCOPE_CYCLE_COUNTER(STAT_Normals);
+	const float unitSize = pTerrainConfig->UnitSize * FCGCoreAdapter::GetDivisor(*pTerrainConfig, workLOD);
+	workKernels->BuildNormals(workLayout, pMeshData->HeightMap.GetData(), unitSize, pTerrainConfig->Amplitude,
+		FCGCoreAdapter::ToCore(pMeshData->MyNormals), FCGCoreAdapter::ToCore(pMeshData->MyTangents), FCGCoreAdapter::ToCore(pMeshData->MyColours));
+}
+
+// Generates the 'skirt' geometry that falls down from the edges of each tile
+void FCGTerrainGeneratorWorker::ProcessSkirtGeometry()
+{
+	// Collision only mesh data has no normals
+	CashGenCore::Vec3* normals = pMeshData->MyNormals.Num() > 0 ? FCGCoreAdapter::ToCore(pMeshData->MyNormals) : nullptr;
+	// The skirt triangles were built with the rest when the pool slot was allocated
+	CashGenCore::BuildSkirts(workLayout, FCGCoreAdapter::ToCore(pMeshData->MyPositions), normals, nullptr);
+}
+
+/************************************************************************
+  Places each rule's instances from a seed only the rule and sector
+		decide, so a tile gets the same instances whatever order it's
+		built in. Only their heights and tilt come from the LOD's heights
+************************************************************************/
+void FCGTerrainGeneratorWorker::ProcessScatter()
+{
+	const TArray<FCGScatterRule>& rules = pTerrainConfig->ScatterRules;
+	workJob.ScatterInstances.SetNum(rules.Num());
+
+	const float tileSizeX = pTerrainConfig->TileXUnits * pTerrainConfig->UnitSize;
+	const float tileSizeY = pTerrainConfig->TileYUnits * pTerrainConfig->UnitSize;
+	const float invSpacing = 1.0f / GetSampleSpacing();
+	const float gradientScale = pTerrainConfig->Amplitude * invSpacing;
+	const int32 rowLength = workLayout.HeightMapRowLength;
+	const int32 numRows = workLayout.NumHeights / rowLength;
+	const float* heights = pMeshData->HeightMap.GetData();
+
+	for (int32 ruleIndex = 0; ruleIndex < rules.Num(); ++ruleIndex)
+	{
+		const FCGScatterRule& rule = rules[ruleIndex];
+		TArray<FTransform>& instances = workJob.ScatterInstances[ruleIndex];
+		instances.Reset();
+
+		// Too coarse for this rule, the empty array clears whatever the tile had
+		if (!rule.Mesh || workLOD > rule.MaxLOD)
+		{
+			continue;
+		}
+
+		FRandomStream random((int32)HashCombine(HashCombine(GetTypeHash(pTerrainConfig->ScatterSeed), GetTypeHash(rule.Seed)), GetTypeHash(workJob.mySector)));
+		instances.Reserve(rule.InstancesPerTile);
+
+		for (int32 i = 0; i < rule.InstancesPerTile; ++i)
+		{
+			// Every candidate draws the same numbers whether it's kept or not, so rejections don't shift the rest
+			const float x = random.FRand() * tileSizeX;
+			const float y = random.FRand() * tileSizeY;
+			const float yaw = random.FRand() * 360.0f;
+			const float scale = FMath::Lerp(rule.MinScale, rule.MaxScale, random.FRand());
+
+			float gradientX;
+			float gradientY;
+			const float height = CashGenCore::SampleBilinear(heights, rowLength, numRows, x * invSpacing + 1.0f, y * invSpacing + 1.0f, gradientX, gradientY) * pTerrainConfig->Amplitude;
+			const FVector normal = FVector(-gradientX * gradientScale, -gradientY * gradientScale, 1.0f).GetSafeNormal();
+			const float slope = FMath::RadiansToDegrees(FMath::Acos(normal.Z));
+
+			if (height < rule.MinHeight || height > rule.MaxHeight || slope < rule.MinSlope || slope > rule.MaxSlope)
+			{
+				continue;
+			}
+
+			FQuat rotation(FVector::UpVector, FMath::DegreesToRadians(yaw));
+			if (rule.AlignToNormal)
+			{
+				rotation = FQuat::FindBetweenNormals(FVector::UpVector, normal) * rotation;
+			}
+			instances.Emplace(rotation, FVector(x, y, height + rule.ZOffset), FVector(scale));
+		}
+	}
+}
+
+int32 FCGTerrainGeneratorWorker::GetSampleSpacing() const
+{
+	return (int32)(pTerrainConfig->UnitSize * FCGCoreAdapter::GetDivisor(*pTerrainConfig, workLOD));
+}
@@ -1,16 +1,17 @@
 
 #include "CashGen/Public/CGTerrainManager.h"
-#include "CashGen/Public/CGTerrainGeneratorWorker.h"
+#include "CashGen/Public/CGCoreAdapter.h"
+#include "CashGen/Public/CGGenerationSubsystem.h"
+#include "CashGen/Public/CGLatencyStats.h"
 #include "CashGen/Public/CGTile.h"
 #include "CashGen/Public/Struct/CGJob.h"
 #include "CashGen/Public/Struct/CGTileHandle.h"
 
-#include <chrono>
-
-using namespace std::chrono;
+#include <Runtime/Engine/Classes/Engine/Engine.h>
 
 DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ ActorSectorSweeps"), STAT_ActorSectorSweeps, STATGROUP_CashGenStat);
 DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ SectorExpirySweeps"), STAT_SectorExpirySweeps, STATGROUP_CashGenStat);
+DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ MemoryGovernor"), STAT_MemoryGovernor, STATGROUP_CashGenStat);
 
 ACGTerrainManager::ACGTerrainManager()
 {
@@ -27,28 +28,18 @@ ACGTerrainManager::~ACGTerrainManager()
 void ACGTerrainManager::BeginPlay()
 {
 	Super::BeginPlay();
-
-	FString threadName = "TerrainWorkerThread";
-
-	for (int i = 0; i < myTerrainConfig.NumberOfThreads; i++)
-	{
-		myWorkerThreads.Add(FRunnableThread::Create(new FCGTerrainGeneratorWorker(*this, myTerrainConfig, myFreeMeshData),
-			*threadName,
-			0, EThreadPriority::TPri_Normal, FPlatformAffinity::GetNoAffinityMask()));
-	}
 }
 
 void ACGTerrainManager::BeginDestroy()
 {
-	for (auto& thread : myWorkerThreads)
+	// Workers are done with this manager once it's unregistered
+	if (UCGGenerationSubsystem* generationSubsystem = GetGenerationSubsystem())
 	{
-		if (thread != nullptr)
-		{
-			thread->Kill();
-			delete thread;
-			thread = nullptr;
-		}
+		generationSubsystem->UnregisterManager(this);
 	}
+	myMeshDataPools.Reset();
+
+	myHeightFieldRegistry.Reset();
 
 	Super::BeginDestroy();
 }
@@ -56,480 +47,1491 @@ void ACGTerrainManager::BeginDestroy()
 void ACGTerrainManager::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
+	const uint64 tickStartCycles = FPlatformTime::Cycles64();
 
 	myTimeSinceLastSweep += DeltaSeconds;
+	myFrameTime = FPlatformTime::Seconds();
 
-	// Make sure there's no daft number of threads. Unlikely you'll want more than one anyway.
-	if (myTerrainConfig.NumberOfThreads > FPlatformMisc::NumberOfCores())
+	if (myTilesToPrewarm > 0)
 	{
-		myTerrainConfig.NumberOfThreads = FPlatformMisc::NumberOfCores();
+		PrewarmTiles();
 	}
 
-	// Now check for Update jobs
-	for (uint8 i = 0; i < myTerrainConfig.MeshUpdatesPerFrame; i++)
+	// Now check for Update jobs. Cancelled ones cost nothing, so they don't count against the per frame limit
+	int32 numUpdates = 0;
+	FCGJob updateJob;
+	while (numUpdates < myTerrainConfig.MeshUpdatesPerFrame && myUpdateJobQueue.Dequeue(updateJob))
 	{
-		FCGJob updateJob;
-		if (myUpdateJobQueue.Dequeue(updateJob))
+		myUpdateJobQueueDepth.Decrement();
+		uint64 stageStart = updateJob.Timings.EndStage(ECGJobStage::UpdateWait, updateJob.Timings.myQueuedCycles);
+		FinishQueuedJob(updateJob.mySector);
+
+		if (updateJob.IsCancelled())
 		{
-			milliseconds startMs = duration_cast<milliseconds>(
-				system_clock::now().time_since_epoch());
+			updateJob.Data.Release();
+			continue;
+		}
+		numUpdates++;
 
-			updateJob.myTileHandle.myHandle->UpdateMesh(updateJob.LOD,
-				updateJob.IsInPlaceUpdate,
-				updateJob.Data->MyPositions,
-				updateJob.Data->MyNormals,
-				updateJob.Data->MyTangents,
-				updateJob.Data->MyUV0,
-				updateJob.Data->MyColours,
-				updateJob.Data->MyTriangles,
-				updateJob.Data->myTextureData);
+		// A prefetch that made it this far is just a normal tile now
+		if (updateJob.IsPrefetch)
+		{
+			myPrefetchedSectors.Remove(updateJob.mySector);
+		}
 
-			if (myTerrainConfig.UseInstancedWaterMesh)
+		if (updateJob.IsCollisionJob)
+		{
+			updateJob.myTileHandle.myHandle->UpdateCollisionMesh(*updateJob.Data.Get());
+			updateJob.Timings.EndStage(ECGJobStage::CollisionCook, stageStart);
+			FCGLatencyStats::Get().AddJob(updateJob.mySector, updateJob.LOD, true, updateJob.Timings);
+			updateJob.Data.Release();
+			myNumCompletedJobs++;
+			// Collision is all a collision only tile has, so it's done once that's in
+			if (myTerrainConfig.IsCollisionOnly)
 			{
-				FTransform waterTransform = FTransform(FRotator(0.0f), updateJob.myTileHandle.myHandle->GetActorLocation() + FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * 0.5f, myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * 0.5f, 0.0f), FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * 0.01f, myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * 0.01f, 1.0f));
-				MyWaterMeshComponent->UpdateInstanceTransform(updateJob.myTileHandle.myWaterISMIndex, waterTransform, true, true, true);
+				SetTileStatus(updateJob.mySector, updateJob.myTileHandle.mySpawnId, ETileStatus::IDLE);
+				FCGTileHandle* tileHandle = myTileHandleMap.Find(updateJob.mySector);
+				if (tileHandle && tileHandle->mySpawnId == updateJob.myTileHandle.mySpawnId && updateJob.HeightField.IsValid())
+				{
+					tileHandle->myHeightField = updateJob.HeightField;
+					myHeightFieldRegistry.Set(updateJob.mySector, updateJob.HeightField);
+				}
 			}
+			continue;
+		}
 
-			updateJob.myTileHandle.myHandle->SetActorHiddenInGame(false);
-			int32 updateMS = (duration_cast<milliseconds>(
-								  system_clock::now().time_since_epoch()) -
-							  startMs)
-								 .count();
-
-#ifdef UE_BUILD_DEBUG
-			if (Settings && Settings->ShowTimings && updateJob.LOD == 0)
+		// The tile was released, respawned or moved to another LOD while this was in flight, don't let it overwrite the newer state
+		{
+			const FCGTileHandle* tileHandle = myTileHandleMap.Find(updateJob.mySector);
+			if (!tileHandle || tileHandle->mySpawnId != updateJob.myTileHandle.mySpawnId || tileHandle->myLOD != updateJob.LOD)
 			{
-				GEngine->AddOnScreenDebugMessage(0, 5.f, FColor::Red, TEXT("Heightmap gen " + FString::FromInt(updateJob.HeightmapGenerationDuration) + "ms"));
-				GEngine->AddOnScreenDebugMessage(1, 5.f, FColor::Red, TEXT("Erosion gen " + FString::FromInt(updateJob.ErosionGenerationDuration) + "ms"));
-				GEngine->AddOnScreenDebugMessage(2, 5.f, FColor::Red, TEXT("MeshUpdate " + FString::FromInt(updateMS) + "ms"));
+				updateJob.Data.Release();
+				continue;
 			}
-#endif
-
-			updateJob.Data.Release();
-			OnAfterTileCreated(updateJob.myTileHandle.myHandle);
-			myQueuedSectors.Remove(updateJob.mySector);
 		}
-	}
 
-	if (myActorIndex >= myTrackedActors.Num())
-	{
-		myActorIndex = FMath::Min(0, myTrackedActors.Num() - 1);
-	}
+		updateJob.myTileHandle.myHandle->UpdateMesh(updateJob.LOD,
+			updateJob.IsInPlaceUpdate,
+			*updateJob.Data.Get());
 
-	// Time based sweep of actors to see if any have moved sectors
-	if (myTimeSinceLastSweep > myTerrainConfig.TileSweepTime && myTrackedActors.Num() > 0)
-	{
-		SCOPE_CYCLE_COUNTER(STAT_ActorSectorSweeps);
+		// Placed by the worker, all that's left here is handing each rule's batch to its instanced mesh
+		if (updateJob.ScatterInstances.Num() > 0)
+		{
+			updateJob.myTileHandle.myHandle->UpdateScatter(updateJob.ScatterInstances);
+		}
 
-		// Compare current location to previous
-		FIntVector2 oldSector = myActorLocationMap[myTrackedActors[myActorIndex]];
-		FIntVector2 newSector = GetSector(myTrackedActors[myActorIndex]->GetActorLocation());
-		if (oldSector != newSector)
+		if (myTerrainConfig.UseInstancedWaterMesh)
 		{
-			// Take care of spawning new sectors if necessary
-			SetActorSector(myTrackedActors[myActorIndex], newSector);
+			FTransform waterTransform = FTransform(FRotator(0.0f), updateJob.myTileHandle.myHandle->GetActorLocation() + FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * 0.5f, myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * 0.5f, 0.0f), FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * 0.01f, myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * 0.01f, 1.0f));
+			MyWaterMeshComponent->UpdateInstanceTransform(updateJob.myTileHandle.myWaterISMIndex, waterTransform, true, true, true);
+		}
 
-			ProcessTilesForActor(myTrackedActors[myActorIndex]);
+		updateJob.myTileHandle.myHandle->SetActorHiddenInGame(false);
+
+		// The coarse section is showing, so the finer ones and their collision can go
+		if (updateJob.IsDowngrade)
+		{
+			for (uint8 lod = 0; lod < updateJob.LOD; ++lod)
+			{
+				updateJob.myTileHandle.myHandle->ReleaseLOD(lod);
+			}
 		}
-		else
+
+		bool isFading = false;
+		if (myTerrainConfig.DitheringLODTransitions && myTerrainConfig.TransitionMode == ECGLODTransitionMode::CustomPrimitiveData)
 		{
-			for (FCGSector& sector : GetRelevantSectorsForActor(myTrackedActors[myActorIndex]))
+			// Written once, the material does the rest. Only the hide at the end comes back to the game thread
+			const float worldTime = GetWorld()->GetTimeSeconds();
+			ACGTile* tile = updateJob.myTileHandle.myHandle;
+			if (tile->StartFade(worldTime))
 			{
-				if (myTileHandleMap.Contains(sector.mySector))
-				{
-					myTileHandleMap[sector.mySector].myLastRequiredTimestamp = FDateTime::Now();
-				}
+				myLODFades.Add(FCGLODFade(tile, tile->GetPreviousLOD(), worldTime + myTerrainConfig.TransitionDuration));
+				isFading = true;
 			}
 		}
+		// Only tiles with dynamic material instances have anything to fade
+		else if (myTerrainConfig.DitheringLODTransitions && myTerrainConfig.MakeDynamicMaterialInstance && myTerrainConfig.TerrainMaterialInstance)
+		{
+			myTransitioningTiles.AddUnique(updateJob.myTileHandle.myHandle);
+			isFading = true;
+		}
+		SetTileStatus(updateJob.mySector, updateJob.myTileHandle.mySpawnId, isFading ? ETileStatus::TRANSITION : ETileStatus::IDLE);
+		myNumCompletedJobs++;
+		updateJob.Timings.EndStage(ECGJobStage::Upload, stageStart);
+		FCGLatencyStats::Get().AddJob(updateJob.mySector, updateJob.LOD, false, updateJob.Timings);
 
-		if (myActorIndex < myTrackedActors.Num() - 1)
+#if !UE_BUILD_SHIPPING
+		if (Settings && Settings->ShowTimings && updateJob.LOD == 0)
 		{
-			myActorIndex++;
+			const double toMs = 1000.0;
+			GEngine->AddOnScreenDebugMessage(0, 5.f, FColor::Red, FString::Printf(TEXT("Heightmap gen %.2fms"), updateJob.Timings.GetStageSeconds(ECGJobStage::Sampling) * toMs));
+			GEngine->AddOnScreenDebugMessage(1, 5.f, FColor::Red, FString::Printf(TEXT("Geometry gen %.2fms"), (updateJob.Timings.GetStageSeconds(ECGJobStage::Geometry) + updateJob.Timings.GetStageSeconds(ECGJobStage::Normals) + updateJob.Timings.GetStageSeconds(ECGJobStage::Skirts)) * toMs));
+			GEngine->AddOnScreenDebugMessage(2, 5.f, FColor::Red, FString::Printf(TEXT("MeshUpdate %.2fms"), updateJob.Timings.GetStageSeconds(ECGJobStage::Upload) * toMs));
 		}
-		else
+#endif
+
+		updateJob.Data.Release();
+		OnAfterTileCreated(updateJob.myTileHandle.myHandle);
+
+		FCGTileHandle* tileHandle = myTileHandleMap.Find(updateJob.mySector);
+		if (tileHandle && tileHandle->mySpawnId == updateJob.myTileHandle.mySpawnId)
 		{
-			myActorIndex = 0;
-			myTimeSinceLastSweep = 0.0f;
+			tileHandle->myCurvature = updateJob.Curvature;
+			// A downgrade keeps the finer field while a later downgrade can still subsample it and not its own
+			const bool isKeepingFinerField = updateJob.IsDowngrade && tileHandle->myHeightField.IsValid() && IsHeightFieldNeededForDowngrades(*tileHandle->myHeightField, updateJob.LOD);
+			if (updateJob.HeightField.IsValid() && !isKeepingFinerField)
+			{
+				tileHandle->myHeightField = updateJob.HeightField;
+				myHeightFieldRegistry.Set(updateJob.mySector, updateJob.HeightField);
+			}
+
+			// Rough tiles can need more detail than the ring they're in gave them
+			if (IsScreenSpaceErrorLOD() && SelectScreenSpaceErrorLOD(updateJob.mySector, tileHandle->myLOD, tileHandle->myCurvature) < tileHandle->myLOD)
+			{
+				RequireSector(FCGSector(updateJob.mySector, tileHandle->myLOD));
+			}
 		}
 	}
 
-	// TODO: this sucks, don't wanna be iterating over a big map like this
-	// But the cost is negligible compared to the mesh updates/collision cooking we're doing sooooooo
-	// Better than all the tiles ticking themselves
+	// Time based sweep of actors to see if any have moved sectors
+	if (myTimeSinceLastSweep > myTerrainConfig.TileSweepTime && myTrackedActors.Num() > 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ActorSectorSweeps);
+
+		SweepActorSectors();
+
+		for (AActor* actor : myTrackedActors)
+		{
+			PrefetchSectorsForActor(actor);
+		}
+
+		UpdateMemoryBudget();
 
-	TArray<FIntVector2> TilesToDelete;
+		myTimeSinceLastSweep = 0.0f;
+	}
 
 	{
 		SCOPE_CYCLE_COUNTER(STAT_SectorExpirySweeps);
 
-		for (auto& elem : myTileHandleMap)
+		// Only tiles whose expiry time has come up get looked at, everything else stays in the heap
+		const double releaseDelay = myTerrainConfig.TileReleaseDelay.GetTotalSeconds();
+		while (myTileExpiryHeap.Num() > 0 && myTileExpiryHeap.HeapTop().myExpiryTime <= myFrameTime)
 		{
-			// The tile hasn't been required  free it
-			if (elem.Value.myLastRequiredTimestamp + myTerrainConfig.TileReleaseDelay < FDateTime::Now())
+			FCGTileExpiry expiry;
+			myTileExpiryHeap.HeapPop(expiry, false);
+
+			FCGTileHandle* tileHandle = myTileHandleMap.Find(expiry.mySector);
+			// The tile was already released, or the sector has been respawned since this entry was pushed
+			if (!tileHandle || tileHandle->mySpawnId != expiry.mySpawnId)
+			{
+				continue;
+			}
+
+			// Still inside an actor's footprint, check again after another delay
+			if (myInterestMap.IsCovered(expiry.mySector))
 			{
-				FreeTile(elem.Value.myHandle, elem.Value.myWaterISMIndex);
-				TilesToDelete.Push(elem.Key);
+				tileHandle->myLastRequiredTimestamp = myFrameTime;
+				expiry.myExpiryTime = myFrameTime + FMath::Max(releaseDelay, 1.0);
+				myTileExpiryHeap.HeapPush(expiry);
+				continue;
 			}
-			else if (myTerrainConfig.DitheringLODTransitions)
+
+			// The tile was required again since, so push it back with its real expiry time
+			expiry.myExpiryTime = tileHandle->myLastRequiredTimestamp + releaseDelay;
+			if (expiry.myExpiryTime > myFrameTime)
+			{
+				myTileExpiryHeap.HeapPush(expiry);
+				continue;
+			}
+
+			// The tile hasn't been required  free it
+			ReleaseSector(expiry.mySector);
+		}
+	}
+
+	// Fades all last the same time, so the list is already in hide time order
+	if (myLODFades.Num() > 0)
+	{
+		const float worldTime = GetWorld()->GetTimeSeconds();
+		int32 numFinished = 0;
+		while (numFinished < myLODFades.Num() && myLODFades[numFinished].myHideTime <= worldTime)
+		{
+			if (ACGTile* tile = myLODFades[numFinished].myTile.Get())
 			{
-				elem.Value.myHandle->TickTransition(DeltaSeconds);
+				tile->FinishFade(myLODFades[numFinished].myLOD);
+				FinishTileTransition(tile);
 			}
+			numFinished++;
 		}
+		myLODFades.RemoveAt(0, numFinished, false);
+	}
 
-		for (auto& key : TilesToDelete)
+	if (myTerrainConfig.DitheringLODTransitions)
+	{
+		for (int32 i = myTransitioningTiles.Num() - 1; i >= 0; --i)
 		{
-			myTileHandleMap.Remove(key);
+			if (myTransitioningTiles[i]->TickTransition(DeltaSeconds))
+			{
+				FinishTileTransition(myTransitioningTiles[i]);
+				myTransitioningTiles.RemoveAtSwap(i, 1, false);
+			}
 		}
 	}
+
+	if (IsProgressiveRefinement())
+	{
+		IssueRefinements();
+	}
+
 	if (!myIsTerrainComplete &&
 		myTrackedActors.Num() > 0 &&
 		myPendingJobQueue.IsEmpty() &&
-		myUpdateJobQueue.IsEmpty())
+		myUpdateJobQueue.IsEmpty() &&
+		myRefinements.Num() == 0)
 	{
 		BroadcastTerrainComplete();
 		myIsTerrainComplete = true;
 	}
+
+	if (!myIsNearTerrainReady && myTrackedActors.Num() > 0 && IsNearTerrainReady())
+	{
+		BroadcastNearTerrainReady();
+		myIsNearTerrainReady = true;
+	}
+
+	myHeightFieldRegistry.Publish();
+
+	UpdateStats();
+
+	myLastTickSeconds = FPlatformTime::GetSecondsPerCycle64() * (FPlatformTime::Cycles64() - tickStartCycles);
 }
 
-TPair<ACGTile*, int32> ACGTerrainManager::GetAvailableTile()
+/************************************************************************
+  Publishes queue depths, free pool slots, tile states and throughput
+		to the CashGen stat group, for tuning threads and pool sizes
+************************************************************************/
+void ACGTerrainManager::UpdateStats()
 {
-	TPair<ACGTile*, int32> result;
-
-	if (myFreeTiles.Num())
+	// Throughput is averaged over a second so it doesn't flicker with MeshUpdatesPerFrame
+	const double jobRateWindow = myFrameTime - myJobRateStartTime;
+	if (jobRateWindow >= 1.0)
 	{
-		result.Key = myFreeTiles.Pop();
-		if (myTerrainConfig.UseInstancedWaterMesh)
-		{
-			result.Value = myFreeWaterMeshIndices.Pop();
-		}
+		myJobsPerSecond = myNumCompletedJobs / jobRateWindow;
+		myNumCompletedJobs = 0;
+		myJobRateStartTime = myFrameTime;
 	}
+}
 
-	if (!result.Key)
+void ACGTerrainManager::SetTileStatus(const FIntVector2& aSector, const uint32 aSpawnId, const ETileStatus aStatus)
+{
+	FCGTileHandle* tileHandle = myTileHandleMap.Find(aSector);
+	if (tileHandle && tileHandle->mySpawnId == aSpawnId)
 	{
-		result.Key = GetWorld()->SpawnActor<ACGTile>(ACGTile::StaticClass(), FVector(0.0f, 0.0f, -10000.0f), FRotator(0.0f));
-		if (myTerrainConfig.UseInstancedWaterMesh)
+		tileHandle->myStatus = aStatus;
+
+		// A coarse build landing is what makes its refinement ready to issue
+		if ((aStatus == ETileStatus::IDLE || aStatus == ETileStatus::TRANSITION) && myRefinements.Contains(aSector))
 		{
-			result.Value = MyWaterMeshComponent->AddInstance(FTransform(FRotator(0.0f), FVector(0.0f, 0.0f, -10000.0f), FVector::OneVector));
+			myAreRefinementCandidatesStale = true;
 		}
 	}
-
-	return result;
 }
 
-void ACGTerrainManager::FreeTile(ACGTile* aTile, const int32& waterMeshIndex)
+void ACGTerrainManager::FinishTileTransition(const ACGTile* aTile)
 {
-	if (myTerrainConfig.UseInstancedWaterMesh)
+	// A newer job may have been queued for the tile while it was fading
+	FCGTileHandle* tileHandle = myTileHandleMap.Find(aTile->GetSector());
+	if (tileHandle && tileHandle->myHandle == aTile && tileHandle->myStatus == ETileStatus::TRANSITION)
 	{
-		MyWaterMeshComponent->UpdateInstanceTransform(waterMeshIndex, FTransform(FRotator(0.0f), FVector(0.0f, 0.0f, -100000.0f), FVector(0.1f)), true, true, true);
-		myFreeWaterMeshIndices.Push(waterMeshIndex);
+		tileHandle->myStatus = ETileStatus::IDLE;
 	}
-	aTile->SetActorHiddenInGame(true);
-	myFreeTiles.Push(aTile);
 }
 
-void ACGTerrainManager::SetActorSector(const AActor* aActor, const FIntVector2& aNewSector)
+FCGTerrainStats ACGTerrainManager::GetStats() const
 {
-	myActorLocationMap[aActor] = aNewSector;
+	FCGTerrainStats stats;
+	stats.PendingJobs = myPendingJobQueue.Num();
+	stats.PrefetchJobs = myPrefetchJobQueue.Num();
+	stats.UpdateJobs = myUpdateJobQueueDepth.GetValue();
+	stats.QueuedSectors = myQueuedSectors.Num();
+	const UCGGenerationSubsystem* generationSubsystem = GetGenerationSubsystem();
+	stats.NumWorkerThreads = generationSubsystem ? generationSubsystem->GetNumWorkerThreads() : 0;
+	stats.WorkerBusyCycles = myWorkerBusyCycles.GetValue();
+	stats.TickSeconds = myLastTickSeconds;
+
+	int32 tileCounts[(uint8)ETileStatus::IDLE + 1] = { 0 };
+	myTileHandleMap.ForEach([&](const FIntVector2& aSector, const FCGTileHandle& aTileHandle) {
+		tileCounts[(uint8)aTileHandle.myStatus]++;
+	});
+	stats.TilesSpawned = tileCounts[(uint8)ETileStatus::SPAWNED];
+	stats.TilesRequested = tileCounts[(uint8)ETileStatus::REQUESTED];
+	stats.TilesTransition = tileCounts[(uint8)ETileStatus::TRANSITION];
+	stats.TilesIdle = tileCounts[(uint8)ETileStatus::IDLE];
+	stats.FreeTiles = myFreeTiles.Num();
+
+	stats.JobsPerSecond = myJobsPerSecond;
+	stats.SecondsSinceTerrainComplete = myIsTerrainComplete ? myFrameTime - myTerrainCompleteTime : 0.0;
+	stats.SectionBytes = myLastSectionBytes;
+	stats.CollisionBytes = myLastCollisionBytes;
+	stats.TextureBytes = myLastTextureBytes;
+	stats.HeightFieldBytes = myLastHeightFieldBytes;
+	return stats;
 }
 
-FIntVector2 ACGTerrainManager::GetSector(const FVector& aLocation)
+bool ACGTerrainManager::GetGroundInfo(const float aX, const float aY, FCGGroundInfo& aOutGroundInfo) const
 {
-	FIntVector2 sector;
-	;
-
-	sector.X = FMath::RoundToInt(aLocation.X / (myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize));
-	sector.Y = FMath::RoundToInt(aLocation.Y / (myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize));
-
-	return sector;
+	return myHeightFieldRegistry.GetGroundInfo(aX, aY, aOutGroundInfo);
 }
 
-TArray<FCGSector> ACGTerrainManager::GetRelevantSectorsForActor(const AActor* aActor)
+int32 ACGTerrainManager::GetGroundInfoBatch(TArrayView<const FVector2D> aPositions, TArrayView<float> aOutHeights, TArrayView<FVector> aOutNormals, TArrayView<bool> aOutResolved, const bool aUseHeightProvider) const
 {
-	TArray<FCGSector> result;
-
-	FIntVector2 rootSector = GetSector(aActor->GetActorLocation());
+	int32 numResolved = myHeightFieldRegistry.GetGroundInfoBatch(aPositions, aOutHeights, aOutNormals, aOutResolved);
 
-	if (myTerrainConfig.LODs.Num() < 1)
+	UObject* worldInterfaceObject = myTerrainConfig.WorldHeightInterface.GetObject();
+	if (!aUseHeightProvider || numResolved == aPositions.Num() || !worldInterfaceObject)
 	{
-		return result;
+		return numResolved;
 	}
 
-	// Always include the sector the pawn is in
-	result.Add(rootSector);
+	// Heights come back in the same units the workers sample in, tile origins are offset by half a tile
+	const float unitSize = myTerrainConfig.UnitSize;
+	auto getHeight = [&](const float aX, const float aY) {
+		return IWorldHeightInterface::Execute_GetHeightAtPoint(worldInterfaceObject, aX + myTerrainConfig.TileOffset.X, aY + myTerrainConfig.TileOffset.Y) * myTerrainConfig.Amplitude;
+	};
 
-	const int sweepRange = myTerrainConfig.LODs[myTerrainConfig.LODs.Num() - 1].SectorRadius;
-	const int sweepRange2 = sweepRange * 2;
-
-	for (int x = 0; x < sweepRange2; x++)
+	for (int32 i = 0; i < aPositions.Num(); ++i)
 	{
-		for (int y = 0; y < sweepRange2; y++)
+		if (aOutResolved[i])
 		{
-			FCGSector newSector = FCGSector(rootSector.X - sweepRange + x, rootSector.Y - sweepRange + y, 0);
-			FIntVector2 diff = newSector.mySector - rootSector;
-			int thisRange = (diff.X * diff.X + diff.Y * diff.Y);
-			int lod = GetLODForRange(thisRange);
-			if (newSector != rootSector && lod > -1)
-			{
-				newSector.myLOD = lod;
-				result.Add(newSector);
-			}
+			continue;
 		}
+
+		// One unit forward differences off the centre sample, the same span the resident heightmaps' bilinear gradient covers
+		const FVector2D& position = aPositions[i];
+		const float height = getHeight(position.X, position.Y);
+		const float gradientX = (getHeight(position.X + unitSize, position.Y) - height) / unitSize;
+		const float gradientY = (getHeight(position.X, position.Y + unitSize) - height) / unitSize;
+		aOutHeights[i] = height;
+		aOutNormals[i] = FVector(-gradientX, -gradientY, 1.0f).GetSafeNormal();
+		aOutResolved[i] = true;
+		numResolved++;
 	}
 
-	return result;
+	return numResolved;
 }
 
-int ACGTerrainManager::GetLODForRange(const int32 aRange)
+bool ACGTerrainManager::IsSectorReady(const FIntVector2& aSector) const
 {
-	int lowestLOD = 999;
-	for (int i = myTerrainConfig.LODs.Num() - 1; i >= 0; i--)
+	// Statuses are only ever set by jobs from the handle's own spawn, so a tile recycled from another sector can't pass for this one
+	const FCGTileHandle* tileHandle = myTileHandleMap.Find(aSector);
+	if (!tileHandle || !tileHandle->myHandle || myRefinements.Contains(aSector) ||
+		(tileHandle->myStatus != ETileStatus::IDLE && tileHandle->myStatus != ETileStatus::TRANSITION))
 	{
-		if (aRange < (myTerrainConfig.LODs[i].SectorRadius * myTerrainConfig.LODs[i].SectorRadius) && lowestLOD > i)
-		{
-			lowestLOD = i;
-		}
+		return false;
 	}
-
-	return lowestLOD != 999 ? lowestLOD : -1;
+	return tileHandle->myHandle->GetCurrentLOD() == tileHandle->myLOD && tileHandle->myHandle->GetLODStatus(tileHandle->myLOD) != ELODStatus::NOT_CREATED;
 }
 
-void ACGTerrainManager::SetupTerrainGenerator(TScriptInterface<IWorldHeightInterface> worldHeightInterface)
+bool ACGTerrainManager::IsNearTerrainReady() const
 {
-	myTerrainConfig.WorldHeightInterface = worldHeightInterface;
-
-	myTerrainConfig.TileOffset = FVector(myTerrainConfig.UnitSize * myTerrainConfig.TileXUnits * 0.5f, myTerrainConfig.UnitSize * myTerrainConfig.TileYUnits * 0.5f, 0.0f);
+	for (const auto& elem : myActorLocationMap)
+	{
+		const int32 radius = FMath::Max(GetCollisionConfig(elem.Key).SectorRadius, 0);
 
-	AllocateAllMeshDataStructures();
+		for (int32 x = -radius; x <= radius; x++)
+		{
+			for (int32 y = -radius; y <= radius; y++)
+			{
+				if (x * x + y * y > radius * radius)
+				{
+					continue;
+				}
 
-	isReady = true;
+				const FIntVector2 sector(elem.Value.X + x, elem.Value.Y + y);
+				const FCGTileHandle* tileHandle = myTileHandleMap.Find(sector);
+				if (!tileHandle)
+				{
+					return false;
+				}
+				// Decoupled collision comes from its own jobs, whatever the tile is showing
+				if (myTerrainConfig.DecoupledCollision && radius > 0 && tileHandle->myHandle->GetCollisionBytes() == 0)
+				{
+					return false;
+				}
+				if (!myTerrainConfig.IsCollisionOnly && !IsSectorReady(sector))
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
 }
 
-void ACGTerrainManager::AddActorToTrack(AActor* aPawn)
+TPair<ACGTile*, int32> ACGTerrainManager::GetAvailableTile()
 {
-	if (!aPawn)
+	TPair<ACGTile*, int32> result;
+
+	if (myFreeTiles.Num())
 	{
-		return;
+		result.Key = myFreeTiles.Pop();
+	}
+	else
+	{
+		result.Key = GetWorld()->SpawnActor<ACGTile>(ACGTile::StaticClass(), FVector(0.0f, 0.0f, -10000.0f), FRotator(0.0f));
 	}
 
-	myTrackedActors.Add(aPawn);
-	FIntVector2 pawnSector = GetSector(aPawn->GetActorLocation());
-	myActorLocationMap.Add(aPawn, pawnSector);
+	// Water instances outlive tiles the memory governor destroys, so they're pooled separately
+	if (myTerrainConfig.UseInstancedWaterMesh)
+	{
+		if (myFreeWaterMeshIndices.Num())
+		{
+			result.Value = myFreeWaterMeshIndices.Pop();
+		}
+		else
+		{
+			result.Value = MyWaterMeshComponent->AddInstance(FTransform(FRotator(0.0f), FVector(0.0f, 0.0f, -10000.0f), FVector::OneVector));
+		}
+	}
 
-	ProcessTilesForActor(aPawn);
+	return result;
 }
 
-void ACGTerrainManager::RemoveActorToTrack(AActor* aPawn)
+/************************************************************************
+  Spawns a few tiles a frame, with all their components and a water
+		instance, straight onto the free list so GetAvailableTile doesn't
+		have to create them mid game
+************************************************************************/
+void ACGTerrainManager::PrewarmTiles()
 {
-	if (!aPawn)
+	const int32 numToSpawn = FMath::Min(myTilesToPrewarm, myTerrainConfig.PrewarmTilesPerFrame);
+	for (int32 i = 0; i < numToSpawn; ++i)
 	{
-		return;
-	}
+		ACGTile* tile = GetWorld()->SpawnActor<ACGTile>(ACGTile::StaticClass(), FVector(0.0f, 0.0f, -10000.0f), FRotator(0.0f));
+		tile->CreateComponents(&myTerrainConfig, FVector(0.f));
+
+		int32 waterMeshIndex = -1;
+		if (myTerrainConfig.UseInstancedWaterMesh)
+		{
+			waterMeshIndex = MyWaterMeshComponent->AddInstance(FTransform(FRotator(0.0f), FVector(0.0f, 0.0f, -10000.0f), FVector::OneVector));
+		}
 
-	myTrackedActors.Remove(aPawn);
+		FreeTile(tile, waterMeshIndex);
+	}
 
-	myActorLocationMap.Remove(aPawn);
+	myTilesToPrewarm -= numToSpawn;
 }
 
-void ACGTerrainManager::CreateTileRefreshJob(FCGJob aJob)
+void ACGTerrainManager::FreeTile(ACGTile* aTile, const int32& waterMeshIndex)
 {
-	if (aJob.LOD != 10)
+	if (myTerrainConfig.UseInstancedWaterMesh)
 	{
-		myQueuedSectors.Add(aJob.mySector);
-		myPendingJobQueue.Enqueue(std::move(aJob));
+		MyWaterMeshComponent->UpdateInstanceTransform(waterMeshIndex, FTransform(FRotator(0.0f), FVector(0.0f, 0.0f, -100000.0f), FVector(0.1f)), true, true, true);
+		myFreeWaterMeshIndices.Push(waterMeshIndex);
 	}
+	aTile->SetActorHiddenInGame(true);
+	aTile->ClearScatter();
+	myFreeTiles.Push(aTile);
 }
 
-void ACGTerrainManager::ProcessTilesForActor(const AActor* anActor)
+void ACGTerrainManager::SetActorSector(const AActor* aActor, const FIntVector2& aNewSector)
 {
-	for (FCGSector& sector : GetRelevantSectorsForActor(anActor))
-	{
-		bool isExistsAtLowerLOD = myTileHandleMap.Contains(sector.mySector) && myTileHandleMap[sector.mySector].myLOD > sector.myLOD;
-		// If the sector doesn't have a tile already, or the tile that does exist is a higher LOD
-		if (!myTileHandleMap.Contains(sector.mySector) || isExistsAtLowerLOD)
-		{
-
-			FCGTileHandle tileHandle;
-			// We have to create the tile for this sector
-			if (!isExistsAtLowerLOD)
-			{
-				TPair<ACGTile*, int32> tile = GetAvailableTile();
-				tileHandle.myHandle = tile.Key;
-				//tileHandle.myHandle->SetActorLocation(FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * sector.mySector.X, myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * sector.mySector.Y, 0.0f));
-
-				if (myTerrainConfig.UseInstancedWaterMesh)
-				{
-					FTransform waterTransform = FTransform(FRotator(0.0f), FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * (sector.mySector.X - 0.5f), myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * (sector.mySector.Y - 0.5f), 0.0f), FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * 0.01f, myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * 0.01f, 1.0f));
-					MyWaterMeshComponent->UpdateInstanceTransform(tile.Value, waterTransform, true, true, true);
-				}
-
-				tileHandle.myWaterISMIndex = tile.Value;
-				tileHandle.myStatus = ETileStatus::SPAWNED;
-				tileHandle.myLOD = sector.myLOD;
-				tileHandle.myLastRequiredTimestamp = FDateTime::Now();
-
-				// Add it to our sector map
-				myTileHandleMap.Add(sector.mySector, tileHandle);
-			}
-			else
-			{
-				myTileHandleMap[sector.mySector].myLOD = sector.myLOD;
-				tileHandle = myTileHandleMap[sector.mySector];
-			}
+	myActorLocationMap[aActor] = aNewSector;
+}
 
-			// Create the job to generate the new geometry and update the terrain tile
-			FCGJob job;
-			job.mySector = sector.mySector;
-			job.myTileHandle = tileHandle;
-			job.LOD = sector.myLOD;
-			job.IsInPlaceUpdate = isExistsAtLowerLOD;
+FIntVector2 ACGTerrainManager::GetSector(const FVector& aLocation) const
+{
+	FIntVector2 sector;
 
-			// TODO: this method needs renaming
-			tileHandle.myHandle->UpdateSettings(sector.mySector, &myTerrainConfig, FVector(0.f));
+	// Same maths as the vectorised sweep, so both agree on sector boundaries
+	sector.X = FMath::FloorToInt(aLocation.X * GetInvSectorSizeX() + 0.5f);
+	sector.Y = FMath::FloorToInt(aLocation.Y * GetInvSectorSizeY() + 0.5f);
 
-			if (!isExistsAtLowerLOD)
-			{
-				tileHandle.myHandle->RepositionAndHide(10);
-				if (myTerrainConfig.UseInstancedWaterMesh)
-				{
-					MyWaterMeshComponent->UpdateInstanceTransform(tileHandle.myWaterISMIndex, FTransform(FRotator(0.0f), tileHandle.myHandle->GetActorLocation(), FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * 0.01f, myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * 0.01f, 1.0f)), true, true, true);
-				}
-			}
+	return sector;
+}
 
-			CreateTileRefreshJob(std::move(job));
-		}
-	}
+UCGGenerationSubsystem* ACGTerrainManager::GetGenerationSubsystem()
+{
+	// Gone already when managers are destroyed at engine shutdown
+	return GEngine ? GEngine->GetEngineSubsystem<UCGGenerationSubsystem>() : nullptr;
 }
 
-/** Allocates data structures and pointers for mesh data **/
-void ACGTerrainManager::AllocateAllMeshDataStructures()
+void ACGTerrainManager::SetupTerrainGenerator(TScriptInterface<IWorldHeightInterface> worldHeightInterface)
 {
-	for (uint8 lod = 0; lod < myTerrainConfig.LODs.Num(); ++lod)
-	{
-		myMeshData.Add(FCGLODMeshData());
-		myFreeMeshData.Emplace();
+	myTerrainConfig.WorldHeightInterface = worldHeightInterface;
 
-		myMeshData[lod].Data.Reserve(myTerrainConfig.MeshDataPoolSize);
+	myTerrainConfig.TileOffset = FVector(myTerrainConfig.UnitSize * myTerrainConfig.TileXUnits * 0.5f, myTerrainConfig.UnitSize * myTerrainConfig.TileYUnits * 0.5f, 0.0f);
 
-		for (int j = 0; j < myTerrainConfig.MeshDataPoolSize; ++j)
-		{
-			myMeshData[lod].Data.Add(FCGMeshData());
-			AllocateDataStructuresForLOD(&myMeshData[lod].Data[j], &myTerrainConfig, lod);
-		}
+	// Dedicated servers never render anything, so only generate heightmaps and collision
+	myTerrainConfig.IsCollisionOnly = myTerrainConfig.ForceCollisionOnly || (myTerrainConfig.CollisionOnlyOnDedicatedServer && IsRunningDedicatedServer());
+	if (myTerrainConfig.IsCollisionOnly)
+	{
+		myTerrainConfig.DecoupledCollision = true;
+		myTerrainConfig.UseInstancedWaterMesh = false;
+		myTerrainConfig.GenerateSplatMap = false;
+		myTerrainConfig.DitheringLODTransitions = false;
+		myTerrainConfig.MakeDynamicMaterialInstance = false;
+		myTerrainConfig.Collision.LOD = FMath::Min<int32>(myTerrainConfig.Collision.LOD, myTerrainConfig.LODs.Num() - 1);
+
+		// The footprint only needs to cover the collision radius, with a single ring
+		TArray<FCGLODConfig> collisionLODs;
+		collisionLODs.Add(FCGLODConfig());
+		collisionLODs[0].SectorRadius = myTerrainConfig.Collision.SectorRadius + 1;
+		myStencil.Build(collisionLODs);
+		myInterestMap.Init(collisionLODs.Num(), myStencil.GetRadius());
 	}
-
-	for (uint8 lod = 0; lod < myTerrainConfig.LODs.Num(); ++lod)
+	else
 	{
-		for (int j = 0; j < myTerrainConfig.MeshDataPoolSize; ++j)
-		{
-			myFreeMeshData[lod].Add(&myMeshData[lod].Data[j]);
-		}
+		myStencil.Build(myTerrainConfig.LODs);
+		myInterestMap.Init(myTerrainConfig.LODs.Num(), myStencil.GetRadius());
 	}
-}
 
-/************************************************************************
-  Allocates all the data structures for a single LOD mesh data
-		Includes setting up triangles etc.
-************************************************************************/
-bool ACGTerrainManager::AllocateDataStructuresForLOD(FCGMeshData* aData, FCGTerrainConfig* aConfig, const uint8 aLOD)
-{
-	int32 numXVerts = aLOD == 0 ? aConfig->TileXUnits + 1 : (aConfig->TileXUnits / myTerrainConfig.LODs[aLOD].ResolutionDivisor) + 1;
-	int32 numYVerts = aLOD == 0 ? aConfig->TileYUnits + 1 : (aConfig->TileYUnits / myTerrainConfig.LODs[aLOD].ResolutionDivisor) + 1;
+	// Collision stencils are built as actors ask for them
+	myCollisionStencils.Reset();
+	myCollisionMap.Init(myTerrainConfig.LODs.Num(), FMath::Max(myTerrainConfig.Collision.SectorRadius, 0));
 
-	int32 numTotalVertices = numXVerts * numYVerts + ((numXVerts - 1) * 2) + ((numXVerts - 1) * 2);
+	// Twice the footprint, so a single actor's tiles and the ones it leaves behind until they expire rarely share a slot
+	myTileHandleMap.Init((myStencil.GetRadius() * 2 + 1) * 2);
+	myHeightFieldRegistry.Init(myTerrainConfig, (myStencil.GetRadius() * 2 + 1) * 2);
 
-	aData->MyPositions.Reserve(numTotalVertices);
-	aData->MyNormals.Reserve(numTotalVertices);
-	aData->MyTangents.Reserve(numTotalVertices);
-	aData->MyColours.Reserve(numTotalVertices);
-	aData->MyUV0.Reserve(numTotalVertices);
-	if (myTerrainConfig.GenerateSplatMap)
+	// Enough tiles for one actor's footprint plus the leading edge of a diagonal move
+	if (myTerrainConfig.PrewarmTilesPerFrame > 0)
 	{
-		aData->myTextureData.Reserve(aConfig->TileXUnits * aConfig->TileYUnits);
+		const int32 leadingEdge = myStencil.GetDelta(FIntVector2(1, 1), myStencilDeltaScratch).Entering.Num();
+		myPrewarmedTileFloor = myStencil.GetCells().Num() + leadingEdge;
+		myTilesToPrewarm = FMath::Max(myPrewarmedTileFloor - myFreeTiles.Num(), 0);
 	}
-
-	// Generate the per vertex data sets
-	aData->MyPositions.AddDefaulted(numTotalVertices);
-	aData->MyNormals.AddDefaulted(numTotalVertices);
-	aData->MyTangents.AddDefaulted(numTotalVertices);
-	aData->MyColours.AddDefaulted(numTotalVertices);
-	aData->MyUV0.AddDefaulted(numTotalVertices);
-
-	if (myTerrainConfig.GenerateSplatMap)
+	else
 	{
-		for (int32 i = 0; i < (aConfig->TileXUnits * aConfig->TileYUnits); ++i)
-		{
-			aData->myTextureData.Emplace();
-		}
+		myPrewarmedTileFloor = 0;
 	}
 
-	// Heightmap needs to be larger than the mesh
-	// Using vectors here is a lot wasteful, but it does make normal/tangent or any other
-	// Geometric calculations based on the heightmap a bit easier. Easy enough to change to floats
-
-	aData->HeightMap.Reserve((numXVerts + 2) * (numYVerts + 2));
-	for (int32 i = 0; i < (numXVerts + 2) * (numYVerts + 2); ++i)
+	// Workers and mesh data pools are shared with every other manager
+	if (UCGGenerationSubsystem* generationSubsystem = GetGenerationSubsystem())
 	{
-		aData->HeightMap.Emplace(0.0f);
+		myMeshDataPools = generationSubsystem->RegisterManager(this);
 	}
 
-	// Triangle indexes
-	int32 terrainTris = ((numXVerts - 1) * (numYVerts - 1) * 6);
-	int32 skirtTris = (((numXVerts - 1) * 2) + ((numYVerts - 1) * 2)) * 6;
-	int32 numTris = terrainTris + skirtTris;
-	aData->MyTriangles.Reserve(numTris);
-	for (int32 i = 0; i < numTris; ++i)
+	isReady = true;
+}
+
+void ACGTerrainManager::AddActorToTrack(AActor* aPawn)
+{
+	if (!aPawn || myActorLocationMap.Contains(aPawn))
 	{
-		aData->MyTriangles.Add(i);
+		return;
 	}
 
-	// Now calculate triangles and UVs
-	int32 triCounter = 0;
-	int32 thisX, thisY;
-	int32 rowLength;
-
-	rowLength = aLOD == 0 ? aConfig->TileXUnits + 1 : (aConfig->TileXUnits / myTerrainConfig.LODs[aLOD].ResolutionDivisor + 1);
-	float maxUV = aLOD == 0 ? 1.0f : 1.0f / aLOD;
+	myFrameTime = FPlatformTime::Seconds();
 
-	int32 exX = aLOD == 0 ? aConfig->TileXUnits : (aConfig->TileXUnits / myTerrainConfig.LODs[aLOD].ResolutionDivisor);
-	int32 exY = aLOD == 0 ? aConfig->TileYUnits : (aConfig->TileYUnits / myTerrainConfig.LODs[aLOD].ResolutionDivisor);
+	const FVector location = aPawn->GetActorLocation();
+	FIntVector2 pawnSector = GetSector(location);
 
-	for (int32 y = 0; y < exY; ++y)
-	{
-		for (int32 x = 0; x < exX; ++x)
-		{
+	myTrackedActors.Add(aPawn);
+	myActorLocationMap.Add(aPawn, pawnSector);
 
-			thisX = x;
-			thisY = y;
-			//TR
-			aData->MyTriangles[triCounter] = thisX + ((thisY + 1) * (rowLength));
-			triCounter++;
-			//BL
-			aData->MyTriangles[triCounter] = (thisX + 1) + (thisY * (rowLength));
-			triCounter++;
-			//BR
-			aData->MyTriangles[triCounter] = thisX + (thisY * (rowLength));
-			triCounter++;
+	// Keep the SoA arrays padded to a whole number of vector registers
+	const int32 paddedNum = Align(myTrackedActors.Num(), 4);
+	myActorPositionsX.SetNumZeroed(paddedNum);
+	myActorPositionsY.SetNumZeroed(paddedNum);
+	myActorSectorsX.SetNumZeroed(paddedNum);
+	myActorSectorsY.SetNumZeroed(paddedNum);
+	myActorSectorsX[myTrackedActors.Num() - 1] = pawnSector.X;
+	myActorSectorsY[myTrackedActors.Num() - 1] = pawnSector.Y;
 
-			//BL
-			aData->MyTriangles[triCounter] = (thisX + 1) + (thisY * (rowLength));
-			triCounter++;
-			//TR
-			aData->MyTriangles[triCounter] = thisX + ((thisY + 1) * (rowLength));
-			triCounter++;
-			// TL
-			aData->MyTriangles[triCounter] = (thisX + 1) + ((thisY + 1) * (rowLength));
-			triCounter++;
+	myInterestMap.AddFootprint(myStencil, pawnSector, myChangedSectors);
+	ApplyInterestChanges();
 
-			//TR
-			aData->MyUV0[thisX + ((thisY + 1) * (rowLength))] = FVector2D(thisX * 1.0f / rowLength, (thisY + 1.0f) / rowLength);
-			//BR
-			aData->MyUV0[thisX + (thisY * (rowLength))] = FVector2D(thisX * 1.0f / rowLength, thisY * 1.0f / rowLength);
-			//BL
-			aData->MyUV0[(thisX + 1) + (thisY * (rowLength))] = FVector2D((thisX + 1.0f) / rowLength, thisY * 1.0f / rowLength);
-			//TL
-			aData->MyUV0[(thisX + 1) + ((thisY + 1) * (rowLength))] = FVector2D((thisX + 1.0f) / rowLength, (thisY + 1.0f) / rowLength);
-		}
+	if (HasDecoupledCollision())
+	{
+		myCollisionMap.AddFootprint(GetCollisionStencil(GetCollisionConfig(aPawn)), pawnSector, myCollisionChangedSectors);
+		ApplyCollisionChanges();
 	}
+}
 
-	return true;
+void ACGTerrainManager::RemoveActorToTrack(AActor* aPawn)
+{
+	if (!aPawn)
+	{
+		return;
+	}
+
+	FIntVector2 oldSector;
+	if (!myActorLocationMap.RemoveAndCopyValue(aPawn, oldSector))
+	{
+		return;
+	}
+
+	myFrameTime = FPlatformTime::Seconds();
+
+	// Swap-remove from all the parallel arrays, the sweep doesn't care about order
+	const int32 index = myTrackedActors.Find(aPawn);
+	const int32 lastIndex = myTrackedActors.Num() - 1;
+	myActorSectorsX[index] = myActorSectorsX[lastIndex];
+	myActorSectorsY[index] = myActorSectorsY[lastIndex];
+	myActorSectorsX[lastIndex] = 0.0f;
+	myActorSectorsY[lastIndex] = 0.0f;
+	myTrackedActors.RemoveAtSwap(index, 1, false);
+
+	const int32 paddedNum = Align(myTrackedActors.Num(), 4);
+	myActorPositionsX.SetNum(paddedNum, false);
+	myActorPositionsY.SetNum(paddedNum, false);
+	myActorSectorsX.SetNum(paddedNum, false);
+	myActorSectorsY.SetNum(paddedNum, false);
+
+	if (HasDecoupledCollision())
+	{
+		myCollisionMap.RemoveFootprint(GetCollisionStencil(GetCollisionConfig(aPawn)), oldSector, myCollisionChangedSectors, myCollisionUncoveredSectors);
+	}
+	myActorCollisionMap.Remove(aPawn);
+
+	myInterestMap.RemoveFootprint(myStencil, oldSector, myChangedSectors, myUncoveredSectors);
+	ApplyInterestChanges();
+	myAreRefinementCandidatesStale = true;
+
+	TArray<FIntVector2> prefetchedSectors;
+	for (auto& elem : myPrefetchedSectors)
+	{
+		if (elem.Value.myActor == aPawn)
+		{
+			prefetchedSectors.Add(elem.Key);
+		}
+	}
+	for (const FIntVector2& sector : prefetchedSectors)
+	{
+		CancelPrefetch(sector);
+	}
+	myPrefetchingActors.Remove(aPawn);
+
+	ApplyCollisionChanges();
+}
+
+void ACGTerrainManager::SetActorCollisionConfig(AActor* aActor, const FCGCollisionConfig& aCollisionConfig)
+{
+	if (!aActor)
+	{
+		return;
+	}
+
+	const FIntVector2* actorSector = myActorLocationMap.Find(aActor);
+	if (!actorSector || !HasDecoupledCollision())
+	{
+		myActorCollisionMap.Add(aActor, aCollisionConfig);
+		return;
+	}
+
+	// The new footprint goes in before the old one comes out, so sectors in both never lose their collision
+	const FCGCollisionConfig oldConfig = GetCollisionConfig(aActor);
+	myActorCollisionMap.Add(aActor, aCollisionConfig);
+
+	myCollisionMap.AddFootprint(GetCollisionStencil(aCollisionConfig), *actorSector, myCollisionChangedSectors);
+	myCollisionMap.RemoveFootprint(GetCollisionStencil(oldConfig), *actorSector, myCollisionChangedSectors, myCollisionUncoveredSectors);
+	ApplyCollisionChanges();
+}
+
+/************************************************************************
+  Acts on whatever the collision map reported since the last call,
+		requesting collision where a sector's finest LOD changed and
+		cancelling it where nobody covers the sector any more
+************************************************************************/
+void ACGTerrainManager::ApplyCollisionChanges()
+{
+	for (const FIntVector2& sector : myCollisionUncoveredSectors)
+	{
+		FCGTileHandle* tileHandle = myTileHandleMap.Find(sector);
+		if (tileHandle && !myCollisionMap.IsCovered(sector))
+		{
+			CancelTileCollision(*tileHandle);
+		}
+	}
+
+	for (const FCGSector& sector : myCollisionChangedSectors)
+	{
+		// A footprint swap can report a sector more than once, the map has the final word
+		const int32 lod = myCollisionMap.GetFinestLOD(sector.mySector);
+
+		// Collision is only built for tiles the render radius has already spawned
+		FCGTileHandle* tileHandle = myTileHandleMap.Find(sector.mySector);
+		if (tileHandle && lod > -1 && tileHandle->myCollisionLOD != lod)
+		{
+			RequestTileCollision(sector.mySector, *tileHandle, (uint8)lod);
+		}
+	}
+
+	myCollisionChangedSectors.Reset();
+	myCollisionUncoveredSectors.Reset();
+}
+
+const FCGCollisionConfig& ACGTerrainManager::GetCollisionConfig(AActor* aActor) const
+{
+	const FCGCollisionConfig* actorConfig = myActorCollisionMap.Find(aActor);
+	return actorConfig ? *actorConfig : myTerrainConfig.Collision;
+}
+
+const FCGSectorStencil& ACGTerrainManager::GetCollisionStencil(const FCGCollisionConfig& aConfig)
+{
+	const int32 radius = FMath::Max(aConfig.SectorRadius, 0);
+	// Collision only mode only has a mesh data pool for the default collision LOD
+	const uint8 lod = myTerrainConfig.IsCollisionOnly ? myTerrainConfig.Collision.LOD : FMath::Min<int32>(aConfig.LOD, myTerrainConfig.LODs.Num() - 1);
+
+	const int32 key = (radius << 8) | lod;
+	FCGSectorStencil* stencil = myCollisionStencils.Find(key);
+	if (!stencil)
+	{
+		stencil = &myCollisionStencils.Add(key);
+		stencil->BuildDisc(radius, lod);
+	}
+	return *stencil;
+}
+
+void ACGTerrainManager::RequestTileCollision(const FIntVector2& aSector, FCGTileHandle& aTileHandle, const uint8 aLOD)
+{
+	// Any job still pending at the old resolution is superseded
+	if (aTileHandle.myCollisionCancelToken.IsValid())
+	{
+		aTileHandle.myCollisionCancelToken->AtomicSet(true);
+	}
+
+	aTileHandle.myCollisionLOD = aLOD;
+	aTileHandle.myCollisionCancelToken = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+
+	FCGJob job;
+	job.mySector = aSector;
+	job.myTileHandle = aTileHandle;
+	job.LOD = aLOD;
+	job.IsCollisionJob = true;
+	job.CancelToken = aTileHandle.myCollisionCancelToken;
+
+	CreateTileRefreshJob(std::move(job));
+}
+
+void ACGTerrainManager::CancelTileCollision(FCGTileHandle& aTileHandle)
+{
+	if (aTileHandle.myCollisionLOD < 0)
+	{
+		return;
+	}
+
+	if (aTileHandle.myCollisionCancelToken.IsValid())
+	{
+		aTileHandle.myCollisionCancelToken->AtomicSet(true);
+		aTileHandle.myCollisionCancelToken.Reset();
+	}
+
+	aTileHandle.myCollisionLOD = -1;
+	aTileHandle.myHandle->ClearCollisionMesh();
+}
+
+void ACGTerrainManager::CreateTileRefreshJob(FCGJob aJob)
+{
+	if (aJob.LOD != 10)
+	{
+		if (!aJob.IsCollisionJob || myTerrainConfig.IsCollisionOnly)
+		{
+			SetTileStatus(aJob.mySector, aJob.myTileHandle.mySpawnId, ETileStatus::REQUESTED);
+		}
+		AddQueuedJob(aJob.mySector);
+		aJob.Timings.myQueuedCycles = FPlatformTime::Cycles64();
+		myPendingJobQueue.Enqueue(std::move(aJob));
+	}
+}
+
+/************************************************************************
+  Checks every tracked actor's position in one vectorised pass, then
+		moves the footprints of the ones that changed sector
+************************************************************************/
+void ACGTerrainManager::SweepActorSectors()
+{
+	const int32 numActors = myTrackedActors.Num();
+	const int32 paddedNum = myActorPositionsX.Num();
+
+	for (int32 i = 0; i < numActors; ++i)
+	{
+		const FVector location = myTrackedActors[i]->GetActorLocation();
+		myActorPositionsX[i] = location.X;
+		myActorPositionsY[i] = location.Y;
+	}
+
+	const VectorRegister invSizeX = VectorSetFloat1(GetInvSectorSizeX());
+	const VectorRegister invSizeY = VectorSetFloat1(GetInvSectorSizeY());
+	const VectorRegister half = VectorSetFloat1(0.5f);
+	const VectorRegister hysteresis = VectorSetFloat1(0.5f + myTerrainConfig.SectorHysteresis);
+
+	myMovedActors.Reset();
+	myMovedActorsFrom.Reset();
+
+	for (int32 i = 0; i < paddedNum; i += 4)
+	{
+		const VectorRegister scaledX = VectorMultiply(VectorLoadAligned(&myActorPositionsX[i]), invSizeX);
+		const VectorRegister scaledY = VectorMultiply(VectorLoadAligned(&myActorPositionsY[i]), invSizeY);
+		const VectorRegister currentX = VectorLoadAligned(&myActorSectorsX[i]);
+		const VectorRegister currentY = VectorLoadAligned(&myActorSectorsY[i]);
+
+		// An axis only changes sector once the actor is past the boundary by the hysteresis band
+		const VectorRegister outsideX = VectorCompareGT(VectorAbs(VectorSubtract(scaledX, currentX)), hysteresis);
+		const VectorRegister outsideY = VectorCompareGT(VectorAbs(VectorSubtract(scaledY, currentY)), hysteresis);
+		const VectorRegister sectorX = VectorSelect(outsideX, VectorFloor(VectorAdd(scaledX, half)), currentX);
+		const VectorRegister sectorY = VectorSelect(outsideY, VectorFloor(VectorAdd(scaledY, half)), currentY);
+
+		const VectorRegister changed = VectorBitwiseOr(VectorCompareNE(sectorX, currentX), VectorCompareNE(sectorY, currentY));
+		int32 changedMask = VectorMaskBits(changed);
+
+		if (changedMask)
+		{
+			// Keep the old sectors around until the footprints have been moved
+			VectorStoreAligned(sectorX, &myActorPositionsX[i]);
+			VectorStoreAligned(sectorY, &myActorPositionsY[i]);
+
+			for (int32 lane = 0; lane < 4 && i + lane < numActors; ++lane)
+			{
+				if (changedMask & (1 << lane))
+				{
+					myMovedActors.Add(i + lane);
+				}
+			}
+		}
+	}
+
+	for (const int32 index : myMovedActors)
+	{
+		const FIntVector2 oldSector(FMath::TruncToInt(myActorSectorsX[index]), FMath::TruncToInt(myActorSectorsY[index]));
+		const FIntVector2 newSector(FMath::TruncToInt(myActorPositionsX[index]), FMath::TruncToInt(myActorPositionsY[index]));
+
+		myActorSectorsX[index] = newSector.X;
+		myActorSectorsY[index] = newSector.Y;
+		SetActorSector(myTrackedActors[index], newSector);
+		myMovedActorsFrom.Add(oldSector);
+
+		myInterestMap.MoveFootprint(myStencil, oldSector, newSector, myStencilDeltaScratch, myChangedSectors, myUncoveredSectors);
+		if (HasDecoupledCollision())
+		{
+			myCollisionMap.MoveFootprint(GetCollisionStencil(GetCollisionConfig(myTrackedActors[index])), oldSector, newSector, myStencilDeltaScratch, myCollisionChangedSectors, myCollisionUncoveredSectors);
+		}
+	}
+
+	if (myMovedActors.Num() > 0)
+	{
+		// Take care of spawning new sectors if necessary, then collision for the ones that have tiles
+		ApplyInterestChanges();
+		ApplyCollisionChanges();
+
+		// Every refinement's distance to its nearest actor may have changed
+		myAreRefinementCandidatesStale = true;
+	}
+
+	// Moving changes how far every tile around both ends of the move is from its nearest actor, and with it their projected error
+	if (IsScreenSpaceErrorLOD())
+	{
+		for (int32 i = 0; i < myMovedActors.Num(); ++i)
+		{
+			ReselectScreenSpaceErrorLODs(myMovedActorsFrom[i]);
+			ReselectScreenSpaceErrorLODs(FIntVector2(FMath::TruncToInt(myActorSectorsX[myMovedActors[i]]), FMath::TruncToInt(myActorSectorsY[myMovedActors[i]])));
+		}
+	}
+}
+
+/************************************************************************
+  Screen space error mode. Requires the covered tiles in a stencil around
+		aAroundSector again wherever their error now wants another LOD
+************************************************************************/
+void ACGTerrainManager::ReselectScreenSpaceErrorLODs(const FIntVector2& aAroundSector)
+{
+	for (const FCGSector& cell : myStencil.GetCells())
+	{
+		const FIntVector2 sector = aAroundSector + cell.mySector;
+		const FCGTileHandle* tileHandle = myTileHandleMap.Find(sector);
+
+		// Tiles waiting on a refinement are reselected when it's issued
+		if (!tileHandle || tileHandle->myCurvature < 0.0f || !myInterestMap.IsCovered(sector) || myRefinements.Contains(sector))
+		{
+			continue;
+		}
+
+		if (SelectScreenSpaceErrorLOD(sector, tileHandle->myLOD, tileHandle->myCurvature) != tileHandle->myLOD)
+		{
+			RequireSector(FCGSector(sector, tileHandle->myLOD));
+		}
+	}
+}
+
+/************************************************************************
+  Acts on whatever the interest map reported since the last call. Only
+		sectors whose coverage actually changed end up here
+************************************************************************/
+void ACGTerrainManager::ApplyInterestChanges()
+{
+	for (const FCGSector& sector : myChangedSectors)
+	{
+		RequireSector(sector);
+	}
+
+	// The release delay counts from when the sector dropped out of every footprint
+	for (const FIntVector2& sector : myUncoveredSectors)
+	{
+		if (FCGTileHandle* tileHandle = myTileHandleMap.Find(sector))
+		{
+			tileHandle->myLastRequiredTimestamp = myFrameTime;
+		}
+	}
+
+	myChangedSectors.Reset();
+	myUncoveredSectors.Reset();
+}
+
+void ACGTerrainManager::RequireSector(const FCGSector& aSector, const bool aIsRefinement)
+{
+	FCGPrefetch prefetch;
+	const bool isPrefetched = myPrefetchedSectors.RemoveAndCopyValue(aSector.mySector, prefetch);
+	// The actor has caught up with a prefetch, so it can't wait behind the low priority queue any more
+	if (isPrefetched)
+	{
+		prefetch.myCancelToken->AtomicSet(true);
+	}
+
+	FCGTileHandle* existingHandle = myTileHandleMap.Find(aSector.mySector);
+
+	// Once a tile's roughness is known its projected error decides the LOD, not the ring it's in
+	FCGSector sector = aSector;
+	if (IsScreenSpaceErrorLOD() && existingHandle && existingHandle->myCurvature >= 0.0f)
+	{
+		sector.myLOD = SelectScreenSpaceErrorLOD(sector.mySector, existingHandle->myLOD, existingHandle->myCurvature);
+	}
+
+	// Any refinement still waiting was for the old requirement, it's added back below if it's still wanted
+	myRefinements.Remove(sector.mySector);
+
+	const bool isExistsAtLowerLOD = existingHandle && existingHandle->myLOD > sector.myLOD;
+
+	// Nobody needs this much detail any more, swap in the coarser LOD and free the finer one
+	const bool isExistsAtHigherLOD = existingHandle && existingHandle->myLOD < sector.myLOD;
+	if (isExistsAtHigherLOD && !isPrefetched && myTerrainConfig.DowngradeLODs && !myTerrainConfig.IsCollisionOnly)
+	{
+		existingHandle->myLOD = sector.myLOD;
+
+		FCGJob job;
+		job.mySector = sector.mySector;
+		job.myTileHandle = *existingHandle;
+		job.LOD = sector.myLOD;
+		job.IsDowngrade = true;
+
+		CreateTileRefreshJob(std::move(job));
+		return;
+	}
+
+	// If the sector has a tile already at this LOD or better, there's nothing to do
+	if (existingHandle && !isExistsAtLowerLOD && !isPrefetched)
+	{
+		return;
+	}
+
+	// Collision only tiles get their geometry from collision jobs alone
+	if (myTerrainConfig.IsCollisionOnly)
+	{
+		if (!existingHandle)
+		{
+			SpawnTileForSector(aSector);
+		}
+		return;
+	}
+
+	// Progressive mode builds new tiles at the coarsest LOD, and upgrades wait their turn in the refinement list
+	const uint8 coarseLOD = myTerrainConfig.LODs.Num() - 1;
+	if (IsProgressiveRefinement() && !aIsRefinement && sector.myLOD < coarseLOD)
+	{
+		myRefinements.Add(sector.mySector, sector.myLOD);
+		myAreRefinementCandidatesStale = true;
+
+		// Already showing something, a prefetch hasn't landed yet so has nothing to show
+		if (existingHandle && !isPrefetched)
+		{
+			return;
+		}
+
+		FCGTileHandle coarseHandle;
+		if (!existingHandle)
+		{
+			coarseHandle = SpawnTileForSector(FCGSector(aSector.mySector, coarseLOD));
+		}
+		else
+		{
+			existingHandle->myLOD = coarseLOD;
+			coarseHandle = *existingHandle;
+		}
+
+		FCGJob job;
+		job.mySector = aSector.mySector;
+		job.myTileHandle = coarseHandle;
+		job.LOD = coarseLOD;
+
+		CreateTileRefreshJob(std::move(job));
+		return;
+	}
+
+	FCGTileHandle tileHandle;
+	// We have to create the tile for this sector
+	if (!existingHandle)
+	{
+		tileHandle = SpawnTileForSector(aSector);
+	}
+	else
+	{
+		existingHandle->myLOD = FMath::Min(existingHandle->myLOD, sector.myLOD);
+		tileHandle = *existingHandle;
+	}
+
+	// Create the job to generate the new geometry and update the terrain tile
+	FCGJob job;
+	job.mySector = aSector.mySector;
+	job.myTileHandle = tileHandle;
+	job.LOD = tileHandle.myLOD;
+	job.IsInPlaceUpdate = isExistsAtLowerLOD;
+
+	CreateTileRefreshJob(std::move(job));
+}
+
+/************************************************************************
+  Progressive mode. Lets refinements into the pending queue only while
+		it's nearly empty, so the coarse pass finishes first, and picks
+		the tiles nearest the actors first
+************************************************************************/
+void ACGTerrainManager::IssueRefinements()
+{
+	const int32 numToIssue = myTerrainConfig.RefinementQueueDepth - myPendingJobQueue.Num();
+	if (myRefinements.Num() == 0 || numToIssue <= 0)
+	{
+		return;
+	}
+
+	// Refining before the coarse build has landed would only throw that build away
+	auto isReady = [this](const FIntVector2& aSector) {
+		const FCGTileHandle* tileHandle = myTileHandleMap.Find(aSector);
+		return tileHandle && (tileHandle->myStatus == ETileStatus::TRANSITION || tileHandle->myStatus == ETileStatus::IDLE);
+	};
+
+	// Nearest first, then the ones with the most detail still to gain
+	auto isBefore = [](const TPair<int32, FCGSector>& aA, const TPair<int32, FCGSector>& aB) {
+		return aA.Key != aB.Key ? aA.Key < aB.Key : aA.Value.myLOD < aB.Value.myLOD;
+	};
+
+	if (myAreRefinementCandidatesStale)
+	{
+		myRefinementCandidates.Reset();
+		for (const auto& elem : myRefinements)
+		{
+			if (isReady(elem.Key))
+			{
+				myRefinementCandidates.Emplace(GetNearestActorDistanceSq(elem.Key), FCGSector(elem.Key, elem.Value));
+			}
+		}
+		myRefinementCandidates.Heapify(isBefore);
+		myAreRefinementCandidatesStale = false;
+	}
+
+	// Only as many pops as there's room for, the rest of the heap waits for the next frame
+	int32 numIssued = 0;
+	TPair<int32, FCGSector> candidate;
+	while (numIssued < numToIssue && myRefinementCandidates.Num() > 0)
+	{
+		myRefinementCandidates.HeapPop(candidate, isBefore, false);
+
+		// Issued, released or re-required since the heap was built
+		const uint8* refinementLOD = myRefinements.Find(candidate.Value.mySector);
+		if (!refinementLOD || *refinementLOD != candidate.Value.myLOD || !isReady(candidate.Value.mySector))
+		{
+			continue;
+		}
+
+		RequireSector(candidate.Value, true);
+		numIssued++;
+	}
+}
+
+/************************************************************************
+  Grabs a free tile, moves it to the sector and adds it to the sector map
+************************************************************************/
+FCGTileHandle ACGTerrainManager::SpawnTileForSector(const FCGSector& aSector)
+{
+	FCGTileHandle tileHandle;
+
+	TPair<ACGTile*, int32> tile = GetAvailableTile();
+	tileHandle.myHandle = tile.Key;
+	tileHandle.myWaterISMIndex = tile.Value;
+	tileHandle.myStatus = ETileStatus::SPAWNED;
+	tileHandle.myLOD = aSector.myLOD;
+	tileHandle.myLastRequiredTimestamp = myFrameTime;
+	tileHandle.mySpawnId = ++myLastSpawnId;
+
+	// Add it to our sector map
+	myTileHandleMap.Add(aSector.mySector, tileHandle);
+	myTileExpiryHeap.HeapPush(FCGTileExpiry(myFrameTime + myTerrainConfig.TileReleaseDelay.GetTotalSeconds(), aSector.mySector, tileHandle.mySpawnId));
+
+	// TODO: this method needs renaming
+	tileHandle.myHandle->UpdateSettings(aSector.mySector, &myTerrainConfig, FVector(0.f));
+	tileHandle.myHandle->RepositionAndHide(10);
+
+	if (myTerrainConfig.UseInstancedWaterMesh)
+	{
+		MyWaterMeshComponent->UpdateInstanceTransform(tileHandle.myWaterISMIndex, FTransform(FRotator(0.0f), tileHandle.myHandle->GetActorLocation(), FVector(myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize * 0.01f, myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize * 0.01f, 1.0f)), true, true, true);
+	}
+
+	// The collision map only reports a sector when its coverage changes, so a tile spawned inside a footprint asks for itself
+	const int32 collisionLOD = HasDecoupledCollision() ? myCollisionMap.GetFinestLOD(aSector.mySector) : -1;
+	if (collisionLOD > -1)
+	{
+		FCGTileHandle& mappedHandle = *myTileHandleMap.Find(aSector.mySector);
+		RequestTileCollision(aSector.mySector, mappedHandle, (uint8)collisionLOD);
+		tileHandle = mappedHandle;
+	}
+
+	return tileHandle;
+}
+
+/************************************************************************
+  Extrapolates the actor's velocity and queues low priority jobs for the
+		sectors it's about to need. Prefetches that drop out of the
+		prediction are cancelled and their tiles freed
+************************************************************************/
+void ACGTerrainManager::PrefetchSectorsForActor(const AActor* anActor)
+{
+	if (myTerrainConfig.PrefetchLookaheadSeconds <= 0.0f)
+	{
+		return;
+	}
+
+	const FVector velocity = FVector(anActor->GetVelocity().X, anActor->GetVelocity().Y, 0.0f);
+	const float tileSize = FMath::Min(myTerrainConfig.TileXUnits, myTerrainConfig.TileYUnits) * myTerrainConfig.UnitSize;
+	const float lookaheadDistance = velocity.Size() * myTerrainConfig.PrefetchLookaheadSeconds;
+
+	// Most actors aren't moving fast enough to need anything, skip them unless there's something to cancel
+	if (lookaheadDistance <= tileSize && !myPrefetchingActors.Contains(anActor))
+	{
+		return;
+	}
+
+	TSet<FIntVector2> predictedSectors;
+
+	// Step along the predicted path a tile at a time so we don't leave holes between here and there
+	if (lookaheadDistance > tileSize)
+	{
+		const FIntVector2 currentSector = myActorLocationMap[anActor];
+		const int32 numSteps = FMath::CeilToInt(lookaheadDistance / tileSize);
+		const FVector direction = velocity.GetSafeNormal();
+		FIntVector2 lastRootSector = currentSector;
+
+		for (int32 step = 1; step <= numSteps; ++step)
+		{
+			const FVector predictedLocation = anActor->GetActorLocation() + direction * FMath::Min(step * tileSize, lookaheadDistance);
+			const FIntVector2 rootSector = GetSector(predictedLocation);
+			if (rootSector == lastRootSector)
+			{
+				continue;
+			}
+
+			// Only the sectors the footprint would gain by moving there
+			const FCGSectorStencilDelta& delta = myStencil.GetDelta(rootSector - lastRootSector, myStencilDeltaScratch);
+			lastRootSector = rootSector;
+
+			for (const FCGSector& cell : delta.Entering)
+			{
+				const FCGSector sector(rootSector + cell.mySector, cell.myLOD);
+
+				// Anything the actor already needs is handled by the normal sweep
+				if (myStencil.GetLODAtOffset(sector.mySector - currentSector) > -1 || predictedSectors.Contains(sector.mySector))
+				{
+					continue;
+				}
+
+				predictedSectors.Add(sector.mySector);
+
+				if (FCGPrefetch* prefetch = myPrefetchedSectors.Find(sector.mySector))
+				{
+					myTileHandleMap.Find(sector.mySector)->myLastRequiredTimestamp = myFrameTime;
+					prefetch->myActor = anActor;
+				}
+				else if (!myTileHandleMap.Contains(sector.mySector))
+				{
+					FCGPrefetch newPrefetch;
+					newPrefetch.myActor = anActor;
+					newPrefetch.myCancelToken = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+
+					FCGJob job;
+					job.mySector = sector.mySector;
+					job.myTileHandle = SpawnTileForSector(sector);
+					job.LOD = sector.myLOD;
+					job.IsPrefetch = true;
+					job.CancelToken = newPrefetch.myCancelToken;
+
+					myPrefetchedSectors.Add(sector.mySector, newPrefetch);
+					myPrefetchingActors.Add(anActor);
+					AddQueuedJob(job.mySector);
+					SetTileStatus(job.mySector, job.myTileHandle.mySpawnId, ETileStatus::REQUESTED);
+					job.Timings.myQueuedCycles = FPlatformTime::Cycles64();
+					myPrefetchJobQueue.Enqueue(std::move(job));
+				}
+			}
+		}
+	}
+
+	// Anything this actor prefetched that's no longer on its path was a bad guess
+	TArray<FIntVector2> mispredictedSectors;
+	for (auto& elem : myPrefetchedSectors)
+	{
+		if (elem.Value.myActor == anActor && !predictedSectors.Contains(elem.Key))
+		{
+			mispredictedSectors.Add(elem.Key);
+		}
+	}
+
+	for (const FIntVector2& sector : mispredictedSectors)
+	{
+		CancelPrefetch(sector);
+	}
+
+	if (predictedSectors.Num() == 0)
+	{
+		myPrefetchingActors.Remove(anActor);
+	}
+}
+
+void ACGTerrainManager::CancelPrefetch(const FIntVector2& aSector)
+{
+	FCGPrefetch prefetch;
+	if (!myPrefetchedSectors.RemoveAndCopyValue(aSector, prefetch))
+	{
+		return;
+	}
+
+	// The job still comes back through the update queue, which is where it stops being counted
+	prefetch.myCancelToken->AtomicSet(true);
+
+	ReleaseSector(aSector);
+}
+
+void ACGTerrainManager::AddQueuedJob(const FIntVector2& aSector)
+{
+	myQueuedSectors.FindOrAdd(aSector)++;
+}
+
+void ACGTerrainManager::FinishQueuedJob(const FIntVector2& aSector)
+{
+	int32* numJobs = myQueuedSectors.Find(aSector);
+	if (numJobs && --(*numJobs) <= 0)
+	{
+		myQueuedSectors.Remove(aSector);
+	}
+}
+
+/************************************************************************
+  Removes the sector's tile from the map, cancelling anything still
+		pending for it, and returns the tile to the free list
+************************************************************************/
+void ACGTerrainManager::ReleaseSector(const FIntVector2& aSector)
+{
+	FCGTileHandle tileHandle;
+	if (!myTileHandleMap.RemoveAndCopyValue(aSector, tileHandle))
+	{
+		return;
+	}
+
+	CancelTileCollision(tileHandle);
+
+	FCGPrefetch prefetch;
+	if (myPrefetchedSectors.RemoveAndCopyValue(aSector, prefetch))
+	{
+		prefetch.myCancelToken->AtomicSet(true);
+	}
+	myRefinements.Remove(aSector);
+
+	myTransitioningTiles.RemoveSwap(tileHandle.myHandle, false);
+	myHeightFieldRegistry.Remove(aSector);
+	FreeTile(tileHandle.myHandle, tileHandle.myWaterISMIndex);
+}
+
+/************************************************************************
+  Totals up what the tiles and pools are holding and, when that's over
+		the budget, evicts cached data: free tiles first, then LODs live
+		tiles aren't showing. Furthest from any actor goes first
+************************************************************************/
+void ACGTerrainManager::UpdateMemoryBudget()
+{
+	SCOPE_CYCLE_COUNTER(STAT_MemoryGovernor);
+
+	int64 sectionBytes = 0;
+	int64 collisionBytes = 0;
+	int64 textureBytes = 0;
+	int64 heightFieldBytes = 0;
+
+	auto accumulateTile = [&](const ACGTile* aTile) {
+		sectionBytes += aTile->GetSectionBytes();
+		collisionBytes += aTile->GetCollisionBytes();
+		textureBytes += aTile->GetTextureBytes();
+	};
+
+	for (const ACGTile* tile : myFreeTiles)
+	{
+		accumulateTile(tile);
+	}
+	myTileHandleMap.ForEach([&](const FIntVector2& aSector, FCGTileHandle& aTileHandle) {
+		accumulateTile(aTileHandle.myHandle);
+		// Shared with the ground query registry, so counted once here
+		if (aTileHandle.myHeightField.IsValid())
+		{
+			heightFieldBytes += aTileHandle.myHeightField->myHeights.GetAllocatedSize();
+		}
+	});
+
+	// Pools shared with other managers count against each of their budgets
+	const int64 poolBytes = myMeshDataPools.IsValid() ? myMeshDataPools->GetAllocatedBytes() : 0;
+	int64 totalBytes = sectionBytes + collisionBytes + textureBytes + heightFieldBytes + poolBytes;
+
+	// The generation subsystem sums these across managers for the memory stats
+	myLastSectionBytes = sectionBytes;
+	myLastCollisionBytes = collisionBytes;
+	myLastTextureBytes = textureBytes;
+	myLastHeightFieldBytes = heightFieldBytes;
+
+	const int64 budgetBytes = (int64)myTerrainConfig.MemoryBudgetMB * 1024 * 1024;
+	if (budgetBytes <= 0 || totalBytes <= budgetBytes)
+	{
+		return;
+	}
+
+	// Free tiles aren't showing anything, so everything they hold can go
+	myFreeTiles.Sort([this](const ACGTile& A, const ACGTile& B) {
+		return GetNearestActorDistanceSq(A.GetSector()) < GetNearestActorDistanceSq(B.GetSector());
+	});
+
+	// Sorted nearest first, so walking back from the end evicts the furthest first
+	for (int32 i = myFreeTiles.Num() - 1; i >= 0 && totalBytes > budgetBytes; --i)
+	{
+		totalBytes -= myFreeTiles[i]->ReleaseAllMeshData();
+	}
+
+	if (totalBytes <= budgetBytes)
+	{
+		return;
+	}
+
+	// Then the LODs live tiles have cached but aren't currently showing
+	struct FCGEvictionCandidate
+	{
+		ACGTile* myTile;
+		uint8 myLOD;
+		int32 myDistanceSq;
+	};
+
+	TArray<FCGEvictionCandidate> candidates;
+	myTileHandleMap.ForEach([&](const FIntVector2& aSector, FCGTileHandle& aTileHandle) {
+		ACGTile* tile = aTileHandle.myHandle;
+		// Tiles mid-fade still need their previous LOD
+		if (myTransitioningTiles.Contains(tile))
+		{
+			return;
+		}
+
+		const int32 distanceSq = GetNearestActorDistanceSq(aSector);
+		for (uint8 lod = 0; lod < myTerrainConfig.LODs.Num(); ++lod)
+		{
+			// Anything still fading out is left alone too
+			if (lod != tile->GetCurrentLOD() && tile->GetLODStatus(lod) != ELODStatus::TRANSITION && tile->GetSectionBytes(lod) > 0)
+			{
+				candidates.Add({ tile, lod, distanceSq });
+			}
+		}
+	});
+
+	// Furthest first, and the finer (larger) sections first at the same distance
+	candidates.Sort([](const FCGEvictionCandidate& A, const FCGEvictionCandidate& B) {
+		return A.myDistanceSq != B.myDistanceSq ? A.myDistanceSq > B.myDistanceSq : A.myLOD < B.myLOD;
+	});
+
+	for (int32 i = 0; i < candidates.Num() && totalBytes > budgetBytes; ++i)
+	{
+		totalBytes -= candidates[i].myTile->ReleaseLOD(candidates[i].myLOD);
+	}
+
+	if (totalBytes <= budgetBytes)
+	{
+		return;
+	}
+
+	// Still over, so destroy free tiles outright to release their components and splat textures. Not the ones prewarming
+	// paid for though, they've already given up their mesh data above and respawning them is the hitch prewarming avoids
+	while (myFreeTiles.Num() > 0 && myFreeTiles.Num() + myTileHandleMap.Num() > myPrewarmedTileFloor && totalBytes > budgetBytes)
+	{
+		ACGTile* tile = myFreeTiles.Pop();
+		totalBytes -= tile->GetTextureBytes();
+		tile->Destroy();
+	}
+}
+
+/************************************************************************
+  Picks the coarsest LOD whose geometric error, projected at the
+		distance of the nearest actor, stays under MaxScreenSpaceError.
+		Coarsening needs the error to clear the threshold by LODHysteresis
+************************************************************************/
+uint8 ACGTerrainManager::SelectScreenSpaceErrorLOD(const FIntVector2& aSector, const uint8 aCurrentLOD, const float aCurvature) const
+{
+	const int32 numLODs = myTerrainConfig.LODs.Num();
+	if (numLODs < 1)
+	{
+		return aCurrentLOD;
+	}
+
+	// Distance to the sector edge nearest the actor, so the actor's own sector is never at zero distance
+	const float sectorSize = myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize;
+	const float distance = FMath::Max(FMath::Sqrt((float)GetNearestActorDistanceSq(aSector)) - 0.5f, 0.5f) * sectorSize;
+	const float maxError = myTerrainConfig.MaxScreenSpaceError * distance / FMath::Max(myTerrainConfig.ScreenSpaceErrorScale, 1.0f);
+
+	auto getError = [&](const int32 aLOD) {
+		const float divisor = aLOD == 0 ? 1.0f : myTerrainConfig.LODs[aLOD].ResolutionDivisor;
+		return aCurvature * divisor * divisor * 0.125f;
+	};
+
+	int32 lod = FMath::Min<int32>(aCurrentLOD, numLODs - 1);
+	if (getError(lod) > maxError)
+	{
+		while (lod > 0 && getError(lod) > maxError)
+		{
+			lod--;
+		}
+	}
+	else
+	{
+		const float coarsenError = maxError * (1.0f - myTerrainConfig.LODHysteresis);
+		while (lod < numLODs - 1 && getError(lod + 1) < coarsenError)
+		{
+			lod++;
+		}
+	}
+
+	return (uint8)lod;
+}
+
+bool ACGTerrainManager::IsHeightFieldNeededForDowngrades(const FCGHeightField& aHeightField, const uint8 aLOD) const
+{
+	// Same rule as the workers' subsampling, the target's divisor has to be a multiple of the source's
+	const int32 fieldDivisor = FCGCoreAdapter::GetDivisor(myTerrainConfig, aHeightField.myLOD);
+	const int32 lodDivisor = FCGCoreAdapter::GetDivisor(myTerrainConfig, aLOD);
+	for (int32 lod = aLOD + 1; lod < myTerrainConfig.LODs.Num(); ++lod)
+	{
+		const int32 divisor = FCGCoreAdapter::GetDivisor(myTerrainConfig, lod);
+		if (fieldDivisor > 0 && divisor % fieldDivisor == 0 && (lodDivisor <= 0 || divisor % lodDivisor != 0))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int32 ACGTerrainManager::GetNearestActorDistanceSq(const FIntVector2& aSector) const
+{
+	int32 nearestDistanceSq = MAX_int32;
+	for (int32 i = 0; i < myTrackedActors.Num(); ++i)
+	{
+		const int32 dX = aSector.X - (int32)myActorSectorsX[i];
+		const int32 dY = aSector.Y - (int32)myActorSectorsY[i];
+		nearestDistanceSq = FMath::Min(nearestDistanceSq, dX * dX + dY * dY);
+	}
+	return nearestDistanceSq;
 }
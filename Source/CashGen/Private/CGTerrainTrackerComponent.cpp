@@ -65,10 +65,22 @@ void UCGTerrainTrackerComponent::TickComponent(float DeltaTime, ELevelTick TickT
 			if (thisTM && thisTM->isReady)
 			{
 				isSetup = true;
+				if (OverrideCollisionConfig)
+				{
+					thisTM->SetActorCollisionConfig(GetOwner(), CollisionConfig);
+				}
 				thisTM->AddActorToTrack(GetOwner());
 				MyTerrainManager = thisTM;
 				
-				MyTerrainManager->OnTerrainComplete().AddUObject(this, &UCGTerrainTrackerComponent::OnTerrainComplete);
+				// Progressive terrain is only complete once every tile is refined, the ground under the actor is ready well before
+				if (MyTerrainManager->myTerrainConfig.ProgressiveRefinement)
+				{
+					MyTerrainManager->OnNearTerrainReady().AddUObject(this, &UCGTerrainTrackerComponent::OnTerrainComplete);
+				}
+				else
+				{
+					MyTerrainManager->OnTerrainComplete().AddUObject(this, &UCGTerrainTrackerComponent::OnTerrainComplete);
+				}
 				if (HideActorUntilTerrainComplete)
 				{
 					GetOwner()->SetActorHiddenInGame(true);
@@ -96,47 +108,33 @@ void UCGTerrainTrackerComponent::TickComponent(float DeltaTime, ELevelTick TickT
 		
 	}
 
-	if (!isSpawnPointFound && isTerrainComplete && TeleportToSurfaceOnTerrainComplete)
+	// Spawn points come from the heightmaps, so one can be picked as soon as the tiles under it are generated rather than once collision is cooked
+	if (!isSpawnPointFound && MyTerrainManager && TeleportToSurfaceOnTerrainComplete)
 	{
-		int32 raycastsRemainingThisFrame = SpawnRayCastsPerFrame;
-
-		while (raycastsRemainingThisFrame > 0)
+		for (int32 i = 0; i < SpawnRayCastsPerFrame; ++i)
 		{
+			const FVector candidate = mySpawnLocation + FVector(FMath::RandRange(-10000.0f, 10000.0f), FMath::RandRange(-100000.0f, 100000.0f), 0.0f);
+			FCGGroundInfo groundInfo;
 
-
-			FVector traceStart = mySpawnLocation + FVector(FMath::RandRange(-10000.0f, 10000.0f), FMath::RandRange(-100000.0f, 100000.0f), 5000.0f);
-			FVector traceEnd = traceStart + FVector(0.f, 0.f, -50000.0f);
-			FCollisionQueryParams traceParams;
-
-			traceParams.bTraceComplex = true;
-			traceParams.bReturnPhysicalMaterial = true;
-
-			/*		const FName TraceTag("SpawnTraceTag");
-
-					GetWorld()->DebugDrawTraceTag = TraceTag;
-
-					traceParams.TraceTag = TraceTag;*/
-
-			FHitResult hitResult;
-
-			if (GetWorld()->LineTraceSingleByChannel(hitResult, traceStart, traceEnd, ECC_GameTraceChannel1, traceParams)
-				&& hitResult.Location.Z > 10.0f)
+			if (MyTerrainManager->GetGroundInfo(candidate.X, candidate.Y, groundInfo) && groundInfo.Height > 10.0f)
 			{
-
-				GetOwner()->SetActorLocation(hitResult.Location + FVector(0.0f, 0.0f, 10.0f));
-				ACharacter* character = Cast<ACharacter>(GetOwner());
-				if (character)
-				{
-					character->GetCharacterMovement()->GravityScale = 1.0f;
-				}
-				GetOwner()->SetActorHiddenInGame(false);
+				GetOwner()->SetActorLocation(FVector(candidate.X, candidate.Y, groundInfo.Height + 10.0f));
 				isSpawnPointFound = true;
 				break;
 			}
-
-			raycastsRemainingThisFrame--;
 		}
+	}
 
+	// The actor only gets gravity back once the collision under it is in
+	if (isSpawnPointFound && !isSpawnComplete && isTerrainComplete && TeleportToSurfaceOnTerrainComplete)
+	{
+		ACharacter* character = Cast<ACharacter>(GetOwner());
+		if (character)
+		{
+			character->GetCharacterMovement()->GravityScale = 1.0f;
+		}
+		GetOwner()->SetActorHiddenInGame(false);
+		isSpawnComplete = true;
 	}
 
 
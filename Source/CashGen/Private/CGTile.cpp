@@ -1,323 +1,628 @@
-#include "CGTile.h"
-#include "Components/StaticMeshComponent.h"
-#include "Struct/CGTerrainConfig.h"
-
-#include <ProceduralMeshComponent/Public/ProceduralMeshComponent.h>
-
-DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ RMCUpdate"), STAT_RMCUpdate, STATGROUP_CashGenStat);
-
-ACGTile::ACGTile()
-{
-	PrimaryActorTick.bCanEverTick = false;
-
-	SphereComponent = CreateDefaultSubobject<USphereComponent>(TEXT("RootComponent"));
-	RootComponent = SphereComponent;
-
-	CurrentLOD = 10;
-	PreviousLOD = 10;
-
-	mySector = FIntVector2(0, 0);
-}
-
-ACGTile::~ACGTile()
-{
-	if (myRegion)
-	{
-		delete myRegion;
-		myRegion = nullptr;
-	}
-}
-
-bool ACGTile::TickTransition(float DeltaSeconds)
-{
-	for (auto& lod : LODStatus)
-	{
-		if (lod.Value == ELODStatus::TRANSITION && MaterialInstances.Num() > 0)
-		{
-			if (LODTransitionOpacity >= -1.0f)
-			{
-				LODTransitionOpacity -= DeltaSeconds;
-
-				if (LODTransitionOpacity > 0.0f)
-				{
-					MaterialInstances[lod.Key]->SetScalarParameterValue(FName("TerrainOpacity"), 1.0f - LODTransitionOpacity);
-				}
-				else if (PreviousLOD != 10 && PreviousLOD != CurrentLOD)
-				{
-					MaterialInstances[PreviousLOD]->SetScalarParameterValue(FName("TerrainOpacity"), LODTransitionOpacity + 1.0f);
-				}
-			}
-			else
-			{
-				if (PreviousLOD != 10 && PreviousLOD != CurrentLOD)
-				{
-					MeshComponents[PreviousLOD]->SetVisibility(false);
-				}
-
-				LODTransitionOpacity = 1.0f;
-				lod.Value = ELODStatus::CREATED;
-				return true;
-			}
-		}
-	}
-	return false;
-}
-
-/************************************************************************
- * Move the tile and make it hidden pending a redraw
- ************************************************************************/
-void ACGTile::RepositionAndHide(uint8 aNewLOD)
-{
-	SetActorLocation(FVector((TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize * mySector.X) - TerrainConfigMaster->TileOffset.X, (TerrainConfigMaster->TileYUnits * TerrainConfigMaster->UnitSize * mySector.Y) - TerrainConfigMaster->TileOffset.Y, 0.0f));
-
-	SetActorHiddenInGame(true);
-
-	CurrentLOD = aNewLOD;
-}
-
-void ACGTile::BeginPlay()
-{
-	Super::BeginPlay();
-}
-
-void ACGTile::Tick(float DeltaSeconds)
-{
-}
-
-/************************************************************************
- * Initial setup of the tile, creates components and material instance
- ************************************************************************/
-void ACGTile::UpdateSettings(FIntVector2 aOffset, FCGTerrainConfig* aTerrainConfig, FVector aWorldOffset)
-{
-	mySector.X = aOffset.X;
-	mySector.Y = aOffset.Y;
-
-	if (!IsInitalized)
-	{
-		WorldOffset = aWorldOffset;
-		TerrainConfigMaster = aTerrainConfig;
-
-		// Disable tick if we're not doing lod transitions
-
-		SetActorTickEnabled(TerrainConfigMaster->DitheringLODTransitions && aTerrainConfig->LODs.Num() > 1);
-
-		FString waterCompName = "WaterSMC";
-		FTransform waterTransform = FTransform(FRotator::ZeroRotator, FVector(TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize * 0.5f, TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize * 0.5f, 0.0f), FVector(TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize * 0.01f, TerrainConfigMaster->TileYUnits * TerrainConfigMaster->UnitSize * 0.01f, 1.0f));
-		MyWaterMeshComponent = NewObject<UStaticMeshComponent>(this, UStaticMeshComponent::StaticClass(), *waterCompName);
-		MyWaterMeshComponent->SetStaticMesh(TerrainConfigMaster->WaterMesh);
-		MyWaterMeshComponent->SetRelativeTransform(waterTransform);
-		MyWaterMeshComponent->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
-		MyWaterMeshComponent->RegisterComponent();
-
-		myWaterMaterialInstance = UMaterialInstanceDynamic::Create(TerrainConfigMaster->WaterMaterialInstance, this);
-		MyWaterMeshComponent->SetMaterial(0, myWaterMaterialInstance);
-
-		for (int32 i = 0; i < aTerrainConfig->LODs.Num(); ++i)
-		{
-
-			FString compName = "RMC" + FString::FromInt(i);
-			MeshComponents.Add(i, NewObject<UProceduralMeshComponent>(this, UProceduralMeshComponent::StaticClass(), *compName));
-			MeshComponents[i]->SetRelativeTransform(FTransform());
-			MeshComponents[i]->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
-
-			MeshComponents[i]->BodyInstance.SetResponseToAllChannels(ECR_Block);
-			MeshComponents[i]->BodyInstance.SetResponseToChannel(ECC_GameTraceChannel1, ECR_Block);
-
-			MeshComponents[i]->bCastDynamicShadow = i == 0 ? TerrainConfigMaster->CastShadows : false;
-			MeshComponents[i]->bCastStaticShadow = i == 0 ? TerrainConfigMaster->CastShadows : false;
-
-			LODStatus.Add(i, ELODStatus::NOT_CREATED);
-
-			// Create material instances
-			if (TerrainConfigMaster->TerrainMaterialInstance && !TerrainConfigMaster->MakeDynamicMaterialInstance)
-			{
-				MaterialInstance = TerrainConfigMaster->TerrainMaterialInstance;
-				MeshComponents[i]->SetMaterial(0, MaterialInstance);
-			}
-			else if (TerrainConfigMaster->TerrainMaterialInstance && TerrainConfigMaster->MakeDynamicMaterialInstance)
-			{
-				MaterialInstances.Add(i, UMaterialInstanceDynamic::Create(TerrainConfigMaster->TerrainMaterialInstance, this));
-				MeshComponents[i]->SetMaterial(0, MaterialInstances[i]);
-			}
-		}
-
-		if (TerrainConfigMaster->GenerateSplatMap)
-		{
-			myTexture = UTexture2D::CreateTransient(TerrainConfigMaster->TileXUnits, TerrainConfigMaster->TileYUnits, EPixelFormat::PF_B8G8R8A8);
-			myTexture->AddressX = TA_Clamp;
-			myTexture->AddressY = TA_Clamp;
-
-			myTexture->UpdateResource();
-
-			myRegion = new FUpdateTextureRegion2D();
-			myRegion->Height = TerrainConfigMaster->TileYUnits;
-			myRegion->Width = TerrainConfigMaster->TileXUnits;
-			myRegion->SrcX = 0;
-			myRegion->SrcY = 0;
-			myRegion->DestX = 0;
-			myRegion->DestY = 0;
-		}
-
-		IsInitalized = true;
-	}
-}
-
-/************************************************************************
- *  Draw a simple quad to use as the water plane
- ************************************************************************/
-bool ACGTile::CreateWaterMesh()
-{
-
-	if (MeshComponents.Num() > 0)
-	{
-		TArray<FVector> myPositions;
-		TArray<FVector> myNormals;
-		TArray<FProcMeshTangent> myTangents;
-		TArray<FVector2D> myUV0;
-		FVector normal;
-		normal = FVector(0.0f, 0.0f, 1.0f);
-		FProcMeshTangent tangent, tangentX;
-
-		myPositions.Reserve(4);
-		myNormals.Reserve(4);
-		myUV0.Reserve(4);
-
-		int32 i = 0;
-		myPositions.Emplace();
-		myNormals.Emplace();
-		myTangents.Emplace();
-		myUV0.Emplace();
-		myPositions[i].X = 0.0f;
-		myPositions[i].Y = 0.0f;
-		myPositions[i].Z = 0.0f;
-		myUV0[i] = FVector2D(0.0f, 0.0f);
-		tangent = FProcMeshTangent(0.0f, 1.0f, 0.0f);
-		myNormals[i] = normal;
-		myTangents[i] = tangent;
-
-		++i;
-
-		myPositions.Emplace();
-		myNormals.Emplace();
-		myTangents.Emplace();
-		myUV0.Emplace();
-		myPositions[i].X = 0.0f;
-		myPositions[i].Y = TerrainConfigMaster->TileYUnits * TerrainConfigMaster->UnitSize;
-		myPositions[i].Z = 0.0f;
-		myUV0[i] = FVector2D(1.0f, 0.0f);
-		tangentX = FProcMeshTangent(0.0f, 1.0f, 0.0f);
-		myNormals[i] = normal;
-		myTangents[i] = tangentX;
-
-		++i;
-
-		myPositions.Emplace();
-		myNormals.Emplace();
-		myTangents.Emplace();
-		myUV0.Emplace();
-		myPositions[i].X = TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize;
-		myPositions[i].Y = TerrainConfigMaster->TileYUnits * TerrainConfigMaster->UnitSize;
-		myPositions[i].Z = 0.0f;
-		myUV0[i] = FVector2D(1.0f, 1.0f);
-
-		tangentX = FProcMeshTangent(0.0f, 1.0f, 0.0f);
-		myNormals[i] = normal;
-		myTangents[i] = tangentX;
-		++i;
-
-		myPositions.Emplace();
-		myNormals.Emplace();
-		myTangents.Emplace();
-		myUV0.Emplace();
-		myPositions[i].X = TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize;
-		myPositions[i].Y = 0.0f;
-		myPositions[i].Z = 0.0f;
-		myUV0[i] = FVector2D(0.0f, 1.0f);
-		tangentX = FProcMeshTangent(0.0f, 1.0f, 0.0f);
-		myNormals[i] = normal;
-		myTangents[i] = tangentX;
-
-		TArray<int32> myIndices;
-		myIndices.Reserve(6);
-		myIndices.Emplace(0);
-		myIndices.Emplace(1);
-		myIndices.Emplace(2);
-		myIndices.Emplace(2);
-		myIndices.Emplace(3);
-		myIndices.Emplace(0);
-
-		MeshComponents[0]->CreateMeshSection(1, myPositions, myIndices, myNormals, myUV0, TArray<FColor>(), myTangents, true);
-
-		myWaterMaterialInstance = UMaterialInstanceDynamic::Create(TerrainConfigMaster->WaterMaterialInstance, this);
-		MeshComponents[0]->SetMaterial(1, myWaterMaterialInstance);
-
-		return true;
-	}
-	return false;
-}
-
-/************************************************************************
-  *  Updates the mesh for a given LOD and starts the transition effects  
-  ************************************************************************/
-void ACGTile::UpdateMesh(uint8 aLOD, bool aIsInPlaceUpdate,
-	TArray<FVector>& aPositions, TArray<FVector>& aNormals, TArray<FProcMeshTangent>& aTangents, TArray<FVector2D>& aUV0s, TArray<FColor>& aColours, TArray<int32>& aTriangles, TArray<FColor>& aTextureData)
-{
-	SCOPE_CYCLE_COUNTER(STAT_RMCUpdate);
-	SetActorHiddenInGame(false);
-
-	PreviousLOD = CurrentLOD;
-	CurrentLOD = aLOD;
-	LODTransitionOpacity = 1.0f;
-
-	for (int32 i = 0; i < TerrainConfigMaster->LODs.Num(); ++i)
-	{
-		if (i == aLOD)
-		{
-			if (LODStatus[i] == ELODStatus::NOT_CREATED)
-			{
-				MeshComponents[i]->CreateMeshSection(0, aPositions, aTriangles, aNormals, aUV0s, aColours, aTangents, TerrainConfigMaster->LODs[aLOD].isCollisionEnabled);
-				MeshComponents[i]->RegisterComponent();
-				LODStatus.Add(i, ELODStatus::TRANSITION);
-			}
-			else
-			{
-				MeshComponents[i]->UpdateMeshSection(0, aPositions, aNormals, aUV0s, aColours, aTangents);
-				LODStatus.Add(i, ELODStatus::TRANSITION);
-			}
-
-			MeshComponents[i]->SetVisibility(true);
-		}
-		else if (!aIsInPlaceUpdate)
-		{
-			MeshComponents[i]->SetVisibility(false);
-		}
-	}
-
-	if (aLOD == 0 && TerrainConfigMaster->GenerateSplatMap && TerrainConfigMaster->MakeDynamicMaterialInstance && MaterialInstances.Num() > 0)
-	{
-
-		myTexture->UpdateTextureRegions(0, 1, myRegion, 4 * TerrainConfigMaster->TileXUnits, 4, (uint8*)aTextureData.GetData());
-
-		MaterialInstances[0]->SetTextureParameterValue("SplatMap", myTexture);
-		myWaterMaterialInstance->SetTextureParameterValue("SplatMap", myTexture);
-	}
-
-	if (TerrainConfigMaster->LODs[aLOD].isCollisionEnabled)
-	{
-		MyWaterMeshComponent->SetCollisionEnabled(TerrainConfigMaster->WaterCollision);
-	}
-	else
-	{
-		MyWaterMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	}
-}
-
-UMaterialInstanceDynamic* ACGTile::GetMaterialInstanceDynamic(const uint8 aLOD)
-{
-	if (aLOD < MaterialInstances.Num() - 1)
-	{
-		return MaterialInstances[aLOD];
-	}
-
-	return nullptr;
-}
+#include "CGTile.h"
+#include "Components/StaticMeshComponent.h"
+#include "Struct/CGMeshData.h"
+#include "Struct/CGTerrainConfig.h"
+
+#include <ProceduralMeshComponent/Public/ProceduralMeshComponent.h>
+#include <Runtime/Engine/Classes/Components/HierarchicalInstancedStaticMeshComponent.h>
+
+DECLARE_CYCLE_STAT(TEXT("CashGenStat ~ RMCUpdate"), STAT_RMCUpdate, STATGROUP_CashGenStat);
+
+static const FName TerrainOpacityParam(TEXT("TerrainOpacity"));
+
+/************************************************************************
+ *  Writes mesh data into a section's vertex and index buffers. Mesh
+ *  data streams aren't TArrays, so this stands in for the copies
+ *  CreateMeshSection would make. Buffers already the right size, as
+ *  for an in place update, are overwritten without reallocating
+ ************************************************************************/
+static void FillProcMeshSection(FProcMeshSection& aSection, const FCGMeshData& aMeshData, const bool aHasCollision)
+{
+	const int32 numVertices = aMeshData.MyPositions.Num();
+	const bool hasRenderData = aMeshData.MyNormals.Num() == numVertices;
+
+	aSection.ProcVertexBuffer.SetNumUninitialized(numVertices, false);
+	aSection.SectionLocalBox = FBox(ForceInit);
+	// Gathered into the order the triangles first use them, which the triangles are already numbered for
+	for (int32 i = 0; i < numVertices; ++i)
+	{
+		const int32 source = aMeshData.MyVertexOrder[i];
+		FProcMeshVertex& vertex = aSection.ProcVertexBuffer[i];
+		vertex.Position = aMeshData.MyPositions[source];
+		if (hasRenderData)
+		{
+			vertex.Normal = aMeshData.MyNormals[source];
+			vertex.Tangent = aMeshData.MyTangents[source];
+			vertex.Color = aMeshData.MyColours[source];
+			vertex.UV0 = aMeshData.MyUV0[source];
+		}
+		else
+		{
+			vertex.Normal = FVector(0.0f, 0.0f, 1.0f);
+			vertex.Tangent = FProcMeshTangent();
+			vertex.Color = FColor(255, 255, 255);
+			vertex.UV0 = FVector2D::ZeroVector;
+		}
+		vertex.UV1 = vertex.UV2 = vertex.UV3 = FVector2D::ZeroVector;
+		aSection.SectionLocalBox += vertex.Position;
+	}
+
+	// Procedural mesh sections only take 32 bit indices, however small the tile
+	const int32 numIndices = aMeshData.MyTriangles.Num();
+	aSection.ProcIndexBuffer.SetNumUninitialized(numIndices, false);
+	FMemory::Memcpy(aSection.ProcIndexBuffer.GetData(), aMeshData.MyTriangles.GetData(), numIndices * sizeof(uint32));
+
+	aSection.bEnableCollision = aHasCollision;
+	aSection.bSectionVisible = true;
+}
+
+ACGTile::ACGTile()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	SphereComponent = CreateDefaultSubobject<USphereComponent>(TEXT("RootComponent"));
+	RootComponent = SphereComponent;
+
+	CurrentLOD = 10;
+	PreviousLOD = 10;
+
+	MyWaterMeshComponent = nullptr;
+	myCollisionMeshComponent = nullptr;
+
+	mySector = FIntVector2(0, 0);
+}
+
+ACGTile::~ACGTile()
+{
+	if (myRegion)
+	{
+		delete myRegion;
+		myRegion = nullptr;
+	}
+}
+
+bool ACGTile::TickTransition(float DeltaSeconds)
+{
+	for (auto& lod : LODStatus)
+	{
+		if (lod.Value == ELODStatus::TRANSITION && MaterialInstances.Num() > 0)
+		{
+			if (LODTransitionOpacity >= -1.0f)
+			{
+				LODTransitionOpacity -= DeltaSeconds;
+
+				if (LODTransitionOpacity > 0.0f)
+				{
+					MaterialInstances[lod.Key]->SetScalarParameterValue(TerrainOpacityParam, 1.0f - LODTransitionOpacity);
+				}
+				else if (PreviousLOD != 10 && PreviousLOD != CurrentLOD)
+				{
+					MaterialInstances[PreviousLOD]->SetScalarParameterValue(TerrainOpacityParam, LODTransitionOpacity + 1.0f);
+				}
+			}
+			else
+			{
+				if (PreviousLOD != 10 && PreviousLOD != CurrentLOD)
+				{
+					MeshComponents[PreviousLOD]->SetVisibility(false);
+				}
+
+				LODTransitionOpacity = 1.0f;
+				lod.Value = ELODStatus::CREATED;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/************************************************************************
+ * Move the tile and make it hidden pending a redraw
+ ************************************************************************/
+void ACGTile::RepositionAndHide(uint8 aNewLOD)
+{
+	SetActorLocation(FVector((TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize * mySector.X) - TerrainConfigMaster->TileOffset.X, (TerrainConfigMaster->TileYUnits * TerrainConfigMaster->UnitSize * mySector.Y) - TerrainConfigMaster->TileOffset.Y, 0.0f));
+
+	SetActorHiddenInGame(true);
+
+	CurrentLOD = aNewLOD;
+}
+
+void ACGTile::BeginPlay()
+{
+	Super::BeginPlay();
+}
+
+void ACGTile::Tick(float DeltaSeconds)
+{
+}
+
+/************************************************************************
+ * Initial setup of the tile, creates components and material instance
+ ************************************************************************/
+void ACGTile::UpdateSettings(FIntVector2 aOffset, FCGTerrainConfig* aTerrainConfig, FVector aWorldOffset)
+{
+	mySector.X = aOffset.X;
+	mySector.Y = aOffset.Y;
+
+	if (!IsInitalized)
+	{
+		CreateComponents(aTerrainConfig, aWorldOffset);
+	}
+	else
+	{
+		// Sections left over from the last sector keep their buffers for UpdateMesh to refill, but none of them show this one
+		for (auto& lod : LODStatus)
+		{
+			lod.Value = ELODStatus::NOT_CREATED;
+		}
+	}
+}
+
+/************************************************************************
+ *  Creates the mesh, water and collision components and material
+ *  instances. Called up front when prewarming, otherwise on the first
+ *  UpdateSettings
+ ************************************************************************/
+void ACGTile::CreateComponents(FCGTerrainConfig* aTerrainConfig, FVector aWorldOffset)
+{
+	if (IsInitalized)
+	{
+		return;
+	}
+
+	WorldOffset = aWorldOffset;
+	TerrainConfigMaster = aTerrainConfig;
+
+	myLODBytes.SetNumZeroed(aTerrainConfig->LODs.Num());
+
+	// Disable tick if we're not doing lod transitions
+
+	SetActorTickEnabled(TerrainConfigMaster->DitheringLODTransitions && aTerrainConfig->LODs.Num() > 1);
+
+	// Headless servers only ever need the collision geometry
+	if (!TerrainConfigMaster->IsCollisionOnly)
+	{
+		FString waterCompName = "WaterSMC";
+		FTransform waterTransform = FTransform(FRotator::ZeroRotator, FVector(TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize * 0.5f, TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize * 0.5f, 0.0f), FVector(TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize * 0.01f, TerrainConfigMaster->TileYUnits * TerrainConfigMaster->UnitSize * 0.01f, 1.0f));
+		MyWaterMeshComponent = NewObject<UStaticMeshComponent>(this, UStaticMeshComponent::StaticClass(), *waterCompName);
+		MyWaterMeshComponent->SetStaticMesh(TerrainConfigMaster->WaterMesh);
+		MyWaterMeshComponent->SetRelativeTransform(waterTransform);
+		MyWaterMeshComponent->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+		MyWaterMeshComponent->RegisterComponent();
+
+		myWaterMaterialInstance = UMaterialInstanceDynamic::Create(TerrainConfigMaster->WaterMaterialInstance, this);
+		MyWaterMeshComponent->SetMaterial(0, myWaterMaterialInstance);
+
+		for (int32 i = 0; i < aTerrainConfig->LODs.Num(); ++i)
+		{
+
+			FString compName = "RMC" + FString::FromInt(i);
+			MeshComponents.Add(i, NewObject<UProceduralMeshComponent>(this, UProceduralMeshComponent::StaticClass(), *compName));
+			MeshComponents[i]->SetRelativeTransform(FTransform());
+			MeshComponents[i]->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+
+			MeshComponents[i]->BodyInstance.SetResponseToAllChannels(ECR_Block);
+			MeshComponents[i]->BodyInstance.SetResponseToChannel(ECC_GameTraceChannel1, ECR_Block);
+
+			MeshComponents[i]->bUseAsyncCooking = TerrainConfigMaster->UseAsyncCollision;
+
+			MeshComponents[i]->bCastDynamicShadow = i == 0 ? TerrainConfigMaster->CastShadows : false;
+			MeshComponents[i]->bCastStaticShadow = i == 0 ? TerrainConfigMaster->CastShadows : false;
+
+			LODStatus.Add(i, ELODStatus::NOT_CREATED);
+
+			// Custom primitive data transitions don't need an instance per LOD, only LOD 0 may need one for the splat map
+			const bool isSharedMaterial = !TerrainConfigMaster->MakeDynamicMaterialInstance ||
+				(TerrainConfigMaster->TransitionMode == ECGLODTransitionMode::CustomPrimitiveData && !(i == 0 && TerrainConfigMaster->GenerateSplatMap));
+
+			// Create material instances
+			if (TerrainConfigMaster->TerrainMaterialInstance && isSharedMaterial)
+			{
+				MaterialInstance = TerrainConfigMaster->TerrainMaterialInstance;
+				MeshComponents[i]->SetMaterial(0, MaterialInstance);
+			}
+			else if (TerrainConfigMaster->TerrainMaterialInstance)
+			{
+				MaterialInstances.Add(i, UMaterialInstanceDynamic::Create(TerrainConfigMaster->TerrainMaterialInstance, this));
+				MeshComponents[i]->SetMaterial(0, MaterialInstances[i]);
+			}
+		}
+
+		for (int32 i = 0; i < TerrainConfigMaster->ScatterRules.Num(); ++i)
+		{
+			const FCGScatterRule& rule = TerrainConfigMaster->ScatterRules[i];
+			FString compName = "Scatter" + FString::FromInt(i);
+			UHierarchicalInstancedStaticMeshComponent* scatterComponent = NewObject<UHierarchicalInstancedStaticMeshComponent>(this, UHierarchicalInstancedStaticMeshComponent::StaticClass(), *compName);
+			scatterComponent->SetStaticMesh(rule.Mesh);
+			scatterComponent->SetRelativeTransform(FTransform());
+			scatterComponent->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+			scatterComponent->SetCollisionEnabled(rule.EnableCollision ? ECollisionEnabled::QueryAndPhysics : ECollisionEnabled::NoCollision);
+			scatterComponent->SetCastShadow(rule.CastShadows);
+			if (rule.CullDistance > 0.0f)
+			{
+				scatterComponent->SetCullDistances(rule.CullDistance, rule.CullDistance);
+			}
+			scatterComponent->RegisterComponent();
+			myScatterComponents.Add(scatterComponent);
+		}
+	}
+
+	// Collision lives on its own hidden component so it can be built at a different radius and resolution to the render LODs
+	if (TerrainConfigMaster->DecoupledCollision)
+	{
+		myCollisionMeshComponent = NewObject<UProceduralMeshComponent>(this, UProceduralMeshComponent::StaticClass(), TEXT("CollisionRMC"));
+		myCollisionMeshComponent->SetRelativeTransform(FTransform());
+		myCollisionMeshComponent->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+		myCollisionMeshComponent->BodyInstance.SetResponseToAllChannels(ECR_Block);
+		myCollisionMeshComponent->BodyInstance.SetResponseToChannel(ECC_GameTraceChannel1, ECR_Block);
+		myCollisionMeshComponent->bUseAsyncCooking = TerrainConfigMaster->UseAsyncCollision;
+		myCollisionMeshComponent->SetVisibility(false);
+		myCollisionMeshComponent->SetCastShadow(false);
+		myCollisionMeshComponent->RegisterComponent();
+
+		if (MyWaterMeshComponent)
+		{
+			MyWaterMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		}
+	}
+
+	if (TerrainConfigMaster->GenerateSplatMap)
+	{
+		myTexture = UTexture2D::CreateTransient(TerrainConfigMaster->TileXUnits, TerrainConfigMaster->TileYUnits, EPixelFormat::PF_B8G8R8A8);
+		myTexture->AddressX = TA_Clamp;
+		myTexture->AddressY = TA_Clamp;
+
+		myTexture->UpdateResource();
+		myTextureBytes = TerrainConfigMaster->TileXUnits * TerrainConfigMaster->TileYUnits * 4;
+
+		myRegion = new FUpdateTextureRegion2D();
+		myRegion->Height = TerrainConfigMaster->TileYUnits;
+		myRegion->Width = TerrainConfigMaster->TileXUnits;
+		myRegion->SrcX = 0;
+		myRegion->SrcY = 0;
+		myRegion->DestX = 0;
+		myRegion->DestY = 0;
+	}
+
+	IsInitalized = true;
+}
+
+/************************************************************************
+ *  Draw a simple quad to use as the water plane
+ ************************************************************************/
+bool ACGTile::CreateWaterMesh()
+{
+
+	if (MeshComponents.Num() > 0)
+	{
+		TArray<FVector> myPositions;
+		TArray<FVector> myNormals;
+		TArray<FProcMeshTangent> myTangents;
+		TArray<FVector2D> myUV0;
+		FVector normal;
+		normal = FVector(0.0f, 0.0f, 1.0f);
+		FProcMeshTangent tangent, tangentX;
+
+		myPositions.Reserve(4);
+		myNormals.Reserve(4);
+		myUV0.Reserve(4);
+
+		int32 i = 0;
+		myPositions.Emplace();
+		myNormals.Emplace();
+		myTangents.Emplace();
+		myUV0.Emplace();
+		myPositions[i].X = 0.0f;
+		myPositions[i].Y = 0.0f;
+		myPositions[i].Z = 0.0f;
+		myUV0[i] = FVector2D(0.0f, 0.0f);
+		tangent = FProcMeshTangent(0.0f, 1.0f, 0.0f);
+		myNormals[i] = normal;
+		myTangents[i] = tangent;
+
+		++i;
+
+		myPositions.Emplace();
+		myNormals.Emplace();
+		myTangents.Emplace();
+		myUV0.Emplace();
+		myPositions[i].X = 0.0f;
+		myPositions[i].Y = TerrainConfigMaster->TileYUnits * TerrainConfigMaster->UnitSize;
+		myPositions[i].Z = 0.0f;
+		myUV0[i] = FVector2D(1.0f, 0.0f);
+		tangentX = FProcMeshTangent(0.0f, 1.0f, 0.0f);
+		myNormals[i] = normal;
+		myTangents[i] = tangentX;
+
+		++i;
+
+		myPositions.Emplace();
+		myNormals.Emplace();
+		myTangents.Emplace();
+		myUV0.Emplace();
+		myPositions[i].X = TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize;
+		myPositions[i].Y = TerrainConfigMaster->TileYUnits * TerrainConfigMaster->UnitSize;
+		myPositions[i].Z = 0.0f;
+		myUV0[i] = FVector2D(1.0f, 1.0f);
+
+		tangentX = FProcMeshTangent(0.0f, 1.0f, 0.0f);
+		myNormals[i] = normal;
+		myTangents[i] = tangentX;
+		++i;
+
+		myPositions.Emplace();
+		myNormals.Emplace();
+		myTangents.Emplace();
+		myUV0.Emplace();
+		myPositions[i].X = TerrainConfigMaster->TileXUnits * TerrainConfigMaster->UnitSize;
+		myPositions[i].Y = 0.0f;
+		myPositions[i].Z = 0.0f;
+		myUV0[i] = FVector2D(0.0f, 1.0f);
+		tangentX = FProcMeshTangent(0.0f, 1.0f, 0.0f);
+		myNormals[i] = normal;
+		myTangents[i] = tangentX;
+
+		TArray<int32> myIndices;
+		myIndices.Reserve(6);
+		myIndices.Emplace(0);
+		myIndices.Emplace(1);
+		myIndices.Emplace(2);
+		myIndices.Emplace(2);
+		myIndices.Emplace(3);
+		myIndices.Emplace(0);
+
+		MeshComponents[0]->CreateMeshSection(1, myPositions, myIndices, myNormals, myUV0, TArray<FColor>(), myTangents, true);
+
+		myWaterMaterialInstance = UMaterialInstanceDynamic::Create(TerrainConfigMaster->WaterMaterialInstance, this);
+		MeshComponents[0]->SetMaterial(1, myWaterMaterialInstance);
+
+		return true;
+	}
+	return false;
+}
+
+/************************************************************************
+  *  Updates the mesh for a given LOD and starts the transition effects  
+  ************************************************************************/
+void ACGTile::UpdateMesh(uint8 aLOD, bool aIsInPlaceUpdate, const FCGMeshData& aMeshData)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RMCUpdate);
+	SetActorHiddenInGame(false);
+
+	PreviousLOD = CurrentLOD;
+	CurrentLOD = aLOD;
+	LODTransitionOpacity = 1.0f;
+
+	for (int32 i = 0; i < TerrainConfigMaster->LODs.Num(); ++i)
+	{
+		if (i == aLOD)
+		{
+			const bool hasCollision = !TerrainConfigMaster->DecoupledCollision && TerrainConfigMaster->LODs[aLOD].isCollisionEnabled;
+			if (myLODBytes[i] == 0)
+			{
+				FProcMeshSection section;
+				FillProcMeshSection(section, aMeshData, hasCollision);
+				MeshComponents[i]->SetProcMeshSection(0, section);
+				MeshComponents[i]->RegisterComponent();
+				LODStatus.Add(i, ELODStatus::TRANSITION);
+				myLODBytes[i] = GetSectionBytes(aMeshData.MyPositions.Num(), aMeshData.MyTriangles.Num(), true, hasCollision);
+			}
+			else
+			{
+				// Same layout as before, so the component's own buffers are refilled in place
+				FProcMeshSection* section = MeshComponents[i]->GetProcMeshSection(0);
+				FillProcMeshSection(*section, aMeshData, hasCollision);
+				MeshComponents[i]->SetProcMeshSection(0, *section);
+				LODStatus.Add(i, ELODStatus::TRANSITION);
+			}
+
+			MeshComponents[i]->SetVisibility(true);
+		}
+		else if (!aIsInPlaceUpdate)
+		{
+			MeshComponents[i]->SetVisibility(false);
+		}
+	}
+
+	if (aLOD == 0 && TerrainConfigMaster->GenerateSplatMap && TerrainConfigMaster->MakeDynamicMaterialInstance && MaterialInstances.Num() > 0)
+	{
+
+		myTexture->UpdateTextureRegions(0, 1, myRegion, 4 * TerrainConfigMaster->TileXUnits, 4, (uint8*)aMeshData.myTextureData.GetData());
+
+		MaterialInstances[0]->SetTextureParameterValue("SplatMap", myTexture);
+		myWaterMaterialInstance->SetTextureParameterValue("SplatMap", myTexture);
+	}
+
+	// With decoupled collision, water collision follows the collision mesh instead
+	if (!TerrainConfigMaster->DecoupledCollision)
+	{
+		if (TerrainConfigMaster->LODs[aLOD].isCollisionEnabled)
+		{
+			MyWaterMeshComponent->SetCollisionEnabled(TerrainConfigMaster->WaterCollision);
+		}
+		else
+		{
+			MyWaterMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		}
+	}
+}
+
+/************************************************************************
+ *  Replaces the collision-only mesh section, cooked asynchronously if
+ *  the terrain config asks for it
+ ************************************************************************/
+void ACGTile::UpdateCollisionMesh(const FCGMeshData& aMeshData)
+{
+	if (!myCollisionMeshComponent)
+	{
+		return;
+	}
+
+	FProcMeshSection section;
+	FillProcMeshSection(section, aMeshData, true);
+	myCollisionMeshComponent->SetProcMeshSection(0, section);
+	myCollisionBytes = GetSectionBytes(aMeshData.MyPositions.Num(), aMeshData.MyTriangles.Num(), false, true);
+	if (MyWaterMeshComponent)
+	{
+		MyWaterMeshComponent->SetCollisionEnabled(TerrainConfigMaster->WaterCollision);
+	}
+}
+
+/************************************************************************
+ *  Drops the collision mesh. Clearing the section queues an empty body
+ *  setup, which supersedes any async cook still in flight
+ ************************************************************************/
+void ACGTile::ClearCollisionMesh()
+{
+	if (!myCollisionMeshComponent)
+	{
+		return;
+	}
+
+	if (myCollisionMeshComponent->GetNumSections() > 0)
+	{
+		myCollisionMeshComponent->ClearAllMeshSections();
+	}
+	myCollisionBytes = 0;
+	if (MyWaterMeshComponent)
+	{
+		MyWaterMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
+}
+
+/************************************************************************
+ *  Custom primitive data transitions. The material reads start time,
+ *  direction and duration and fades itself, so nothing per frame
+ ************************************************************************/
+bool ACGTile::StartFade(const float aStartTime)
+{
+	if (!MeshComponents.Contains(CurrentLOD))
+	{
+		return false;
+	}
+
+	const int32 dataIndex = TerrainConfigMaster->TransitionCustomDataIndex;
+	MeshComponents[CurrentLOD]->SetCustomPrimitiveDataVector3(dataIndex, FVector(aStartTime, 1.0f, TerrainConfigMaster->TransitionDuration));
+	LODStatus.Add(CurrentLOD, ELODStatus::CREATED);
+
+	if (PreviousLOD == 10 || PreviousLOD == CurrentLOD || !MeshComponents.Contains(PreviousLOD) || !MeshComponents[PreviousLOD]->IsVisible())
+	{
+		return false;
+	}
+
+	MeshComponents[PreviousLOD]->SetCustomPrimitiveDataVector3(dataIndex, FVector(aStartTime, -1.0f, TerrainConfigMaster->TransitionDuration));
+	LODStatus.Add(PreviousLOD, ELODStatus::TRANSITION);
+	return true;
+}
+
+void ACGTile::FinishFade(const uint8 aLOD)
+{
+	if (aLOD == CurrentLOD || GetLODStatus(aLOD) != ELODStatus::TRANSITION)
+	{
+		return;
+	}
+
+	MeshComponents[aLOD]->SetVisibility(false);
+	LODStatus.Add(aLOD, ELODStatus::CREATED);
+}
+
+/************************************************************************
+ *  Clears a LOD's mesh section so its vertex/index buffers and body
+ *  setup are freed. The next UpdateMesh at that LOD recreates it
+ ************************************************************************/
+int64 ACGTile::ReleaseLOD(const uint8 aLOD)
+{
+	if (!MeshComponents.Contains(aLOD) || myLODBytes[aLOD] == 0)
+	{
+		return 0;
+	}
+
+	MeshComponents[aLOD]->ClearAllMeshSections();
+	MeshComponents[aLOD]->SetVisibility(false);
+	LODStatus.Add(aLOD, ELODStatus::NOT_CREATED);
+
+	const int64 releasedBytes = myLODBytes[aLOD];
+	myLODBytes[aLOD] = 0;
+	return releasedBytes;
+}
+
+void ACGTile::UpdateScatter(const TArray<TArray<FTransform>>& aInstances)
+{
+	for (int32 i = 0; i < myScatterComponents.Num() && i < aInstances.Num(); ++i)
+	{
+		// Rebuilding the tree once for the whole batch is far cheaper than adding instances one at a time
+		myScatterComponents[i]->ClearInstances();
+		if (aInstances[i].Num() > 0)
+		{
+			myScatterComponents[i]->AddInstances(aInstances[i], false);
+		}
+	}
+}
+
+void ACGTile::ClearScatter()
+{
+	for (UHierarchicalInstancedStaticMeshComponent* scatterComponent : myScatterComponents)
+	{
+		if (scatterComponent->GetInstanceCount() > 0)
+		{
+			scatterComponent->ClearInstances();
+		}
+	}
+}
+
+int64 ACGTile::ReleaseAllMeshData()
+{
+	int64 releasedBytes = myCollisionBytes;
+	ClearCollisionMesh();
+
+	for (int32 i = 0; i < myLODBytes.Num(); ++i)
+	{
+		releasedBytes += ReleaseLOD(i);
+	}
+
+	CurrentLOD = 10;
+	PreviousLOD = 10;
+
+	return releasedBytes;
+}
+
+int64 ACGTile::GetSectionBytes() const
+{
+	int64 totalBytes = 0;
+	for (const int64 bytes : myLODBytes)
+	{
+		totalBytes += bytes;
+	}
+	return totalBytes;
+}
+
+/************************************************************************
+ *  Rough size of a procedural mesh section: the CPU copy the component
+ *  keeps, the GPU vertex/index buffers when it's rendered, and the
+ *  cooked triangle mesh when it has collision
+ ************************************************************************/
+int64 ACGTile::GetSectionBytes(const int32 aNumVertices, const int32 aNumIndices, const bool aIsRendered, const bool aHasCollision)
+{
+	int64 bytes = (int64)aNumVertices * sizeof(FProcMeshVertex) + (int64)aNumIndices * sizeof(uint32);
+	if (aIsRendered)
+	{
+		// Position, packed tangent basis, UV0 and colour
+		bytes += (int64)aNumVertices * (sizeof(FVector) + 8 + sizeof(FVector2D) + sizeof(FColor)) + (int64)aNumIndices * sizeof(uint32);
+	}
+	if (aHasCollision)
+	{
+		bytes += (int64)aNumVertices * sizeof(FVector) + (int64)aNumIndices * sizeof(uint32);
+	}
+	return bytes;
+}
+
+UMaterialInstanceDynamic* ACGTile::GetMaterialInstanceDynamic(const uint8 aLOD)
+{
+	if (aLOD < MaterialInstances.Num() - 1)
+	{
+		return MaterialInstances[aLOD];
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,80 @@
+#include "CashGen/Public/Struct/CGTrajectory.h"
+
+#include <Runtime/Core/Public/Algo/BinarySearch.h>
+#include <Runtime/Core/Public/Misc/FileHelper.h>
+#include <Runtime/Core/Public/Misc/Paths.h>
+
+FVector FCGTrajectory::GetLocation(const float aPreviousTime, const float aTime, bool& aOutIsTeleport) const
+{
+	aOutIsTeleport = false;
+	if (Samples.Num() == 0)
+	{
+		return FVector::ZeroVector;
+	}
+
+	// First sample after aTime, samples are in time order
+	int32 next = Algo::UpperBoundBy(Samples, aTime, [](const FCGTrajectorySample& aSample) { return aSample.Time; });
+	for (int32 i = Algo::UpperBoundBy(Samples, aPreviousTime, [](const FCGTrajectorySample& aSample) { return aSample.Time; }); i < next; ++i)
+	{
+		aOutIsTeleport |= Samples[i].IsTeleport;
+	}
+
+	if (next == 0)
+	{
+		return Samples[0].Location;
+	}
+	if (next >= Samples.Num())
+	{
+		return Samples.Last().Location;
+	}
+
+	const FCGTrajectorySample& from = Samples[next - 1];
+	const FCGTrajectorySample& to = Samples[next];
+	if (to.IsTeleport)
+	{
+		return from.Location;
+	}
+
+	const float span = to.Time - from.Time;
+	const float alpha = span > 0.0f ? (aTime - from.Time) / span : 1.0f;
+	return FMath::Lerp(from.Location, to.Location, alpha);
+}
+
+bool FCGTrajectory::SaveToFile(const FString& aFilename) const
+{
+	FString csv = TEXT("Time,X,Y,Z,Teleport\n");
+	for (const FCGTrajectorySample& sample : Samples)
+	{
+		csv += FString::Printf(TEXT("%.4f,%.2f,%.2f,%.2f,%d\n"), sample.Time, sample.Location.X, sample.Location.Y, sample.Location.Z, sample.IsTeleport ? 1 : 0);
+	}
+	return FFileHelper::SaveStringToFile(csv, *aFilename);
+}
+
+bool FCGTrajectory::LoadFromFile(const FString& aFilename)
+{
+	TArray<FString> lines;
+	if (!FFileHelper::LoadFileToStringArray(lines, *aFilename))
+	{
+		return false;
+	}
+
+	Name = FPaths::GetBaseFilename(aFilename);
+	Samples.Reset(lines.Num());
+
+	// Skip the header
+	for (int32 i = 1; i < lines.Num(); ++i)
+	{
+		TArray<FString> fields;
+		if (lines[i].ParseIntoArray(fields, TEXT(",")) < 5)
+		{
+			continue;
+		}
+
+		FCGTrajectorySample& sample = Samples.AddDefaulted_GetRef();
+		sample.Time = FCString::Atof(*fields[0]);
+		sample.Location = FVector(FCString::Atof(*fields[1]), FCString::Atof(*fields[2]), FCString::Atof(*fields[3]));
+		sample.IsTeleport = FCString::Atoi(*fields[4]) != 0;
+	}
+
+	return Samples.Num() > 0;
+}
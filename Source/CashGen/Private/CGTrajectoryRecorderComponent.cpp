@@ -0,0 +1,71 @@
+#include "CashGen/Public/CGTrajectoryRecorderComponent.h"
+
+#include <Runtime/Core/Public/Misc/Paths.h>
+#include <Runtime/Engine/Classes/GameFramework/Actor.h>
+
+UCGTrajectoryRecorderComponent::UCGTrajectoryRecorderComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+FString UCGTrajectoryRecorderComponent::GetTrajectoryDir()
+{
+	return FPaths::ProfilingDir() / TEXT("CashGen") / TEXT("Trajectories");
+}
+
+void UCGTrajectoryRecorderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	myTrajectory.Name = TrajectoryName;
+	myTrajectory.Samples.Reset();
+	myRecordTime = 0.0f;
+	myTimeSinceSample = 0.0f;
+	RecordSample();
+}
+
+void UCGTrajectoryRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (!TrajectoryName.IsEmpty())
+	{
+		RecordSample();
+		SaveTrajectory(GetTrajectoryDir() / TrajectoryName + TEXT(".csv"));
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCGTrajectoryRecorderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	myRecordTime += DeltaTime;
+	myTimeSinceSample += DeltaTime;
+
+	// Teleports are caught the frame they happen, not at the next interval, so replay jumps at the right time
+	const bool hasJumped = myTrajectory.Samples.Num() > 0 && FVector::DistSquared(GetOwner()->GetActorLocation(), myTrajectory.Samples.Last().Location) > FMath::Square(TeleportDistance);
+	if (myTimeSinceSample >= SampleInterval || hasJumped)
+	{
+		RecordSample();
+	}
+}
+
+bool UCGTrajectoryRecorderComponent::SaveTrajectory(const FString& aFilename) const
+{
+	return myTrajectory.SaveToFile(aFilename);
+}
+
+void UCGTrajectoryRecorderComponent::RecordSample()
+{
+	const AActor* owner = GetOwner();
+	if (!owner)
+	{
+		return;
+	}
+
+	FCGTrajectorySample& sample = myTrajectory.Samples.AddDefaulted_GetRef();
+	sample.Time = myRecordTime;
+	sample.Location = owner->GetActorLocation();
+	sample.IsTeleport = myTrajectory.Samples.Num() > 1 && FVector::DistSquared(sample.Location, myTrajectory.Samples.Last(1).Location) > FMath::Square(TeleportDistance);
+	myTimeSinceSample = 0.0f;
+}
@@ -0,0 +1,285 @@
+#include "CashGen/Public/CGTrajectoryReplay.h"
+#include "CashGen/Public/CGTerrainManager.h"
+#include "CashGen/Public/CGTrajectoryRecorderComponent.h"
+
+#include <Runtime/Core/Public/Misc/CommandLine.h>
+#include <Runtime/Core/Public/Misc/DateTime.h>
+#include <Runtime/Core/Public/Misc/FileHelper.h>
+#include <Runtime/Core/Public/Misc/Paths.h>
+#include <Runtime/Core/Public/Misc/Parse.h>
+#include <Runtime/Engine/Classes/Components/SceneComponent.h>
+#include <Runtime/Engine/Classes/Engine/World.h>
+#include <Runtime/Engine/Public/EngineUtils.h>
+#include <Runtime/RenderCore/Public/RenderCore.h>
+
+DEFINE_LOG_CATEGORY_STATIC(LogCashGenReplay, Log, All);
+
+namespace
+{
+	/** Nearest rank percentile, 0 for an empty set */
+	double GetPercentile(TArray<double> aValues, const double aPercentile)
+	{
+		if (aValues.Num() == 0)
+		{
+			return 0.0;
+		}
+		aValues.Sort();
+		const int32 index = FMath::Clamp(FMath::CeilToInt(aPercentile * aValues.Num()) - 1, 0, aValues.Num() - 1);
+		return aValues[index];
+	}
+}
+
+ACGTrajectoryReplay::ACGTrajectoryReplay()
+	: TerrainManager(nullptr)
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Move the stand-ins before the manager checks its tracked actors
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+}
+
+void ACGTrajectoryReplay::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FString commandLineFiles;
+	if (FParse::Value(FCommandLine::Get(), TEXT("CashGenReplay="), commandLineFiles))
+	{
+		commandLineFiles.ParseIntoArray(TrajectoryFiles, TEXT("+"));
+	}
+
+	if (!TerrainManager)
+	{
+		TActorIterator<ACGTerrainManager> it(GetWorld());
+		TerrainManager = it ? *it : nullptr;
+	}
+
+	for (const FString& file : TrajectoryFiles)
+	{
+		const FString filename = FPaths::IsRelative(file) ? UCGTrajectoryRecorderComponent::GetTrajectoryDir() / file : file;
+		FActorReplay replay;
+		if (!replay.myTrajectory.LoadFromFile(filename))
+		{
+			UE_LOG(LogCashGenReplay, Warning, TEXT("Couldn't load trajectory %s"), *filename);
+			continue;
+		}
+		myDuration = FMath::Max(myDuration, (double)replay.myTrajectory.GetDuration());
+		myReplays.Add(MoveTemp(replay));
+	}
+
+	if (!TerrainManager || myReplays.Num() == 0)
+	{
+		UE_LOG(LogCashGenReplay, Warning, TEXT("Nothing to replay, needs a terrain manager and at least one trajectory"));
+		myIsFinished = true;
+	}
+}
+
+void ACGTrajectoryReplay::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (myIsFinished || !TerrainManager)
+	{
+		return;
+	}
+
+	// The manager sets up its tiles and workers on its first ticks, the clock starts once it's done
+	if (!myIsStarted)
+	{
+		myIsStarted = StartReplay();
+		return;
+	}
+
+	const double previousTime = myTime;
+	myTime += FixedDeltaSeconds;
+
+	for (FActorReplay& replay : myReplays)
+	{
+		bool isTeleport = false;
+		const FVector location = replay.myTrajectory.GetLocation(previousTime, myTime, isTeleport);
+		replay.myActor->SetActorLocation(location, false, nullptr, isTeleport ? ETeleportType::TeleportPhysics : ETeleportType::None);
+		UpdateActor(replay, isTeleport);
+	}
+
+	// Load for this frame. GGameThreadTime is the previous frame's, which is close enough over a run
+	const double nowSeconds = FPlatformTime::Seconds();
+	FReplayFrame& frame = myFrames.AddDefaulted_GetRef();
+	frame.myTime = myTime;
+	frame.myStats = TerrainManager->GetStats();
+	frame.myGameThreadSeconds = FPlatformTime::ToSeconds(GGameThreadTime);
+	const double wallSeconds = nowSeconds - myLastFrameSeconds;
+	frame.myWorkerUtilisation = wallSeconds > 0.0 && frame.myStats.NumWorkerThreads > 0
+		? FPlatformTime::ToSeconds64(frame.myStats.WorkerBusyCycles - myLastWorkerBusyCycles) / (wallSeconds * frame.myStats.NumWorkerThreads)
+		: 0.0;
+	myLastFrameSeconds = nowSeconds;
+	myLastWorkerBusyCycles = frame.myStats.WorkerBusyCycles;
+
+	bool isAnyWaiting = false;
+	for (const FActorReplay& replay : myReplays)
+	{
+		isAnyWaiting |= replay.myIsWaiting;
+	}
+
+	if (myTime >= myDuration && (!isAnyWaiting || myTime >= myDuration + SettleSeconds))
+	{
+		FinishReplay();
+	}
+}
+
+bool ACGTrajectoryReplay::StartReplay()
+{
+	if (!TerrainManager->isReady)
+	{
+		return false;
+	}
+
+	UWorld* world = GetWorld();
+	for (FActorReplay& replay : myReplays)
+	{
+		FActorSpawnParameters spawnParams;
+		spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AActor* actor = world->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, spawnParams);
+		USceneComponent* root = NewObject<USceneComponent>(actor, TEXT("Root"));
+		root->SetMobility(EComponentMobility::Movable);
+		actor->SetRootComponent(root);
+		root->RegisterComponent();
+
+		bool isTeleport = false;
+		actor->SetActorLocation(replay.myTrajectory.GetLocation(0.0f, 0.0f, isTeleport), false, nullptr, ETeleportType::TeleportPhysics);
+		replay.myActor = actor;
+		myActors.Add(actor);
+
+		TerrainManager->AddActorToTrack(actor);
+		UpdateActor(replay, true);
+	}
+
+	myTime = 0.0;
+	myStartSeconds = FPlatformTime::Seconds();
+	myLastFrameSeconds = myStartSeconds;
+	myStartWorkerBusyCycles = TerrainManager->GetStats().WorkerBusyCycles;
+	myLastWorkerBusyCycles = myStartWorkerBusyCycles;
+
+	UE_LOG(LogCashGenReplay, Log, TEXT("Replaying %d trajectories over %.1f seconds"), myReplays.Num(), myDuration);
+	return true;
+}
+
+void ACGTrajectoryReplay::UpdateActor(FActorReplay& aReplay, const bool aIsTeleport)
+{
+	const FIntVector2 sector = TerrainManager->GetSector(aReplay.myActor->GetActorLocation());
+	const bool isReady = TerrainManager->IsSectorReady(sector);
+
+	if (sector != aReplay.mySector || aIsTeleport)
+	{
+		// Left before the last tile was ready, that's pop-in the player would have seen
+		if (aReplay.myIsWaiting && sector != aReplay.mySector)
+		{
+			++aReplay.myNumMissed;
+			aReplay.myIsWaiting = false;
+		}
+		aReplay.mySector = sector;
+
+		if (!aReplay.myIsWaiting)
+		{
+			// Entering a ready sector counts as zero, so the percentiles reflect every sector visited
+			aReplay.myIsWaiting = true;
+			aReplay.myWaitStartTime = myTime;
+			aReplay.myWaitStartSeconds = FPlatformTime::Seconds();
+		}
+	}
+
+	if (aReplay.myIsWaiting && isReady)
+	{
+		aReplay.myReadyTimes.Add(myTime - aReplay.myWaitStartTime);
+		aReplay.myReadySeconds.Add(FPlatformTime::Seconds() - aReplay.myWaitStartSeconds);
+		aReplay.myIsWaiting = false;
+	}
+	else if (!isReady)
+	{
+		++aReplay.myNumNotReadyFrames;
+	}
+}
+
+void ACGTrajectoryReplay::FinishReplay()
+{
+	myIsFinished = true;
+
+	WriteReport();
+
+	for (AActor* actor : myActors)
+	{
+		TerrainManager->RemoveActorToTrack(actor);
+		actor->Destroy();
+	}
+	myActors.Reset();
+
+	if (QuitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void ACGTrajectoryReplay::WriteReport() const
+{
+	const FString baseFilename = FPaths::ProfilingDir() / TEXT("CashGen") / TEXT("Replays") / ReportName + TEXT("-") + FDateTime::Now().ToString();
+
+	// Run wide load, the same on every summary row
+	double maxGameThreadSeconds = 0.0;
+	double totalGameThreadSeconds = 0.0;
+	double totalTickSeconds = 0.0;
+	int32 maxPendingJobs = 0;
+	int32 maxUpdateJobs = 0;
+	for (const FReplayFrame& frame : myFrames)
+	{
+		maxGameThreadSeconds = FMath::Max(maxGameThreadSeconds, frame.myGameThreadSeconds);
+		totalGameThreadSeconds += frame.myGameThreadSeconds;
+		totalTickSeconds += frame.myStats.TickSeconds;
+		maxPendingJobs = FMath::Max(maxPendingJobs, frame.myStats.PendingJobs + frame.myStats.PrefetchJobs);
+		maxUpdateJobs = FMath::Max(maxUpdateJobs, frame.myStats.UpdateJobs);
+	}
+	const int32 numFrames = FMath::Max(myFrames.Num(), 1);
+	const int32 numWorkerThreads = myFrames.Num() > 0 ? myFrames.Last().myStats.NumWorkerThreads : 0;
+	const double runSeconds = myLastFrameSeconds - myStartSeconds;
+	const int64 busyCycles = myFrames.Num() > 0 ? myFrames.Last().myStats.WorkerBusyCycles - myStartWorkerBusyCycles : 0;
+	const double workerUtilisation = runSeconds > 0.0 && numWorkerThreads > 0 ? FPlatformTime::ToSeconds64(busyCycles) / (runSeconds * numWorkerThreads) : 0.0;
+	const FString loadColumns = FString::Printf(TEXT("%d,%.3f,%.3f,%.3f,%.3f,%d,%d,%.3f"),
+		myFrames.Num(), runSeconds,
+		totalGameThreadSeconds * 1000.0 / numFrames, maxGameThreadSeconds * 1000.0, totalTickSeconds * 1000.0 / numFrames,
+		maxPendingJobs, maxUpdateJobs, workerUtilisation);
+
+	FString summary = TEXT("Trajectory,Sectors,Missed,NotReadyFrames,ReadyP50,ReadyP95,ReadyMax,ReadySecondsP50,ReadySecondsP95,ReadySecondsMax,Frames,RunSeconds,GameThreadMsAvg,GameThreadMsMax,ManagerTickMsAvg,MaxPendingJobs,MaxUpdateJobs,WorkerUtilisation\n");
+	TArray<double> allReadyTimes;
+	TArray<double> allReadySeconds;
+	int32 allMissed = 0;
+	int32 allNotReadyFrames = 0;
+	auto addSummaryRow = [&](const FString& aName, const TArray<double>& aReadyTimes, const TArray<double>& aReadySeconds, const int32 aMissed, const int32 aNotReadyFrames)
+	{
+		summary += FString::Printf(TEXT("%s,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%s\n"),
+			*aName, aReadyTimes.Num() + aMissed, aMissed, aNotReadyFrames,
+			GetPercentile(aReadyTimes, 0.5), GetPercentile(aReadyTimes, 0.95), GetPercentile(aReadyTimes, 1.0),
+			GetPercentile(aReadySeconds, 0.5), GetPercentile(aReadySeconds, 0.95), GetPercentile(aReadySeconds, 1.0),
+			*loadColumns);
+	};
+
+	for (const FActorReplay& replay : myReplays)
+	{
+		addSummaryRow(replay.myTrajectory.Name, replay.myReadyTimes, replay.myReadySeconds, replay.myNumMissed, replay.myNumNotReadyFrames);
+		allReadyTimes.Append(replay.myReadyTimes);
+		allReadySeconds.Append(replay.myReadySeconds);
+		allMissed += replay.myNumMissed;
+		allNotReadyFrames += replay.myNumNotReadyFrames;
+	}
+	addSummaryRow(TEXT("All"), allReadyTimes, allReadySeconds, allMissed, allNotReadyFrames);
+
+	FString frames = TEXT("Time,PendingJobs,PrefetchJobs,UpdateJobs,QueuedSectors,GameThreadMs,ManagerTickMs,WorkerUtilisation\n");
+	for (const FReplayFrame& frame : myFrames)
+	{
+		frames += FString::Printf(TEXT("%.4f,%d,%d,%d,%d,%.3f,%.3f,%.3f\n"),
+			frame.myTime, frame.myStats.PendingJobs, frame.myStats.PrefetchJobs, frame.myStats.UpdateJobs, frame.myStats.QueuedSectors,
+			frame.myGameThreadSeconds * 1000.0, frame.myStats.TickSeconds * 1000.0, frame.myWorkerUtilisation);
+	}
+
+	FFileHelper::SaveStringToFile(summary, *(baseFilename + TEXT("-summary.csv")));
+	FFileHelper::SaveStringToFile(frames, *(baseFilename + TEXT("-frames.csv")));
+
+	UE_LOG(LogCashGenReplay, Log, TEXT("Replay done, %d sectors, %d missed, time to ready p50 %.3fs p95 %.3fs, report at %s-*.csv"),
+		allReadyTimes.Num() + allMissed, allMissed, GetPercentile(allReadyTimes, 0.5), GetPercentile(allReadyTimes, 0.95), *baseFilename);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CashGen/Public/Struct/CGMeshData.h"
+#include "CashGen/Public/Struct/CGTerrainConfig.h"
+
+#include "CashGenCore/CashGenCore.h"
+
+static_assert(sizeof(CashGenCore::Vec2) == sizeof(FVector2D), "CashGenCore::Vec2 has to match FVector2D");
+static_assert(sizeof(CashGenCore::Vec3) == sizeof(FVector), "CashGenCore::Vec3 has to match FVector");
+static_assert(sizeof(CashGenCore::Tangent) == sizeof(FProcMeshTangent) && STRUCT_OFFSET(CashGenCore::Tangent, bFlipTangentY) == STRUCT_OFFSET(FProcMeshTangent, bFlipTangentY),
+	"CashGenCore::Tangent has to match FProcMeshTangent");
+static_assert(sizeof(CashGenCore::Color) == sizeof(FColor) && STRUCT_OFFSET(CashGenCore::Color, R) == STRUCT_OFFSET(FColor, R) && STRUCT_OFFSET(CashGenCore::Color, A) == STRUCT_OFFSET(FColor, A),
+	"CashGenCore::Color has to match FColor");
+
+/**
+* Glue between the plugin's types and the engine independent generator core.
+* The core's types are layout compatible with the engine's, so mesh data streams are passed through as they are.
+*/
+struct FCGCoreAdapter
+{
+	/** Layout of a tile at the given LOD. LOD 0 is always full resolution, whatever its divisor says */
+	static CashGenCore::TileLayout GetTileLayout(const FCGTerrainConfig& aConfig, const uint8 aLOD)
+	{
+		return CashGenCore::MakeTileLayout(aConfig.TileXUnits, aConfig.TileYUnits, GetDivisor(aConfig, aLOD));
+	}
+
+	static int32 GetDivisor(const FCGTerrainConfig& aConfig, const uint8 aLOD)
+	{
+		return aLOD == 0 ? 1 : aConfig.LODs[aLOD].ResolutionDivisor;
+	}
+
+	static CashGenCore::Vec2* ToCore(TArrayView<FVector2D> aView) { return reinterpret_cast<CashGenCore::Vec2*>(aView.GetData()); }
+	static CashGenCore::Vec3* ToCore(TArrayView<FVector> aView) { return reinterpret_cast<CashGenCore::Vec3*>(aView.GetData()); }
+	static CashGenCore::Tangent* ToCore(TArrayView<FProcMeshTangent> aView) { return reinterpret_cast<CashGenCore::Tangent*>(aView.GetData()); }
+	static CashGenCore::Color* ToCore(TArrayView<FColor> aView) { return reinterpret_cast<CashGenCore::Color*>(aView.GetData()); }
+};
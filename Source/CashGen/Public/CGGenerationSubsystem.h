@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CashGen/Public/CGMeshDataPools.h"
+#include "CashGen/Public/Struct/CGJob.h"
+
+#include <Runtime/Core/Public/Containers/Ticker.h>
+#include <Runtime/Core/Public/HAL/CriticalSection.h>
+#include <Runtime/Core/Public/HAL/Event.h>
+#include <Runtime/Core/Public/HAL/PlatformProcess.h>
+#include <Runtime/Core/Public/HAL/ThreadSafeCounter.h>
+#include <Runtime/Engine/Public/Subsystems/EngineSubsystem.h>
+
+#include <atomic>
+
+#include "CGGenerationSubsystem.generated.h"
+
+class ACGTerrainManager;
+class FCGTerrainGeneratorWorker;
+class FRunnableThread;
+
+/** A registered terrain manager, as the workers see it */
+struct FCGGenerationClient
+{
+	FCGGenerationClient()
+		: myJobsDoneEvent(FPlatformProcess::GetSynchEventFromPool(true))
+	{
+	}
+
+	~FCGGenerationClient()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(myJobsDoneEvent);
+	}
+
+	ACGTerrainManager* myManager = nullptr;
+	FCGMeshDataPoolsPtr myMeshDataPools;
+	// Workers holding a job for the manager. Unregistering waits for this to drop to zero
+	FThreadSafeCounter myNumActiveJobs;
+	std::atomic<bool> myIsRegistered { true };
+	// Triggered by the worker whose job takes the count to zero once the manager has unregistered
+	FEvent* myJobsDoneEvent;
+};
+
+typedef TSharedPtr<FCGGenerationClient, ESPMode::ThreadSafe> FCGGenerationClientPtr;
+
+/**
+* Generation service shared by every terrain manager in the process. Owns the worker threads, and the mesh data
+* pools, which managers share when their tiles have the same layout.
+*
+* Workers take jobs from the managers in turn, so one manager with a deep queue can't starve the rest, and every
+* manager's pending jobs go before any manager's prefetch jobs.
+*/
+UCLASS()
+class CASHGEN_API UCGGenerationSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	* Game thread, once the manager's config is set up. Returns the pools the manager's jobs borrow from. Registering
+	* again keeps the manager's pools and the workers as they are, unless its tile layout has changed
+	*/
+	FCGMeshDataPoolsPtr RegisterManager(ACGTerrainManager* aManager);
+
+	/** Game thread. Once this returns no worker touches the manager again */
+	void UnregisterManager(ACGTerrainManager* aManager);
+
+	/** Worker threads. The next job in turn, or null if there's nothing queued. Call FinishJob on the client once done with it */
+	FCGGenerationClientPtr DequeueJob(FCGJob& aOutJob);
+	void FinishJob(FCGGenerationClient& aClient);
+
+	int32 GetNumWorkerThreads() const { return myWorkerThreads.Num(); }
+
+private:
+	bool Tick(float aDeltaSeconds);
+	void ReportManagerStats();
+	/** Takes the manager off the client list and waits for its jobs, true if it was registered */
+	bool RemoveClient(ACGTerrainManager* aManager);
+	void StartWorkerThreads();
+	void StopWorkerThreads();
+
+	// Workers read the client list while picking a job, the game thread changes it
+	FCriticalSection myClientsLock;
+	TArray<FCGGenerationClientPtr> myClients;
+	// Client the next job is looked for first
+	int32 myNextClient = 0;
+
+	// Pool sets in use, by layout key
+	TMap<FString, FCGMeshDataPoolsPtr> myMeshDataPools;
+
+	TArray<FRunnableThread*> myWorkerThreads;
+	TArray<FCGTerrainGeneratorWorker*> myWorkers;
+
+	FDelegateHandle myTickHandle;
+	float myTimeSinceLastPoolUpdate = 0.0f;
+	const float myPoolUpdateTime = 2.0f;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CashGen/Public/CGSectorMap.h"
+#include "CashGen/Public/Struct/CGGroundInfo.h"
+#include "CashGen/Public/Struct/CGHeightField.h"
+#include "CashGen/Public/Struct/IntVector2.h"
+
+#include <atomic>
+
+struct FCGTerrainConfig;
+
+/**
+* Heightfields of the resident tiles, for ground queries from any thread without locks.
+*
+* The game thread edits a working map and publishes an immutable copy of it at most once a frame.
+* Readers pin the copy that's current by registering in an epoch, and a replaced copy is only freed
+* once the epoch has moved on twice, by which point no reader can still be holding it.
+*/
+class CASHGEN_API FCGHeightFieldRegistry
+{
+public:
+	typedef TSharedPtr<const FCGHeightField, ESPMode::ThreadSafe> FHeightFieldPtr;
+	typedef TCGSectorMap<FHeightFieldPtr> FSnapshot;
+
+	/** Pins the current snapshot while in scope. Keep scopes short, they hold back reclamation */
+	class CASHGEN_API FReadScope
+	{
+	public:
+		explicit FReadScope(const FCGHeightFieldRegistry& aRegistry);
+		~FReadScope();
+
+		/** Null until the first publish */
+		const FSnapshot* GetSnapshot() const { return mySnapshot; }
+
+	private:
+		const FCGHeightFieldRegistry& myRegistry;
+		uint32 myEpochSlot;
+		const FSnapshot* mySnapshot;
+	};
+
+	FCGHeightFieldRegistry();
+	~FCGHeightFieldRegistry();
+
+	/** Game thread, before any reader. aGridSize sizes the sector maps */
+	void Init(const FCGTerrainConfig& aConfig, const int32 aGridSize);
+
+	/** Game thread. Changes are seen by readers after the next Publish */
+	void Set(const FIntVector2& aSector, const FHeightFieldPtr& aHeightField);
+	void Remove(const FIntVector2& aSector);
+
+	/** Game thread, once a frame. Publishes pending changes and frees snapshots no reader can hold */
+	void Publish();
+
+	/** Game thread, frees everything. Nothing may be reading */
+	void Reset();
+
+	/** Any thread. False if the tile under the point isn't resident */
+	bool GetGroundInfo(const float aX, const float aY, FCGGroundInfo& aOutGroundInfo) const;
+
+	/** As above, against a snapshot already pinned by a read scope */
+	bool GetGroundInfo(const FSnapshot& aSnapshot, const float aX, const float aY, FCGGroundInfo& aOutGroundInfo) const;
+
+	/**
+	* Any thread. Heights and normals for many points, four at a time. The outputs must be at least as long as
+	* aPositions, and points whose tile isn't resident are left untouched with aOutResolved false. Returns the number resolved
+	*/
+	int32 GetGroundInfoBatch(TArrayView<const FVector2D> aPositions, TArrayView<float> aOutHeights, TArrayView<FVector> aOutNormals, TArrayView<bool> aOutResolved) const;
+
+private:
+	struct FRetiredSnapshot
+	{
+		const FSnapshot* mySnapshot;
+		uint64 myEpoch;
+	};
+
+	// Readers registered in each of the last two epochs, by epoch parity
+	mutable std::atomic<int32> myNumReaders[2];
+	std::atomic<uint64> myEpoch;
+	std::atomic<const FSnapshot*> mySnapshot;
+
+	// Game thread only
+	FSnapshot myWorkingSet;
+	bool myIsDirty;
+	TArray<FRetiredSnapshot> myRetiredSnapshots;
+
+	// Tile placement, fixed at Init
+	float myTileSizeX;
+	float myTileSizeY;
+	float myInvTileSizeX;
+	float myInvTileSizeY;
+	float myTileOffsetX;
+	float myTileOffsetY;
+	float myAmplitude;
+	// One over the world distance between height samples, per LOD
+	TArray<float> myInvSampleSpacings;
+};
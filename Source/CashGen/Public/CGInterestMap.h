@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CashGen/Public/CGSectorMap.h"
+#include "CashGen/Public/CGSectorStencil.h"
+#include "CashGen/Public/Struct/CGSector.h"
+#include "CashGen/Public/Struct/IntVector2.h"
+
+/** How many actor footprints cover a sector, at each LOD */
+struct FCGSectorCoverage
+{
+	TArray<uint16, TInlineAllocator<4>> myLODRefs;
+	int32 myTotalRefs = 0;
+
+	int32 GetFinestLOD() const
+	{
+		for (int32 i = 0; i < myLODRefs.Num(); ++i)
+		{
+			if (myLODRefs[i] > 0)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+};
+
+/**
+* Merges the footprints of every tracked actor into one reference counted coverage map.
+*
+* Overlapping footprints only report a sector when its coverage actually changes, so the
+* work done scales with sector transitions rather than with the number of actors.
+*/
+class CASHGEN_API FCGInterestMap
+{
+public:
+	FCGInterestMap();
+
+	/** aRadius is the stencil radius, used to size the coverage grid */
+	void Init(const int32 aNumLODs, const int32 aRadius);
+
+	/** Adds an actor's footprint. Sectors whose finest LOD changed go to aOutChanged */
+	void AddFootprint(const FCGSectorStencil& aStencil, const FIntVector2& aSector, TArray<FCGSector>& aOutChanged);
+
+	/** Removes an actor's footprint. Sectors no longer covered by anyone go to aOutUncovered */
+	void RemoveFootprint(const FCGSectorStencil& aStencil, const FIntVector2& aSector, TArray<FCGSector>& aOutChanged, TArray<FIntVector2>& aOutUncovered);
+
+	/** Moves an actor's footprint, only touching the stencil delta */
+	void MoveFootprint(const FCGSectorStencil& aStencil, const FIntVector2& aOldSector, const FIntVector2& aNewSector, FCGSectorStencilDelta& aScratch, TArray<FCGSector>& aOutChanged, TArray<FIntVector2>& aOutUncovered);
+
+	/** True if any actor's footprint covers the sector */
+	bool IsCovered(const FIntVector2& aSector) const
+	{
+		return myCoverage.Contains(aSector);
+	}
+
+	/** Finest LOD any actor wants for the sector, -1 if it isn't covered */
+	int32 GetFinestLOD(const FIntVector2& aSector) const
+	{
+		const FCGSectorCoverage* coverage = myCoverage.Find(aSector);
+		return coverage ? coverage->GetFinestLOD() : -1;
+	}
+
+	int32 Num() const { return myCoverage.Num(); }
+
+private:
+	void AddRef(const FIntVector2& aSector, const int32 aLOD, TArray<FCGSector>& aOutChanged);
+	void RemoveRef(const FIntVector2& aSector, const int32 aLOD, TArray<FCGSector>& aOutChanged, TArray<FIntVector2>& aOutUncovered);
+
+	int32 myNumLODs;
+	TCGSectorMap<FCGSectorCoverage> myCoverage;
+};
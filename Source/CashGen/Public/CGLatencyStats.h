@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CashGen/Public/Struct/CGJobTimings.h"
+#include "CashGen/Public/Struct/IntVector2.h"
+
+/**
+* Log scale latency histogram over a rolling window.
+* Samples go into the current half and percentiles are read over the current and previous halves,
+* so the window slides along in steps of half its length without keeping any samples.
+*/
+class CASHGEN_API FCGLatencyHistogram
+{
+public:
+	FCGLatencyHistogram();
+
+	void Add(const double aSeconds);
+	/** Drops the previous half and starts filling a new one */
+	void Rotate();
+
+	int64 Num() const;
+	double GetMean() const;
+	double GetMax() const;
+	/** Upper edge of the bucket holding the given percentile (0-1), in seconds */
+	double GetPercentile(const float aPercentile) const;
+
+private:
+	// Four buckets per octave from 1us, the last one takes anything over ~14s
+	static const int32 NumBuckets = 96;
+
+	static int32 GetBucket(const double aSeconds);
+	static double GetBucketUpperSeconds(const int32 aBucket);
+
+	uint32 myCounts[2][NumBuckets];
+	double mySumSeconds[2];
+	double myMaxSeconds[2];
+	int32 myCurrent;
+};
+
+/**
+* Per stage, per LOD job latency histograms shared by every terrain manager, and the
+* CashGen trace channel jobs are reported on. Game thread only.
+*
+* Dump to CSV with the CashGen.DumpLatency console command, record the trace with -trace=cashgen.
+*/
+class CASHGEN_API FCGLatencyStats
+{
+public:
+	static FCGLatencyStats& Get();
+
+	/** Records every stage the job went through, and sends it to the trace channel */
+	void AddJob(const FIntVector2& aSector, const uint8 aLOD, const bool aIsCollisionJob, const FCGJobTimings& aTimings);
+
+	/** Writes p50/p95/p99 for each stage and LOD with samples in the window. Returns false if the file couldn't be written */
+	bool DumpCSV(const FString& aFilename) const;
+	void Reset();
+
+private:
+	FCGLatencyStats();
+
+	FCGLatencyHistogram& GetHistogram(const uint8 aLOD, const ECGJobStage aStage);
+
+	// LOD major, one per stage
+	TArray<FCGLatencyHistogram> myHistograms;
+	double myLastRotateSeconds;
+};
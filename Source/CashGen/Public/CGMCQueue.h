@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 
 /**
@@ -11,6 +12,7 @@ public:
 	void Enqueue(T&& job) {
 		bool success = queue_.Enqueue(std::move(job));
 		check(success);
+		num_++;
 	}
 
 	bool Dequeue(T& job) {
@@ -18,16 +20,28 @@ public:
 		// There is more performant implementations of MC queues, but we don't plan to use this queue
 		// on a perf critical path.
 		std::lock_guard<std::mutex> lock(consumerMutex_);
-		return queue_.Dequeue(job);
+		if (queue_.Dequeue(job)) {
+			num_--;
+			return true;
+		}
+		return false;
 	}
 
 	bool IsEmpty() const {
 		return queue_.IsEmpty();
 	}
 
+	/**
+	* Number of queued items. Only a snapshot while other threads are using the queue.
+	*/
+	int32 Num() const {
+		return FMath::Max(num_.load(), 0);
+	}
+
 private:
 	std::mutex consumerMutex_;
 	TQueue<T, BaseQueueMode> queue_;
+	std::atomic<int32> num_{ 0 };
 };
 
 /**
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CashGen/Public/CGObjectPool.h"
+#include "CashGen/Public/Struct/CGLODMeshData.h"
+#include "CashGen/Public/Struct/CGMeshData.h"
+#include "CashGen/Public/Struct/CGTerrainConfig.h"
+
+#include <Runtime/Core/Public/Async/Future.h>
+
+/** Borrow and slot counts summed over several sets of pools, for the pool stats */
+struct FCGMeshDataPoolTotals
+{
+	int32 NumBorrows = 0;
+	double WaitSeconds = 0.0;
+	int32 NumSlots = 0;
+	int32 NumBorrowed = 0;
+};
+
+/**
+* Per LOD pools of mesh data that workers borrow for each job.
+*
+* A set only depends on the tile layouts of the config it was made from, so terrain managers whose
+* layouts match share one set through UCGGenerationSubsystem. Borrowing is thread safe, everything
+* else is game thread only.
+*/
+class CASHGEN_API FCGMeshDataPools
+{
+public:
+	/** Starts filling the pools on the task pool, workers can borrow the first slots while the rest are allocated */
+	explicit FCGMeshDataPools(const FCGTerrainConfig& aConfig);
+	~FCGMeshDataPools();
+
+	/** Configs with the same key need the same mesh data, so can share pools */
+	static FString GetLayoutKey(const FCGTerrainConfig& aConfig);
+
+	TCGObjectPool<FCGMeshData>& GetPool(const uint8 aLOD) { return myFreeMeshData[aLOD]; }
+	const TCGObjectPool<FCGMeshData>& GetPool(const uint8 aLOD) const { return myFreeMeshData[aLOD]; }
+	int32 NumLODs() const { return myFreeMeshData.Num(); }
+	int64 GetAllocatedBytes() const { return myAllocatedBytes; }
+
+	/** Grows and shrinks the pools from the borrows since the last update, and adds their counts to aTotals */
+	void Update(const float aElapsedSeconds, FCGMeshDataPoolTotals& aTotals);
+
+	/** Publishes pool totals to the CashGen stat group */
+	static void ReportStats(const FCGMeshDataPoolTotals& aTotals);
+
+private:
+	/** Triangles and vertex order every slot of a LOD starts with, built once per LOD */
+	struct FLODTopology
+	{
+		TArray<int32> Triangles;
+		TArray<int32> VertexOrder;
+	};
+
+	void AddMeshData(const uint8 aLOD);
+	void CollectAllocations(const bool aWait);
+	static void BuildTopology(FLODTopology& aTopology, const FCGTerrainConfig& aConfig, const uint8 aLOD);
+	static void AllocateDataStructuresForLOD(FCGMeshData* aData, const FCGTerrainConfig& aConfig, const uint8 aLOD, const FLODTopology& aTopology);
+
+	// Only the tile layout and pool sizes are read from this
+	FCGTerrainConfig myConfig;
+
+	TArray<FCGLODMeshData> myMeshData;
+	TArray<TCGObjectPool<FCGMeshData>> myFreeMeshData;
+	int64 myAllocatedBytes = 0;
+	// Per LOD, the size each pool started at and can shrink back to, and how long it's gone without waits
+	TArray<int32> myMinSizes;
+	TArray<float> myIdleTimes;
+	// Per LOD, the pool slots still being allocated on the task pool after setup
+	TArray<TFuture<TArray<FCGMeshData*>>> myAllocations;
+	// Per LOD, written by the allocation task and only read on the game thread once that's collected
+	TArray<FLODTopology> myTopologies;
+};
+
+typedef TSharedPtr<FCGMeshDataPools, ESPMode::ThreadSafe> FCGMeshDataPoolsPtr;
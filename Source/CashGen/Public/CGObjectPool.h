@@ -6,6 +6,16 @@
 
 template<class T> class TCGBorrowedObject;
 
+/**
+* Borrow counters for a pool, accumulated since they were last consumed.
+*/
+struct FCGObjectPoolStats {
+	int32 NumBorrows = 0;
+	// Borrows that found the pool empty and had to block
+	int32 NumWaits = 0;
+	double WaitSeconds = 0.0;
+};
+
 /**
 * A pool of objects that can be borrowed and returned.
 *
@@ -31,7 +41,36 @@ public:
 	* Add a new object from the pool. After adding it, it can be borrowed.
 	*/
 	void Add(T* object) {
-		impl_->Add(object);
+		impl_->AddNew(object);
+	}
+
+	/**
+	* Take a free object out of the pool for good, so the caller can delete it.
+	* Returns nullptr if every object is currently borrowed.
+	*/
+	T* Remove() {
+		return impl_->Remove();
+	}
+
+	/**
+	* Number of objects owned by the pool, borrowed or not.
+	*/
+	int32 Num() const {
+		return impl_->Num();
+	}
+
+	/**
+	* Number of objects that can be borrowed right now.
+	*/
+	int32 NumFree() const {
+		return impl_->NumFree();
+	}
+
+	/**
+	* Get the borrow counters accumulated since the last call and reset them.
+	*/
+	FCGObjectPoolStats ConsumeStats() {
+		return impl_->ConsumeStats();
 	}
 
 	// Copying and moving is forbidden. Because of Impl, this would
@@ -64,13 +103,57 @@ private:
 			cv_.notify_one();
 		}
 
+		void AddNew(T* object) {
+			check(nullptr != object);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			numObjects_++;
+			freeObjects_.Push(object);
+			cv_.notify_one();
+		}
+
+		T* Remove() {
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (freeObjects_.Num() == 0) {
+				return nullptr;
+			}
+			numObjects_--;
+			return freeObjects_.Pop(false);
+		}
+
+		int32 Num() const {
+			std::lock_guard<std::mutex> lock(mutex_);
+			return numObjects_;
+		}
+
+		int32 NumFree() const {
+			std::lock_guard<std::mutex> lock(mutex_);
+			return freeObjects_.Num();
+		}
+
+		FCGObjectPoolStats ConsumeStats() {
+			std::lock_guard<std::mutex> lock(mutex_);
+			FCGObjectPoolStats stats = stats_;
+			stats_ = FCGObjectPoolStats();
+			return stats;
+		}
+
 		T* Borrow(std::function<bool()> shouldContinueToBlock) {
 			std::unique_lock<std::mutex> lock(mutex_);
+			stats_.NumBorrows++;
+			if (freeObjects_.Num() > 0) {
+				return freeObjects_.Pop(false);
+			}
+
+			// Time how long we're stuck waiting, it's what the pool gets sized by
+			stats_.NumWaits++;
+			const double waitStart = FPlatformTime::Seconds();
 			do {
 				// Block until an object becomes available.
 				// Every 100ms, we check if shouldContinueToBlock still returns true. If not, we abort.
 				if (cv_.wait_for(lock, std::chrono::milliseconds(100), [&]() { return freeObjects_.Num() > 0; })) {
 					// We found an object. Borrow and return it.
+					stats_.WaitSeconds += FPlatformTime::Seconds() - waitStart;
 					return freeObjects_.Pop(false);
 				}
 			} while (shouldContinueToBlock());
@@ -79,9 +162,11 @@ private:
 			throw std::runtime_error("Failed to borrow object from pool");
 		}
 	private:
-		std::mutex mutex_;
+		mutable std::mutex mutex_;
 		std::condition_variable cv_;
 		TArray<T*> freeObjects_;
+		int32 numObjects_ = 0;
+		FCGObjectPoolStats stats_;
 	};
 
 	friend class TCGBorrowedObject<T>;
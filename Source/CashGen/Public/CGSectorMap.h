@@ -0,0 +1,159 @@
+#pragma once
+
+#include "CashGen/Public/Struct/IntVector2.h"
+
+/**
+* Sector keyed map backed by a dense toroidal grid.
+*
+* A sector lives in the grid slot given by its coordinates modulo the grid size, so any
+* sectors that fit inside one grid-sized window never collide and lookups are a mask and
+* a compare. Sectors that land on an occupied slot (actors far apart, tiles lingering
+* behind a moving actor) go to an overflow TMap instead.
+*
+* Not threadsafe, this is only modified from the game thread. Const lookups into a map nobody
+* is modifying are fine from any thread, which is how the height field registry's snapshots are read.
+*/
+template<class ValueType>
+class TCGSectorMap final
+{
+public:
+	TCGSectorMap()
+	{
+		Init(1);
+	}
+
+	/** Drops everything and resizes the grid, aMinGridSize is rounded up to a power of two */
+	void Init(const int32 aMinGridSize)
+	{
+		myGridSize = FMath::RoundUpToPowerOfTwo(FMath::Max(aMinGridSize, 1));
+		myGridMask = myGridSize - 1;
+		myNumDense = 0;
+
+		myOccupied.Reset();
+		myOccupied.SetNumZeroed(myGridSize * myGridSize);
+		myKeys.Reset();
+		myKeys.SetNumZeroed(myGridSize * myGridSize);
+		myValues.Reset();
+		myValues.SetNum(myGridSize * myGridSize);
+		myOverflow.Reset();
+	}
+
+	FORCEINLINE ValueType* Find(const FIntVector2& aSector)
+	{
+		const int32 slot = GetSlot(aSector);
+		if (myOccupied[slot] && myKeys[slot] == aSector)
+		{
+			return &myValues[slot];
+		}
+		return myOverflow.Num() > 0 ? myOverflow.Find(aSector) : nullptr;
+	}
+
+	FORCEINLINE const ValueType* Find(const FIntVector2& aSector) const
+	{
+		return const_cast<TCGSectorMap*>(this)->Find(aSector);
+	}
+
+	FORCEINLINE bool Contains(const FIntVector2& aSector) const
+	{
+		return Find(aSector) != nullptr;
+	}
+
+	/** Adds or replaces the value for the sector */
+	ValueType& Add(const FIntVector2& aSector, const ValueType& aValue)
+	{
+		ValueType& value = FindOrAdd(aSector);
+		value = aValue;
+		return value;
+	}
+
+	ValueType& FindOrAdd(const FIntVector2& aSector)
+	{
+		if (ValueType* existing = Find(aSector))
+		{
+			return *existing;
+		}
+
+		const int32 slot = GetSlot(aSector);
+		if (myOccupied[slot])
+		{
+			return myOverflow.Add(aSector, ValueType());
+		}
+
+		myOccupied[slot] = 1;
+		myKeys[slot] = aSector;
+		myValues[slot] = ValueType();
+		myNumDense++;
+		return myValues[slot];
+	}
+
+	bool Remove(const FIntVector2& aSector)
+	{
+		ValueType value;
+		return RemoveAndCopyValue(aSector, value);
+	}
+
+	bool RemoveAndCopyValue(const FIntVector2& aSector, ValueType& aOutValue)
+	{
+		const int32 slot = GetSlot(aSector);
+		if (myOccupied[slot] && myKeys[slot] == aSector)
+		{
+			aOutValue = MoveTemp(myValues[slot]);
+			myValues[slot] = ValueType();
+			myOccupied[slot] = 0;
+			myNumDense--;
+			return true;
+		}
+		return myOverflow.Num() > 0 && myOverflow.RemoveAndCopyValue(aSector, aOutValue);
+	}
+
+	int32 Num() const { return myNumDense + myOverflow.Num(); }
+
+	/** Number of sectors that didn't fit in the grid, worth watching if the grid is undersized */
+	int32 NumOverflow() const { return myOverflow.Num(); }
+
+	/** Calls aFunc(const FIntVector2&, ValueType&) for every entry, walking the grid in memory order */
+	template<typename FuncType>
+	void ForEach(FuncType aFunc)
+	{
+		if (myNumDense > 0)
+		{
+			for (int32 slot = 0; slot < myOccupied.Num(); ++slot)
+			{
+				if (myOccupied[slot])
+				{
+					aFunc(myKeys[slot], myValues[slot]);
+				}
+			}
+		}
+
+		for (auto& elem : myOverflow)
+		{
+			aFunc(elem.Key, elem.Value);
+		}
+	}
+
+	/** As above, with aFunc(const FIntVector2&, const ValueType&) */
+	template<typename FuncType>
+	void ForEach(FuncType aFunc) const
+	{
+		const_cast<TCGSectorMap*>(this)->ForEach([&aFunc](const FIntVector2& aSector, const ValueType& aValue) { aFunc(aSector, aValue); });
+	}
+
+private:
+	FORCEINLINE int32 GetSlot(const FIntVector2& aSector) const
+	{
+		// Two's complement masking wraps negative sectors round the torus as well
+		return (aSector.X & myGridMask) + (aSector.Y & myGridMask) * myGridSize;
+	}
+
+	int32 myGridSize;
+	int32 myGridMask;
+	int32 myNumDense;
+
+	// Kept apart from the values so lookups only touch the small arrays
+	TArray<uint8> myOccupied;
+	TArray<FIntVector2> myKeys;
+	TArray<ValueType> myValues;
+
+	TMap<FIntVector2, ValueType> myOverflow;
+};
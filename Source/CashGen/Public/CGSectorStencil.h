@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CashGen/Public/Struct/CGLODConfig.h"
+#include "CashGen/Public/Struct/CGSector.h"
+#include "CashGen/Public/Struct/IntVector2.h"
+
+/** What changes when an actor moves between sectors */
+struct FCGSectorStencilDelta
+{
+	// Cells (relative to the new sector) that are new or whose LOD changed, with their new LOD
+	TArray<FCGSector> Entering;
+	// Cells (relative to the old sector) that are no longer covered
+	TArray<FIntVector2> Leaving;
+};
+
+/**
+* The ring/LOD footprint around a tracked actor, precomputed once per terrain config.
+*
+* Cells are stored as offsets from the actor's sector. Moving the actor by a sector
+* in any direction has its delta precomputed too, so a sector change only walks the
+* cells that enter, leave or change LOD.
+*/
+class CASHGEN_API FCGSectorStencil
+{
+public:
+	FCGSectorStencil();
+
+	/** Rebuild the stencil from the LOD radii */
+	void Build(const TArray<FCGLODConfig>& aLODs);
+
+	/** Rebuild the stencil as every sector within aRadius at one LOD, for collision footprints. Empty if aRadius is 0 */
+	void BuildDisc(const int32 aRadius, const uint8 aLOD);
+
+	/** Cells within the largest LOD radius, nearest first */
+	const TArray<FCGSector>& GetCells() const { return myCells; }
+
+	/** Largest LOD radius in sectors */
+	int32 GetRadius() const { return myRadius; }
+
+	/** LOD for a sector at the given offset from the actor, -1 if it's outside the stencil */
+	FORCEINLINE int32 GetLODAtOffset(const int32 aX, const int32 aY) const
+	{
+		const int32 gridX = aX + myRadius;
+		const int32 gridY = aY + myRadius;
+		if ((uint32)gridX >= (uint32)myGridSize || (uint32)gridY >= (uint32)myGridSize)
+		{
+			return -1;
+		}
+		return myLODGrid[gridX + gridY * myGridSize];
+	}
+
+	FORCEINLINE int32 GetLODAtOffset(const FIntVector2& aOffset) const
+	{
+		return GetLODAtOffset(aOffset.X, aOffset.Y);
+	}
+
+	/**
+	* Works out what changes when the actor moves by aMove sectors.
+	* Single sector moves return a precomputed delta, anything larger is computed into aScratch.
+	*/
+	const FCGSectorStencilDelta& GetDelta(const FIntVector2& aMove, FCGSectorStencilDelta& aScratch) const;
+
+private:
+	void Reset(const int32 aRadius);
+	void AddCell(const int32 aX, const int32 aY, const int32 aLOD);
+	void Finish();
+	int32 GetLODForRange(const TArray<FCGLODConfig>& aLODs, const int32 aRange) const;
+	void ComputeDelta(const FIntVector2& aMove, FCGSectorStencilDelta& aOutDelta) const;
+
+	int32 myRadius;
+	int32 myGridSize;
+	// Dense (2r+1)^2 grid of LODs, -1 outside the stencil
+	TArray<int8> myLODGrid;
+	TArray<FCGSector> myCells;
+
+	// Deltas for single sector moves, indexed by (x + 1) + (y + 1) * 3
+	FCGSectorStencilDelta myUnitDeltas[9];
+};
@@ -1,44 +1,53 @@
-#pragma once
-#include "CashGen/Public/CGTerrainManager.h"
-#include "CashGen/Public/Struct/CGMeshData.h"
-#include "CashGen/Public/Struct/CGTerrainConfig.h"
-
-struct FCGJob;
-
-class CASHGEN_API FCGTerrainGeneratorWorker : public FRunnable
-{
-public:
-	FCGTerrainGeneratorWorker(ACGTerrainManager& aTerrainManager,
-		FCGTerrainConfig& aTerrainConfig, TArray<TCGObjectPool<FCGMeshData>>& meshDataPoolPerLOD);
-
-	virtual ~FCGTerrainGeneratorWorker();
-
-	virtual bool Init();
-	virtual uint32 Run();
-	virtual void Stop();
-	virtual void Exit();
-
-private:
-	ACGTerrainManager& pTerrainManager;
-	FCGTerrainConfig& pTerrainConfig;
-	TArray<TCGObjectPool<FCGMeshData>>& pMeshDataPoolsPerLOD;
-	FCGJob workJob;
-	uint8 workLOD;
-
-	FCGMeshData* pMeshData;
-
-	bool IsThreadFinished;
-
-	void prepMaps();
-	void ProcessTerrainMap();
-	void ProcessPerBlockGeometry();
-	void ProcessPerVertexTasks();
-	void ProcessSkirtGeometry();
-	TCGBorrowedObject<FCGMeshData> BorrowMeshData();
-
-	void GetNormalFromHeightMapForVertex(const int32& vertexX, const int32& vertexY, FVector& aOutNormal); // , FVector& aOutTangent);
-
-	void UpdateOneBlockGeometry(const int32& aX, const int32& aY, int32& aVertCounter, int32& triCounter);
-
-	int32 GetNumberOfNoiseSamplePoints();
-};
+#pragma once
+#include "CashGen/Public/CGGenerationSubsystem.h"
+#include "CashGen/Public/CGTerrainManager.h"
+#include "CashGen/Public/Struct/CGMeshData.h"
+#include "CashGen/Public/Struct/CGTerrainConfig.h"
+
+#include "CashGenCore/Kernels.h"
+#include "CashGenCore/TileLayout.h"
+
+struct FCGJob;
+
+class CASHGEN_API FCGTerrainGeneratorWorker : public FRunnable
+{
+public:
+	explicit FCGTerrainGeneratorWorker(UCGGenerationSubsystem& aSubsystem);
+
+	virtual ~FCGTerrainGeneratorWorker();
+
+	virtual bool Init();
+	virtual uint32 Run();
+	virtual void Stop();
+	virtual void Exit();
+
+private:
+	UCGGenerationSubsystem& pSubsystem;
+	// The manager the current job came from, and its config and pools
+	ACGTerrainManager* pTerrainManager;
+	FCGTerrainConfig* pTerrainConfig;
+	FCGMeshDataPools* pMeshDataPools;
+	FCGJob workJob;
+	uint8 workLOD;
+	CashGenCore::TileLayout workLayout;
+	// Picked with the layout, the same ones serve every stage of the job
+	const CashGenCore::TileKernels* workKernels;
+
+	FCGMeshData* pMeshData;
+
+	bool IsThreadFinished;
+
+	void prepMaps();
+	void ProcessTerrainMap();
+	void ProcessCurvature();
+	bool CanSubsampleHeightField() const;
+	void ProcessSubsampledTerrainMap();
+	void CaptureHeightField();
+	void ProcessScatter();
+	void ProcessPerBlockGeometry();
+	void ProcessPerVertexTasks();
+	void ProcessSkirtGeometry();
+
+	/** World distance between heightmap samples at the job's LOD */
+	int32 GetSampleSpacing() const;
+};
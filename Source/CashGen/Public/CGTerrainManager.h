@@ -1,117 +1,252 @@
-#pragma once
-
-#include "CashGen/Public/CGMcQueue.h"
-#include "CashGen/Public/CGObjectPool.h"
-#include "CashGen/Public/CGSettings.h"
-#include "CashGen/Public/WorldHeightInterface.h"
-#include "CashGen/Public/Struct/CGJob.h"
-#include "CashGen/Public/Struct/CGLODMeshData.h"
-#include "CashGen/Public/Struct/CGMeshData.h"
-#include "CashGen/Public/Struct/CGSector.h"
-#include "CashGen/Public/Struct/CGTerrainConfig.h"
-#include "CashGen/Public/Struct/CGTileHandle.h"
-#include "CashGen/Public/Struct/IntVector2.h"
-
-#include <Runtime/Engine/Classes/Components/HierarchicalInstancedStaticMeshComponent.h>
-#include <Runtime/Engine/Classes/GameFramework/Actor.h>
-
-#include "CGTerrainManager.generated.h"
-
-class ACGTile;
-
-UCLASS(BlueprintType, Blueprintable)
-class CASHGEN_API ACGTerrainManager : public AActor
-{
-	GENERATED_BODY()
-
-public:
-	ACGTerrainManager();
-	~ACGTerrainManager();
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "CashGen")
-	UCGSettings* Settings = GetMutableDefault<UCGSettings>();
-
-	/* Event called when initial terrain generation is complete */
-	DECLARE_EVENT(ACGTerrainManager, FTerrainCompleteEvent)
-	FTerrainCompleteEvent& OnTerrainComplete() { return TerrainCompleteEvent; }
-
-	/* Returns true once terrain has been configured */
-	bool isReady = false;
-
-	/* Main entry point for starting terrain generation */
-	UFUNCTION(BlueprintCallable, Category = "CashGen")
-	void SetupTerrainGenerator(TScriptInterface<IWorldHeightInterface> worldHeightInterface);
-
-	/* Add a new actor to track and generate terrain tiles around */
-	UFUNCTION(BlueprintCallable, Category = "CashGen")
-	void AddActorToTrack(AActor* aActor);
-
-	/* Add a new actor to track and generate terrain tiles around */
-	UFUNCTION(BlueprintCallable, Category = "CashGen")
-	void RemoveActorToTrack(AActor* aActor);
-
-	// Pending job queue, worker threads take jobs from here
-	TCGSpmcQueue<FCGJob> myPendingJobQueue;
-
-	// Update queue, jobs get sent here from the worker thread
-	TQueue<FCGJob, EQueueMode::Mpsc> myUpdateJobQueue;
-
-	virtual void BeginPlay() override;
-	virtual void Tick(float DeltaSeconds) override;
-	void BeginDestroy() override;
-
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "CashGen")
-	UHierarchicalInstancedStaticMeshComponent* MyWaterMeshComponent;
-
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "CashGen")
-	FCGTerrainConfig myTerrainConfig;
-
-	UFUNCTION(BlueprintImplementableEvent, Category = "CashGen|Events")
-	void OnAfterTileCreated(ACGTile* tile);
-
-protected:
-	void BroadcastTerrainComplete()
-	{
-		TerrainCompleteEvent.Broadcast();
-	}
-
-private:
-	void SetActorSector(const AActor* aActor, const FIntVector2& aNewSector);
-	void AllocateAllMeshDataStructures();
-	bool AllocateDataStructuresForLOD(FCGMeshData* aData, FCGTerrainConfig* aConfig, const uint8 aLOD);
-	int GetLODForRange(const int32 aRange);
-	void CreateTileRefreshJob(FCGJob aJob);
-	void ProcessTilesForActor(const AActor* anActor);
-	TPair<ACGTile*, int32> GetAvailableTile();
-	void FreeTile(ACGTile* aTile, const int32& aWaterMeshIndex);
-	FIntVector2 GetSector(const FVector& aLocation);
-	TArray<FCGSector> GetRelevantSectorsForActor(const AActor* aActor);
-
-	FTerrainCompleteEvent TerrainCompleteEvent;
-
-	// Threads
-	TArray<FRunnableThread*> myWorkerThreads;
-
-	// Geometry data storage
-	UPROPERTY()
-	TArray<FCGLODMeshData> myMeshData;
-	TArray<TCGObjectPool<FCGMeshData>> myFreeMeshData;
-
-	// Tile/Sector tracking
-	TArray<ACGTile*> myFreeTiles;
-	TArray<int32> myFreeWaterMeshIndices;
-	UPROPERTY()
-	TMap<FIntVector2, FCGTileHandle> myTileHandleMap;
-	TSet<FIntVector2> myQueuedSectors;
-
-	// Actor tracking
-	TArray<AActor*> myTrackedActors;
-	TMap<AActor*, FIntVector2> myActorLocationMap;
-
-		// Sweep tracking
-	float myTimeSinceLastSweep = 0.0f;
-	const float mySweepTime = 2.0f;
-	uint8 myActorIndex = 0;
-
-	bool myIsTerrainComplete = false;
+#pragma once
+
+#include "CashGen/Public/CGHeightFieldRegistry.h"
+#include "CashGen/Public/CGInterestMap.h"
+#include "CashGen/Public/CGMcQueue.h"
+#include "CashGen/Public/CGMeshDataPools.h"
+#include "CashGen/Public/CGSectorMap.h"
+#include "CashGen/Public/CGSectorStencil.h"
+#include "CashGen/Public/CGSettings.h"
+#include "CashGen/Public/WorldHeightInterface.h"
+#include "CashGen/Public/Struct/CGCollisionConfig.h"
+#include "CashGen/Public/Struct/CGGroundInfo.h"
+#include "CashGen/Public/Struct/CGJob.h"
+#include "CashGen/Public/Struct/CGLODFade.h"
+#include "CashGen/Public/Struct/CGPrefetch.h"
+#include "CashGen/Public/Struct/CGSector.h"
+#include "CashGen/Public/Struct/CGTerrainConfig.h"
+#include "CashGen/Public/Struct/CGTerrainStats.h"
+#include "CashGen/Public/Struct/CGTileExpiry.h"
+#include "CashGen/Public/Struct/CGTileHandle.h"
+#include "CashGen/Public/Struct/IntVector2.h"
+
+#include <Runtime/Core/Public/HAL/ThreadSafeCounter64.h>
+#include <Runtime/Engine/Classes/Components/HierarchicalInstancedStaticMeshComponent.h>
+#include <Runtime/Engine/Classes/GameFramework/Actor.h>
+
+#include "CGTerrainManager.generated.h"
+
+class ACGTile;
+class UCGGenerationSubsystem;
+
+UCLASS(BlueprintType, Blueprintable)
+class CASHGEN_API ACGTerrainManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACGTerrainManager();
+	~ACGTerrainManager();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "CashGen")
+	UCGSettings* Settings = GetMutableDefault<UCGSettings>();
+
+	/* Event called when initial terrain generation is complete */
+	DECLARE_EVENT(ACGTerrainManager, FTerrainCompleteEvent)
+	FTerrainCompleteEvent& OnTerrainComplete() { return TerrainCompleteEvent; }
+
+	/* Event called once the tiles in every tracked actor's collision radius are at their final LOD, with collision */
+	DECLARE_EVENT(ACGTerrainManager, FNearTerrainReadyEvent)
+	FNearTerrainReadyEvent& OnNearTerrainReady() { return NearTerrainReadyEvent; }
+
+	/* Returns true once terrain has been configured */
+	bool isReady = false;
+
+	/* Main entry point for starting terrain generation */
+	UFUNCTION(BlueprintCallable, Category = "CashGen")
+	void SetupTerrainGenerator(TScriptInterface<IWorldHeightInterface> worldHeightInterface);
+
+	/* Add a new actor to track and generate terrain tiles around */
+	UFUNCTION(BlueprintCallable, Category = "CashGen")
+	void AddActorToTrack(AActor* aActor);
+
+	/* Add a new actor to track and generate terrain tiles around */
+	UFUNCTION(BlueprintCallable, Category = "CashGen")
+	void RemoveActorToTrack(AActor* aActor);
+
+	/* Override the collision radius and resolution for a tracked actor */
+	UFUNCTION(BlueprintCallable, Category = "CashGen")
+	void SetActorCollisionConfig(AActor* aActor, const FCGCollisionConfig& aCollisionConfig);
+
+	// Pending job queue, worker threads take jobs from here
+	TCGSpmcQueue<FCGJob> myPendingJobQueue;
+
+	// Low priority queue for prefetching, only taken from when the pending queue is empty
+	TCGSpmcQueue<FCGJob> myPrefetchJobQueue;
+
+	// Update queue, jobs get sent here from the worker thread
+	TQueue<FCGJob, EQueueMode::Mpsc> myUpdateJobQueue;
+	FThreadSafeCounter myUpdateJobQueueDepth;
+
+	// Cycles the workers have spent generating, waits excluded
+	FThreadSafeCounter64 myWorkerBusyCycles;
+
+	/** Queue depths, worker time and game thread time, for profiling */
+	FCGTerrainStats GetStats() const;
+
+	/** True once the tile for the sector is built and showing at the LOD it's wanted at */
+	bool IsSectorReady(const FIntVector2& aSector) const;
+
+	/** True once every sector in each tracked actor's collision radius is ready and has collision */
+	bool IsNearTerrainReady() const;
+
+	FIntVector2 GetSector(const FVector& aLocation) const;
+
+	/** Surface height, normal and slope at a world XY from the resident heightmaps, no collision needed. Lock-free, safe from any thread. False if the tile isn't generated yet */
+	UFUNCTION(BlueprintCallable, Category = "CashGen|Queries")
+	bool GetGroundInfo(const float aX, const float aY, FCGGroundInfo& aOutGroundInfo) const;
+
+	/**
+	* Heights and normals for many world XY points at once, vectorised over the resident heightmaps. Safe from any thread.
+	* Points on tiles that aren't generated come back with aOutResolved false, unless aUseHeightProvider evaluates them
+	* through the world height interface instead, at three calls a point. That fallback is only as thread safe as the
+	* interface's implementation, which Blueprint ones aren't, so only use it off the game thread with a native one.
+	* Returns the number resolved
+	*/
+	int32 GetGroundInfoBatch(TArrayView<const FVector2D> aPositions, TArrayView<float> aOutHeights, TArrayView<FVector> aOutNormals, TArrayView<bool> aOutResolved, const bool aUseHeightProvider = false) const;
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+	void BeginDestroy() override;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "CashGen")
+	UHierarchicalInstancedStaticMeshComponent* MyWaterMeshComponent;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "CashGen")
+	FCGTerrainConfig myTerrainConfig;
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "CashGen|Events")
+	void OnAfterTileCreated(ACGTile* tile);
+
+protected:
+	void BroadcastTerrainComplete()
+	{
+		myTerrainCompleteTime = FPlatformTime::Seconds();
+		TerrainCompleteEvent.Broadcast();
+	}
+
+	void BroadcastNearTerrainReady()
+	{
+		NearTerrainReadyEvent.Broadcast();
+	}
+
+private:
+	void SetActorSector(const AActor* aActor, const FIntVector2& aNewSector);
+	static UCGGenerationSubsystem* GetGenerationSubsystem();
+	void CreateTileRefreshJob(FCGJob aJob);
+	void AddQueuedJob(const FIntVector2& aSector);
+	void FinishQueuedJob(const FIntVector2& aSector);
+	void SweepActorSectors();
+	void ApplyInterestChanges();
+	void ReselectScreenSpaceErrorLODs(const FIntVector2& aAroundSector);
+	void RequireSector(const FCGSector& aSector, const bool aIsRefinement = false);
+	void IssueRefinements();
+	FCGTileHandle SpawnTileForSector(const FCGSector& aSector);
+	void PrefetchSectorsForActor(const AActor* anActor);
+	void CancelPrefetch(const FIntVector2& aSector);
+	void ReleaseSector(const FIntVector2& aSector);
+	TPair<ACGTile*, int32> GetAvailableTile();
+	void PrewarmTiles();
+	void FreeTile(ACGTile* aTile, const int32& aWaterMeshIndex);
+	float GetInvSectorSizeX() const { return 1.0f / (myTerrainConfig.TileXUnits * myTerrainConfig.UnitSize); }
+	float GetInvSectorSizeY() const { return 1.0f / (myTerrainConfig.TileYUnits * myTerrainConfig.UnitSize); }
+	void ApplyCollisionChanges();
+	const FCGCollisionConfig& GetCollisionConfig(AActor* aActor) const;
+	const FCGSectorStencil& GetCollisionStencil(const FCGCollisionConfig& aConfig);
+	void RequestTileCollision(const FIntVector2& aSector, FCGTileHandle& aTileHandle, const uint8 aLOD);
+	void CancelTileCollision(FCGTileHandle& aTileHandle);
+	void UpdateMemoryBudget();
+	int32 GetNearestActorDistanceSq(const FIntVector2& aSector) const;
+	bool HasDecoupledCollision() const { return myTerrainConfig.DecoupledCollision && myTerrainConfig.LODs.Num() > 0; }
+	bool IsScreenSpaceErrorLOD() const { return myTerrainConfig.UseScreenSpaceErrorLOD && !myTerrainConfig.IsCollisionOnly; }
+	bool IsProgressiveRefinement() const { return myTerrainConfig.ProgressiveRefinement && !myTerrainConfig.IsCollisionOnly && myTerrainConfig.LODs.Num() > 1; }
+	bool IsHeightFieldNeededForDowngrades(const FCGHeightField& aHeightField, const uint8 aLOD) const;
+	uint8 SelectScreenSpaceErrorLOD(const FIntVector2& aSector, const uint8 aCurrentLOD, const float aCurvature) const;
+	void SetTileStatus(const FIntVector2& aSector, const uint32 aSpawnId, const ETileStatus aStatus);
+	void FinishTileTransition(const ACGTile* aTile);
+	void UpdateStats();
+
+	FTerrainCompleteEvent TerrainCompleteEvent;
+	FNearTerrainReadyEvent NearTerrainReadyEvent;
+
+	// Geometry data storage, owned by the generation subsystem and shared with managers of the same tile layout
+	FCGMeshDataPoolsPtr myMeshDataPools;
+
+	// Tile/Sector tracking
+	TArray<ACGTile*> myFreeTiles;
+	TArray<int32> myFreeWaterMeshIndices;
+	int32 myTilesToPrewarm = 0;
+	// Tiles prewarming aims for, the memory governor never destroys tiles below it
+	int32 myPrewarmedTileFloor = 0;
+	// Tile actors are owned by the level, so the handles don't need to be seen by GC
+	TCGSectorMap<FCGTileHandle> myTileHandleMap;
+	// Jobs in flight per sector, from being queued until they come back through the update queue, cancelled or not.
+	// A sector can have several at once, render and collision or an old spawn's and a respawn's
+	TMap<FIntVector2, int32> myQueuedSectors;
+	TMap<FIntVector2, FCGPrefetch> myPrefetchedSectors;
+	// Progressive mode, sectors showing the coarse LOD and the LOD they're still to be refined to
+	TMap<FIntVector2, uint8> myRefinements;
+	// Refinements ready to issue, a heap by distance to the nearest actor. Only rebuilt once the sweep, an upload or a new
+	// refinement has made it stale, entries that went stale in between are skipped as they're popped
+	TArray<TPair<int32, FCGSector>> myRefinementCandidates;
+	bool myAreRefinementCandidatesStale = true;
+	// Heightmaps of the generated tiles, published once a frame for ground queries
+	FCGHeightFieldRegistry myHeightFieldRegistry;
+
+	// Tile expiry, a min-heap on expiry time so each frame only touches tiles that are due
+	TArray<FCGTileExpiry> myTileExpiryHeap;
+	uint32 myLastSpawnId = 0;
+	TArray<ACGTile*> myTransitioningTiles;
+	TArray<FCGLODFade> myLODFades;
+
+	// Monotonic clock, read once per frame
+	double myFrameTime = 0.0;
+
+	// Ring/LOD footprint around each actor, built from the LOD config
+	FCGSectorStencil myStencil;
+	FCGSectorStencilDelta myStencilDeltaScratch;
+
+	// All actor footprints merged into one reference counted coverage map
+	FCGInterestMap myInterestMap;
+	TArray<FCGSector> myChangedSectors;
+	TArray<FIntVector2> myUncoveredSectors;
+
+	// Actor tracking
+	TArray<AActor*> myTrackedActors;
+	TMap<AActor*, FIntVector2> myActorLocationMap;
+	TSet<const AActor*> myPrefetchingActors;
+
+	// Actor positions and sectors as SoA, parallel to myTrackedActors and padded to a multiple of 4 for the sweep
+	TArray<float, TAlignedHeapAllocator<16>> myActorPositionsX;
+	TArray<float, TAlignedHeapAllocator<16>> myActorPositionsY;
+	TArray<float, TAlignedHeapAllocator<16>> myActorSectorsX;
+	TArray<float, TAlignedHeapAllocator<16>> myActorSectorsY;
+	TArray<int32> myMovedActors;
+	// Where each moved actor came from, parallel to myMovedActors
+	TArray<FIntVector2> myMovedActorsFrom;
+	TMap<AActor*, FCGCollisionConfig> myActorCollisionMap;
+
+	// Collision footprints merged the same way, finest LOD wins where they overlap. One stencil per radius and LOD in use
+	FCGInterestMap myCollisionMap;
+	TMap<int32, FCGSectorStencil> myCollisionStencils;
+	TArray<FCGSector> myCollisionChangedSectors;
+	TArray<FIntVector2> myCollisionUncoveredSectors;
+
+		// Sweep tracking
+	float myTimeSinceLastSweep = 0.0f;
+	const float mySweepTime = 2.0f;
+
+	bool myIsTerrainComplete = false;
+	bool myIsNearTerrainReady = false;
+	double myTerrainCompleteTime = 0.0;
+	// Render and collision jobs uploaded since myJobRateStartTime, for the jobs per second stat
+	int32 myNumCompletedJobs = 0;
+	double myJobRateStartTime = 0.0;
+	float myJobsPerSecond = 0.0f;
+	// What the last memory budget pass found the tiles holding
+	int64 myLastSectionBytes = 0;
+	int64 myLastCollisionBytes = 0;
+	int64 myLastTextureBytes = 0;
+	int64 myLastHeightFieldBytes = 0;
+	double myLastTickSeconds = 0.0;
 };
\ No newline at end of file
@@ -33,12 +33,20 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Cashgen")
 	bool TeleportToSurfaceOnTerrainComplete  = false;
 
+	/* Use a different collision radius and resolution for this actor than the terrain manager default */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Cashgen")
+	bool OverrideCollisionConfig = false;
+
+	/* Collision radius and resolution for this actor, only used with decoupled collision */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Cashgen", meta = (EditCondition = "OverrideCollisionConfig"))
+	FCGCollisionConfig CollisionConfig;
+
 	void OnTerrainComplete();
 
 	FVector mySpawnLocation;
 	ACGTerrainManager* MyTerrainManager;
 
-	/* Attempts to teleport character to terrain surface when terrain generation is complete */
+	/* Spawn point candidates checked against the terrain heightmaps per frame */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Cashgen")
 	int32 SpawnRayCastsPerFrame = 10;
 
@@ -50,5 +58,6 @@ protected:
 
 	bool isTerrainComplete = false;
 	bool isSpawnPointFound = false;
+	bool isSpawnComplete = false;
 
 };
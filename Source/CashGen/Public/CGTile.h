@@ -1,75 +1,113 @@
-#pragma once
-
-#include "Cashgen/Public/Struct/IntVector2.h"
-
-#include <Runtime/Engine/Classes/Components/SphereComponent.h>
-#include <ProceduralMeshComponent/Public/ProceduralMeshComponent.h>
-
-#include "CGTile.generated.h"
-
-class UStaticMeshComponent;
-struct FCGTerrainConfig;
-
-UENUM(BlueprintType)
-enum class ELODStatus : uint8
-{ 
-	NOT_CREATED, 
-	CREATED, 
-	TRANSITION
-};
-
-UCLASS()
-class CASHGEN_API ACGTile : public AActor
-{
-	GENERATED_BODY()
-
-	TMap<uint8, UProceduralMeshComponent*> MeshComponents;
-	TMap<uint8, UMaterialInstanceDynamic*> MaterialInstances;
-	UStaticMeshComponent* MyWaterMeshComponent;
-	UMaterialInstance* MaterialInstance;
-	UMaterialInstanceDynamic* myWaterMaterialInstance;
-	UMaterial* Material;
-	TMap<uint8, ELODStatus> LODStatus;
-
-	float LODTransitionOpacity = 0.0f;
-
-	uint8 CurrentLOD;
-	uint8 PreviousLOD;
-
-	USphereComponent* SphereComponent;
-
-	bool IsInitalized = false;
-
-	FIntVector2 mySector;
-
-	FVector WorldOffset;
-	FCGTerrainConfig* TerrainConfigMaster;
-
-	UPROPERTY()
-	UTexture2D* myTexture;
-
-	FUpdateTextureRegion2D* myRegion;
-
-
-public:
-	ACGTile();
-	~ACGTile();
-
-public:
-
-	bool TickTransition(float DeltaSeconds);
-
-	virtual void BeginPlay() override;
-	virtual void Tick(float DeltaSeconds) override;
-
-	void UpdateSettings(FIntVector2 aOffset, FCGTerrainConfig* aTerrainConfig, FVector aWorldOffset);
-	void UpdateMesh(uint8 aLOD, bool aIsInPlaceUpdate, TArray<FVector>& aPosition, TArray<FVector>& aNormals, TArray<FProcMeshTangent>& aTangents, TArray<FVector2D>& aUV0s, TArray<FColor>& aColours, TArray<int32>& aTriangles, TArray<FColor>& aTextureData);
-	void RepositionAndHide(uint8 aNewLOD);
-
-	bool CreateWaterMesh();
-
-	
-
-	UMaterialInstanceDynamic* GetMaterialInstanceDynamic(const uint8 aLOD);
-
-};
+#pragma once
+
+#include "Cashgen/Public/Struct/IntVector2.h"
+
+#include <Runtime/Engine/Classes/Components/SphereComponent.h>
+#include <ProceduralMeshComponent/Public/ProceduralMeshComponent.h>
+
+#include "CGTile.generated.h"
+
+class UHierarchicalInstancedStaticMeshComponent;
+class UStaticMeshComponent;
+struct FCGTerrainConfig;
+struct FCGMeshData;
+
+UENUM(BlueprintType)
+enum class ELODStatus : uint8
+{ 
+	NOT_CREATED, 
+	CREATED, 
+	TRANSITION
+};
+
+UCLASS()
+class CASHGEN_API ACGTile : public AActor
+{
+	GENERATED_BODY()
+
+	TMap<uint8, UProceduralMeshComponent*> MeshComponents;
+	UProceduralMeshComponent* myCollisionMeshComponent;
+	TMap<uint8, UMaterialInstanceDynamic*> MaterialInstances;
+	UStaticMeshComponent* MyWaterMeshComponent;
+	// One per scatter rule, kept with the tile when it goes back to the free list
+	TArray<UHierarchicalInstancedStaticMeshComponent*> myScatterComponents;
+	UMaterialInstance* MaterialInstance;
+	UMaterialInstanceDynamic* myWaterMaterialInstance;
+	UMaterial* Material;
+	TMap<uint8, ELODStatus> LODStatus;
+
+	float LODTransitionOpacity = 0.0f;
+
+	uint8 CurrentLOD;
+	uint8 PreviousLOD;
+
+	USphereComponent* SphereComponent;
+
+	bool IsInitalized = false;
+
+	FIntVector2 mySector;
+
+	FVector WorldOffset;
+	FCGTerrainConfig* TerrainConfigMaster;
+
+	UPROPERTY()
+	UTexture2D* myTexture;
+
+	FUpdateTextureRegion2D* myRegion;
+
+	// Estimated bytes held by each LOD's mesh section, its collision, and the splat texture
+	TArray<int64> myLODBytes;
+	int64 myCollisionBytes = 0;
+	int64 myTextureBytes = 0;
+
+	static int64 GetSectionBytes(const int32 aNumVertices, const int32 aNumIndices, const bool aIsRendered, const bool aHasCollision);
+
+public:
+	ACGTile();
+	~ACGTile();
+
+public:
+
+	bool TickTransition(float DeltaSeconds);
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	void UpdateSettings(FIntVector2 aOffset, FCGTerrainConfig* aTerrainConfig, FVector aWorldOffset);
+	void CreateComponents(FCGTerrainConfig* aTerrainConfig, FVector aWorldOffset);
+	void UpdateMesh(uint8 aLOD, bool aIsInPlaceUpdate, const FCGMeshData& aMeshData);
+	void RepositionAndHide(uint8 aNewLOD);
+
+	void UpdateCollisionMesh(const FCGMeshData& aMeshData);
+	void ClearCollisionMesh();
+
+	/** Replaces each scatter rule's instances, transforms are relative to the tile */
+	void UpdateScatter(const TArray<TArray<FTransform>>& aInstances);
+	void ClearScatter();
+
+	bool CreateWaterMesh();
+
+	/** Drops the mesh section for a LOD other than the one being shown, returns the bytes released */
+	int64 ReleaseLOD(const uint8 aLOD);
+	/** Drops every mesh section and the collision mesh, for tiles sitting in the free list */
+	int64 ReleaseAllMeshData();
+
+	uint8 GetCurrentLOD() const { return CurrentLOD; }
+	uint8 GetPreviousLOD() const { return PreviousLOD; }
+	ELODStatus GetLODStatus(const uint8 aLOD) const { return LODStatus.Contains(aLOD) ? LODStatus[aLOD] : ELODStatus::NOT_CREATED; }
+	const FIntVector2& GetSector() const { return mySector; }
+	int64 GetSectionBytes() const;
+	int64 GetSectionBytes(const uint8 aLOD) const { return myLODBytes.IsValidIndex(aLOD) ? myLODBytes[aLOD] : 0; }
+	int64 GetCollisionBytes() const { return myCollisionBytes; }
+	int64 GetTextureBytes() const { return myTextureBytes; }
+
+	
+
+	UMaterialInstanceDynamic* GetMaterialInstanceDynamic(const uint8 aLOD);
+
+	/** Writes the fade into custom primitive data. True if the previous LOD is fading out and needs hiding once it's done */
+	bool StartFade(const float aStartTime);
+	/** Hides a LOD that has finished fading out, unless the tile has since gone back to it */
+	void FinishFade(const uint8 aLOD);
+
+};
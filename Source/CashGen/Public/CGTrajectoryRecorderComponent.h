@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CashGen/Public/Struct/CGTrajectory.h"
+
+#include <Runtime/Engine/Classes/Components/ActorComponent.h>
+
+#include "CGTrajectoryRecorderComponent.generated.h"
+
+/**
+* Records the owning actor's path so it can be replayed against a terrain manager by ACGTrajectoryReplay.
+* Jumps further than TeleportDistance between two samples are marked as teleports.
+*/
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class CASHGEN_API UCGTrajectoryRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCGTrajectoryRecorderComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Seconds between samples */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	float SampleInterval = 0.1f;
+
+	/** Distance covered between two samples that counts as a teleport rather than movement */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	float TeleportDistance = 20000.0f;
+
+	/** Name of the trajectory file, written to Profiling/CashGen/Trajectories when play ends. Empty doesn't save */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	FString TrajectoryName;
+
+	/** Writes what's been recorded so far, returns false if the file couldn't be written */
+	UFUNCTION(BlueprintCallable, Category = "CashGen|Replay")
+	bool SaveTrajectory(const FString& aFilename) const;
+
+	const FCGTrajectory& GetTrajectory() const { return myTrajectory; }
+
+	static FString GetTrajectoryDir();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void RecordSample();
+
+	FCGTrajectory myTrajectory;
+	float myRecordTime = 0.0f;
+	float myTimeSinceSample = 0.0f;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CashGen/Public/Struct/CGTerrainStats.h"
+#include "CashGen/Public/Struct/CGTrajectory.h"
+#include "CashGen/Public/Struct/IntVector2.h"
+
+#include <Runtime/Engine/Classes/GameFramework/Actor.h>
+
+#include "CGTrajectoryReplay.generated.h"
+
+class ACGTerrainManager;
+
+/**
+* Plays recorded trajectories back against a terrain manager and reports how long the tile under each
+* actor takes to be ready, along with queue depths, worker utilisation and game thread time per frame.
+*
+* Trajectory time advances by FixedDeltaSeconds every frame whatever the real frame time, so every run
+* asks for the same sectors on the same frames. Run headless with a fixed frame rate to compare configs:
+*   UE4Editor <Project> <Map> -game -nullrhi -benchmark -fps=30 -unattended -CashGenReplay=Walk.csv+Vehicle.csv
+*/
+UCLASS()
+class CASHGEN_API ACGTrajectoryReplay : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACGTrajectoryReplay();
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Manager to replay against, the first one in the world if not set */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	ACGTerrainManager* TerrainManager;
+
+	/** Trajectory files, relative to Profiling/CashGen/Trajectories unless absolute. -CashGenReplay=a.csv+b.csv overrides them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	TArray<FString> TrajectoryFiles;
+
+	/** Trajectory seconds per frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	float FixedDeltaSeconds = 1.0f / 30.0f;
+
+	/** Seconds to keep going after the last trajectory ends, for the last tiles to finish */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	float SettleSeconds = 10.0f;
+
+	/** Report files are written to Profiling/CashGen/Replays/<ReportName>-<timestamp>-*.csv */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	FString ReportName = TEXT("Replay");
+
+	/** Exit once the report is written, for unattended runs */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Replay")
+	bool QuitWhenDone = true;
+
+private:
+	/** Replay state for one trajectory */
+	struct FActorReplay
+	{
+		FCGTrajectory myTrajectory;
+		AActor* myActor = nullptr;
+		FIntVector2 mySector;
+		// Waiting for the tile under the actor since these times
+		bool myIsWaiting = false;
+		double myWaitStartTime = 0.0;
+		double myWaitStartSeconds = 0.0;
+		// Time to ready for each sector entered, in trajectory and wall seconds
+		TArray<double> myReadyTimes;
+		TArray<double> myReadySeconds;
+		// Sectors the actor left before their tile was ready
+		int32 myNumMissed = 0;
+		int32 myNumNotReadyFrames = 0;
+	};
+
+	/** Per frame load, written out as the frames report */
+	struct FReplayFrame
+	{
+		double myTime;
+		FCGTerrainStats myStats;
+		double myGameThreadSeconds;
+		double myWorkerUtilisation;
+	};
+
+	bool StartReplay();
+	void UpdateActor(FActorReplay& aReplay, const bool aIsTeleport);
+	void FinishReplay();
+	void WriteReport() const;
+
+	TArray<FActorReplay> myReplays;
+	// Spawned stand-ins for the recorded actors, kept visible to GC
+	UPROPERTY()
+	TArray<AActor*> myActors;
+	TArray<FReplayFrame> myFrames;
+
+	bool myIsStarted = false;
+	bool myIsFinished = false;
+	double myTime = 0.0;
+	double myDuration = 0.0;
+	double myStartSeconds = 0.0;
+	double myLastFrameSeconds = 0.0;
+	int64 myLastWorkerBusyCycles = 0;
+	int64 myStartWorkerBusyCycles = 0;
+};
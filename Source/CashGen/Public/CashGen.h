@@ -1,19 +1,19 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-#pragma once
-
-#include <Runtime/Core/Public/Modules/ModuleManager.h>
-
-#define Msg(Text) if(GEngine) GEngine->AddOnScreenDebugMessage(-1, 1, FColor::Green, TEXT(Text));
-
-
-DECLARE_STATS_GROUP(TEXT("CashGen"), STATGROUP_CashGenStat, STATCAT_Advanced);
-
-class CASHGEN_API FCashGen : public IModuleInterface
-{
-public:
-
-	/** IModuleInterface implementation */
-	virtual void StartupModule() override;
-	virtual void ShutdownModule() override;
-	bool HandleSettingsSaved();
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+#pragma once
+
+#include <Runtime/Core/Public/Modules/ModuleManager.h>
+
+#define Msg(Text) if(GEngine) GEngine->AddOnScreenDebugMessage(-1, 1, FColor::Green, TEXT(Text));
+
+
+DECLARE_STATS_GROUP(TEXT("CashGen"), STATGROUP_CashGenStat, STATCAT_Advanced);
+
+class CASHGEN_API FCashGen : public IModuleInterface
+{
+public:
+
+	/** IModuleInterface implementation */
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+	bool HandleSettingsSaved();
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CGCollisionConfig.generated.h"
+
+/** Collision settings applied around a tracked actor, independent of the render LODs */
+USTRUCT(BlueprintType)
+struct FCGCollisionConfig
+{
+	GENERATED_BODY()
+
+	FCGCollisionConfig()
+		: SectorRadius(1)
+		, LOD(0)
+	{
+	}
+
+	/** Radius in sectors around the actor that gets collision, 0 disables collision for the actor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	int SectorRadius;
+	/** LOD whose resolution is used to build the collision mesh */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	uint8 LOD;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CGGroundInfo.generated.h"
+
+/** Terrain surface at a world XY, interpolated from the resident tile heightmaps */
+USTRUCT(BlueprintType)
+struct FCGGroundInfo
+{
+	GENERATED_BODY()
+
+	FCGGroundInfo()
+		: Height(0.0f)
+		, Normal(FVector::UpVector)
+		, Slope(0.0f)
+	{
+	}
+
+	/** World Z of the surface */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float Height;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	FVector Normal;
+
+	/** Degrees from horizontal */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float Slope;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+* Copy of the heightmap (including its one sample border) a tile was last built from.
+* Kept with the tile handle so a downgrade can subsample it rather than go back to the height interface.
+*/
+struct FCGHeightField
+{
+	FCGHeightField()
+		: myLOD(0)
+		, mySize(0)
+	{
+	}
+
+	// LOD the heights were sampled at
+	uint8 myLOD;
+	// Samples per side, border included
+	int32 mySize;
+	TArray<float> myHeights;
+};
@@ -1,36 +1,67 @@
-#pragma once
-
-#include "CashGen/Public/Struct/IntVector2.h"
-#include "CashGen/Public/Struct/CGTileHandle.h"
-#include "CashGen/Public/CGObjectPool.h"
-
-#include "CGJob.generated.h"
-
-struct FCGMeshData;
-
-USTRUCT(BlueprintType)
-struct FCGJob
-{
-	GENERATED_BODY()
-
-	FCGJob()
-		: mySector(0,0)
-		, HeightmapGenerationDuration(0)
-		, ErosionGenerationDuration(0)
-		, LOD(0)
-		, IsInPlaceUpdate(false)
-	{
-	}
-
-	FIntVector2 mySector;
-	FCGTileHandle myTileHandle;
-	TCGBorrowedObject<FCGMeshData> Data;
-	int32 HeightmapGenerationDuration;
-	int32 ErosionGenerationDuration;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
-	uint8 LOD;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
-	bool IsInPlaceUpdate;
+#pragma once
+
+#include "CashGen/Public/Struct/IntVector2.h"
+#include "CashGen/Public/Struct/CGJobTimings.h"
+#include "CashGen/Public/Struct/CGTileHandle.h"
+#include "CashGen/Public/CGObjectPool.h"
+
+#include "CGJob.generated.h"
+
+struct FCGMeshData;
+
+USTRUCT(BlueprintType)
+struct FCGJob
+{
+	GENERATED_BODY()
+
+	FCGJob()
+		: mySector(0,0)
+		, LOD(0)
+		, IsInPlaceUpdate(false)
+		, IsCollisionJob(false)
+		, IsPrefetch(false)
+		, IsDowngrade(false)
+		, Curvature(0.0f)
+	{
+	}
+
+	/** Returns true if the job was cancelled after being queued */
+	bool IsCancelled() const
+	{
+		return CancelToken.IsValid() && *CancelToken;
+	}
+
+	FIntVector2 mySector;
+	FCGTileHandle myTileHandle;
+	TCGBorrowedObject<FCGMeshData> Data;
+	FCGJobTimings Timings;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	uint8 LOD;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool IsInPlaceUpdate;
+
+	/** Builds only the collision mesh for the tile */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool IsCollisionJob;
+
+	/** Queued at low priority ahead of a moving actor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool IsPrefetch;
+
+	/** Rebuilds the tile at a coarser LOD, from the tile's height field where possible */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool IsDowngrade;
+
+	TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> CancelToken;
+
+	/** RMS curvature of the heightmap in world units per unit spacing squared, for screen space error LOD selection */
+	float Curvature;
+
+	/** Heights the worker sampled, handed back so the tile can be downgraded later */
+	TSharedPtr<const FCGHeightField, ESPMode::ThreadSafe> HeightField;
+
+	/** Instance transforms relative to the tile, one array per scatter rule. Empty when the terrain has no rules */
+	TArray<TArray<FTransform>> ScatterInstances;
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+/** Stages a job's latency is broken down into, in the order a job goes through them */
+enum class ECGJobStage : uint8
+{
+	// Pending queue, from the game thread queueing the job to a worker picking it up
+	QueueWait,
+	// Worker blocked on the LOD's mesh data pool
+	BorrowWait,
+	// Heightmap, from the height interface or subsampled, plus curvature and height field capture
+	Sampling,
+	Geometry,
+	Normals,
+	Skirts,
+	// Instance placement from the scatter rules
+	Scatter,
+	// Update queue, from the worker finishing to the game thread picking the result up
+	UpdateWait,
+	// Game thread mesh section update, including any synchronous collision cook for coupled collision
+	Upload,
+	// Game thread side of a decoupled collision mesh update
+	CollisionCook,
+	Num
+};
+
+/**
+* Per job stage timings in FPlatformTime::Cycles64 units, carried with the job from queue to upload.
+*/
+struct FCGJobTimings
+{
+	FCGJobTimings()
+		: myQueuedCycles(0)
+		, myStagesRun(0)
+	{
+		FMemory::Memzero(myStageCycles);
+	}
+
+	static const TCHAR* GetStageName(const ECGJobStage aStage)
+	{
+		static const TCHAR* stageNames[] = { TEXT("QueueWait"), TEXT("BorrowWait"), TEXT("Sampling"), TEXT("Geometry"), TEXT("Normals"), TEXT("Skirts"), TEXT("Scatter"), TEXT("UpdateWait"), TEXT("Upload"), TEXT("CollisionCook") };
+		static_assert(UE_ARRAY_COUNT(stageNames) == (int32)ECGJobStage::Num, "Every job stage needs a name");
+		return stageNames[(uint8)aStage];
+	}
+
+	/** Adds the cycles since aStartCycles to a stage and returns the current cycle count, for the next stage to start from */
+	uint64 EndStage(const ECGJobStage aStage, const uint64 aStartCycles)
+	{
+		const uint64 now = FPlatformTime::Cycles64();
+		myStageCycles[(uint8)aStage] += now - aStartCycles;
+		myStagesRun |= 1 << (uint8)aStage;
+		return now;
+	}
+
+	bool HasRun(const ECGJobStage aStage) const { return (myStagesRun & (1 << (uint8)aStage)) != 0; }
+	uint64 GetStageCycles(const ECGJobStage aStage) const { return myStageCycles[(uint8)aStage]; }
+	double GetStageSeconds(const ECGJobStage aStage) const { return FPlatformTime::GetSecondsPerCycle64() * myStageCycles[(uint8)aStage]; }
+
+	// When the job last went into a queue, the wait stages are measured from it
+	uint64 myQueuedCycles;
+
+private:
+	uint64 myStageCycles[(uint8)ECGJobStage::Num];
+	uint16 myStagesRun;
+};
@@ -1,26 +1,34 @@
-#pragma once
-
-#include "CGLODConfig.generated.h"
-
-USTRUCT(BlueprintType)
-struct FCGLODConfig
-{
-	GENERATED_BODY()
-
-	FCGLODConfig()
-		: SectorRadius(0)
-		, ResolutionDivisor(0)
-		, isCollisionEnabled(true)
-	{
-	}
-
-	/** Radius in sectors to spawn terrain around an actor */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
-	int SectorRadius;
-	/** Factor to reduce sector mesh resolution by from base value */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
-	uint8 ResolutionDivisor;
-	/** Cook collision */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
-	bool isCollisionEnabled;
+#pragma once
+
+#include "CGLODConfig.generated.h"
+
+USTRUCT(BlueprintType)
+struct FCGLODConfig
+{
+	GENERATED_BODY()
+
+	FCGLODConfig()
+		: SectorRadius(0)
+		, ResolutionDivisor(0)
+		, isCollisionEnabled(true)
+		, MeshDataPoolSize(0)
+		, MaxMeshDataPoolSize(0)
+	{
+	}
+
+	/** Radius in sectors to spawn terrain around an actor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	int SectorRadius;
+	/** Factor to reduce sector mesh resolution by from base value */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	uint8 ResolutionDivisor;
+	/** Cook collision */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool isCollisionEnabled;
+	/** Mesh data slots for this LOD, 0 uses the terrain's MeshDataPoolSize */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	uint8 MeshDataPoolSize;
+	/** Slots the pool may grow to while workers are left waiting on it, 0 keeps it at its starting size */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	uint8 MaxMeshDataPoolSize;
 };
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CashGen/Public/CGTile.h"
+
+/** A LOD fading out under a custom primitive data transition, hidden once the fade is done */
+struct FCGLODFade
+{
+	FCGLODFade()
+		: myLOD(0)
+		, myHideTime(0.0f)
+	{
+	}
+
+	FCGLODFade(ACGTile* aTile, const uint8 aLOD, const float aHideTime)
+		: myTile(aTile)
+		, myLOD(aLOD)
+		, myHideTime(aHideTime)
+	{
+	}
+
+	// Weak, the memory governor can destroy free tiles while they're still fading
+	TWeakObjectPtr<ACGTile> myTile;
+	uint8 myLOD;
+	// World time, matching the material's Time node
+	float myHideTime;
+};
@@ -9,7 +9,7 @@ struct FCGLODMeshData
 {
 	GENERATED_BODY()
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
-	TArray<FCGMeshData> Data;
+	// Indirect so the pools can grow and shrink without moving the mesh data they hand out
+	TIndirectArray<FCGMeshData> Data;
 
 };
\ No newline at end of file
@@ -1,29 +1,148 @@
-#pragma once
-
-#include <ProceduralMeshComponent/Public/ProceduralMeshComponent.h>
-
-#include "CGMeshData.generated.h"
-
-/** Defines the data required for a single procedural mesh section */
-USTRUCT(BlueprintType)
-struct FCGMeshData
-{
-	GENERATED_BODY()
-
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Data Struct")
-	TArray<FVector> MyPositions;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Data Struct")
-	TArray<FVector> MyNormals;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Data Struct")
-	TArray<FProcMeshTangent> MyTangents;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Data Struct")
-	TArray<FColor> MyColours;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Data Struct")
-	TArray<FVector2D> MyUV0;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Data Struct")
-	TArray<int32> MyTriangles;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Data Struct")
-	TArray<float> HeightMap;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Data Struct")
-	TArray<FColor> myTextureData;
-};
\ No newline at end of file
+#pragma once
+
+#include <ProceduralMeshComponent/Public/ProceduralMeshComponent.h>
+
+/** Element counts for each stream of a FCGMeshData */
+struct FCGMeshDataLayout
+{
+	int32 NumVertices = 0;
+	// Normals, tangents, colours and UVs. Zero when only collision is being built
+	int32 NumRenderVertices = 0;
+	int32 NumIndices = 0;
+	int32 NumHeights = 0;
+	int32 NumTexels = 0;
+};
+
+/**
+* Defines the data required for a single procedural mesh section.
+* All the streams live in one allocation, each one starting on its own cache line, so a pool slot
+* is a single malloc and the workers never share a line between two streams.
+*/
+struct FCGMeshData
+{
+	FCGMeshData()
+		: myArena(nullptr)
+		, myArenaSize(0)
+	{
+	}
+
+	explicit FCGMeshData(const FCGMeshDataLayout& aLayout)
+		: FCGMeshData()
+	{
+		Allocate(aLayout);
+	}
+
+	FCGMeshData(const FCGMeshData& aOther)
+		: FCGMeshData()
+	{
+		*this = aOther;
+	}
+
+	FCGMeshData& operator=(const FCGMeshData& aOther)
+	{
+		if (this != &aOther)
+		{
+			Allocate(aOther.myLayout);
+			if (myArenaSize > 0)
+			{
+				FMemory::Memcpy(myArena, aOther.myArena, myArenaSize);
+			}
+		}
+		return *this;
+	}
+
+	~FCGMeshData()
+	{
+		Free();
+	}
+
+	TArrayView<FVector> MyPositions;
+	TArrayView<FVector> MyNormals;
+	TArrayView<FProcMeshTangent> MyTangents;
+	TArrayView<FColor> MyColours;
+	TArrayView<FVector2D> MyUV0;
+	TArrayView<int32> MyTriangles;
+	// The vertex streams are written in grid order, this is which of them goes at each mesh section vertex.
+	// MyTriangles is numbered for the section, like this order
+	TArrayView<int32> MyVertexOrder;
+	TArrayView<float> HeightMap;
+	TArrayView<FColor> myTextureData;
+
+	/** Carves every stream out of one zeroed, cache line aligned block, replacing any previous one */
+	void Allocate(const FCGMeshDataLayout& aLayout)
+	{
+		Free();
+		myLayout = aLayout;
+
+		SIZE_T offset = 0;
+		const SIZE_T positionsOffset = ReserveStream<FVector>(offset, aLayout.NumVertices);
+		const SIZE_T normalsOffset = ReserveStream<FVector>(offset, aLayout.NumRenderVertices);
+		const SIZE_T tangentsOffset = ReserveStream<FProcMeshTangent>(offset, aLayout.NumRenderVertices);
+		const SIZE_T coloursOffset = ReserveStream<FColor>(offset, aLayout.NumRenderVertices);
+		const SIZE_T uvOffset = ReserveStream<FVector2D>(offset, aLayout.NumRenderVertices);
+		const SIZE_T trianglesOffset = ReserveStream<int32>(offset, aLayout.NumIndices);
+		const SIZE_T vertexOrderOffset = ReserveStream<int32>(offset, aLayout.NumVertices);
+		const SIZE_T heightsOffset = ReserveStream<float>(offset, aLayout.NumHeights);
+		const SIZE_T texelsOffset = ReserveStream<FColor>(offset, aLayout.NumTexels);
+
+		if (offset == 0)
+		{
+			return;
+		}
+
+		// Every stream type is plain data, zero is a valid starting value for all of them
+		myArena = (uint8*)FMemory::Malloc(offset, PLATFORM_CACHE_LINE_SIZE);
+		myArenaSize = offset;
+		FMemory::Memzero(myArena, myArenaSize);
+
+		MyPositions = TArrayView<FVector>((FVector*)(myArena + positionsOffset), aLayout.NumVertices);
+		MyNormals = TArrayView<FVector>((FVector*)(myArena + normalsOffset), aLayout.NumRenderVertices);
+		MyTangents = TArrayView<FProcMeshTangent>((FProcMeshTangent*)(myArena + tangentsOffset), aLayout.NumRenderVertices);
+		MyColours = TArrayView<FColor>((FColor*)(myArena + coloursOffset), aLayout.NumRenderVertices);
+		MyUV0 = TArrayView<FVector2D>((FVector2D*)(myArena + uvOffset), aLayout.NumRenderVertices);
+		MyTriangles = TArrayView<int32>((int32*)(myArena + trianglesOffset), aLayout.NumIndices);
+		MyVertexOrder = TArrayView<int32>((int32*)(myArena + vertexOrderOffset), aLayout.NumVertices);
+		HeightMap = TArrayView<float>((float*)(myArena + heightsOffset), aLayout.NumHeights);
+		myTextureData = TArrayView<FColor>((FColor*)(myArena + texelsOffset), aLayout.NumTexels);
+	}
+
+	const FCGMeshDataLayout& GetLayout() const { return myLayout; }
+
+	/** Bytes held by all the streams, for memory accounting */
+	SIZE_T GetAllocatedSize() const { return myArenaSize; }
+
+private:
+	void Free()
+	{
+		if (myArena)
+		{
+			FMemory::Free(myArena);
+		}
+		myArena = nullptr;
+		myArenaSize = 0;
+		myLayout = FCGMeshDataLayout();
+
+		MyPositions = TArrayView<FVector>();
+		MyNormals = TArrayView<FVector>();
+		MyTangents = TArrayView<FProcMeshTangent>();
+		MyColours = TArrayView<FColor>();
+		MyUV0 = TArrayView<FVector2D>();
+		MyTriangles = TArrayView<int32>();
+		MyVertexOrder = TArrayView<int32>();
+		HeightMap = TArrayView<float>();
+		myTextureData = TArrayView<FColor>();
+	}
+
+	/** Returns the cache line aligned offset of a stream of aNum elements and moves aOffset past it */
+	template<typename ElementType>
+	static SIZE_T ReserveStream(SIZE_T& aOffset, const int32 aNum)
+	{
+		const SIZE_T streamOffset = Align(aOffset, PLATFORM_CACHE_LINE_SIZE);
+		aOffset = streamOffset + sizeof(ElementType) * FMath::Max(aNum, 0);
+		return streamOffset;
+	}
+
+	uint8* myArena;
+	SIZE_T myArenaSize;
+	FCGMeshDataLayout myLayout;
+};
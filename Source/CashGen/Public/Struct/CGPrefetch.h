@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Runtime/Core/Public/HAL/ThreadSafeBool.h>
+
+class AActor;
+
+/** Tracks a sector queued ahead of a moving actor so it can be cancelled if the prediction is wrong */
+struct FCGPrefetch
+{
+	// The actor whose predicted path asked for this sector
+	const AActor* myActor = nullptr;
+	// Set to cancel the low priority job
+	TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> myCancelToken;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CGScatterRule.generated.h"
+
+class UStaticMesh;
+
+/** One kind of instance (grass, rocks, trees...) the workers scatter over each tile */
+USTRUCT(BlueprintType)
+struct FCGScatterRule
+{
+	GENERATED_BODY()
+
+	FCGScatterRule()
+		: Mesh(nullptr)
+		, InstancesPerTile(100)
+		, Seed(0)
+		, MaxLOD(0)
+		, MinHeight(-100000.0f)
+		, MaxHeight(100000.0f)
+		, MinSlope(0.0f)
+		, MaxSlope(30.0f)
+		, MinScale(1.0f)
+		, MaxScale(1.0f)
+		, AlignToNormal(false)
+		, ZOffset(0.0f)
+		, CullDistance(0.0f)
+		, EnableCollision(false)
+		, CastShadows(true)
+	{
+	}
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	UStaticMesh* Mesh;
+	/** Candidate points per tile, before the height and slope filters */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	int32 InstancesPerTile;
+	/** Mixed with the terrain's ScatterSeed and the sector. Rules with the same seed pick the same candidate points */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	int32 Seed;
+	/** Coarsest LOD the tile can be at and still have these instances */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	uint8 MaxLOD;
+	/** World height range instances are placed in */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float MinHeight;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float MaxHeight;
+	/** Slope range in degrees from horizontal */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen", meta = (ClampMin = "0.0", ClampMax = "90.0"))
+	float MinSlope;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen", meta = (ClampMin = "0.0", ClampMax = "90.0"))
+	float MaxSlope;
+	/** Uniform scale range */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float MinScale;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float MaxScale;
+	/** Tilt instances to the surface, otherwise they stand upright */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool AlignToNormal;
+	/** Added to the surface height, negative sinks instances into the ground */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float ZOffset;
+	/** Instances are culled beyond this distance, 0 never culls */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float CullDistance;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool EnableCollision;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool CastShadows;
+};
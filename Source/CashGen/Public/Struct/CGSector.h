@@ -41,7 +41,7 @@ public:
 
 	friend FORCEINLINE uint32 GetTypeHash(const FCGSector& point)
 	{
-		return FCrc::MemCrc32(&point.mySector, sizeof(FIntVector2));
+		return GetTypeHash(point.mySector);
 	}
 
 	FIntVector2 mySector;
@@ -1,85 +1,169 @@
-#pragma once
-
-#include "CashGen/Public/Struct/CGLODConfig.h"
-#include "CashGen/Public/WorldHeightInterface.h"
-
-#include "CGTerrainConfig.generated.h"
-
-/** Struct defines all applicable attributes for managing generation of a single zone */
-USTRUCT(BlueprintType)
-struct FCGTerrainConfig
-{
-	GENERATED_BODY()
-
-	FCGTerrainConfig()
-		:WaterMaterialInstance(nullptr)
-	{
-	}
-
-	/** Noise Generator configuration struct */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tattiebogle|Data Source")
-	TScriptInterface<IWorldHeightInterface> WorldHeightInterface;
-	/** Use ASync collision cooking for terrain mesh (Recommended) */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
-	bool UseAsyncCollision = true;
-	/** Size of MeshData pool */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
-	uint8 MeshDataPoolSize = 5;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
-	uint8 NumberOfThreads = 1;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
-	uint8 MeshUpdatesPerFrame = 1;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
-	FTimespan TileReleaseDelay;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
-	float TileSweepTime;
-	/** Number of blocks along a zone's X axis */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scale")
-	int32 TileXUnits = 32;
-	/** Number of blocks along a zone's Y axis */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scale")
-	int32 TileYUnits = 32;
-	/** Size of a single block in world units */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scale")
-	float UnitSize = 300.0f;
-	/** Multiplier for heightmap*/
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scale")
-	float Amplitude = 5000.0f;
-
-	/** Material for the terrain mesh */
-	//UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
-	//UMaterial* TerrainMaterial;
-	/** Material for the water mesh (will be instanced)*/
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
-	UMaterialInstance* WaterMaterialInstance;
-	/** Cast Shadows */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
-	bool CastShadows = false;
-	/* Generate a texture including heightmap and other information */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
-	bool GenerateSplatMap = false;
-	/** If checked and numLODs > 1, material will be instanced and TerrainOpacity parameters used to dither LOD transitions */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
-	bool DitheringLODTransitions = false;
-	/** If no TerrainMaterial and LOD transitions disabled, just use the same static instance for all LODs **/
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
-	UMaterialInstance* TerrainMaterialInstance;
-	/** Make a dynamic material instance */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Water")
-	bool MakeDynamicMaterialInstance;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Water")
-	/** If checked, will use a single instanced mesh for water, otherwise a procmesh section with dynamic texture will be used */
-	bool UseInstancedWaterMesh = true;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Water")
-	/** If checked, will use a single instanced mesh for water, otherwise a procmesh section with dynamic texture will be used */
-	UStaticMesh* WaterMesh;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Water")
-	TEnumAsByte<ECollisionEnabled::Type> WaterCollision = ECollisionEnabled::Type::QueryAndPhysics;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs")
-	TArray<FCGLODConfig> LODs;
-
-	FVector TileOffset;
-};
+#pragma once
+
+#include "CashGen/Public/Struct/CGCollisionConfig.h"
+#include "CashGen/Public/Struct/CGLODConfig.h"
+#include "CashGen/Public/Struct/CGScatterRule.h"
+#include "CashGen/Public/WorldHeightInterface.h"
+
+#include "CGTerrainConfig.generated.h"
+
+/** How dithered LOD transitions are driven */
+UENUM(BlueprintType)
+enum class ECGLODTransitionMode : uint8
+{
+	/** Per tile, per LOD dynamic material instances with a TerrainOpacity parameter, updated every frame */
+	MaterialParameter,
+	/** The fade start time is written to custom primitive data once and the material works out the opacity */
+	CustomPrimitiveData
+};
+
+/** Struct defines all applicable attributes for managing generation of a single zone */
+USTRUCT(BlueprintType)
+struct FCGTerrainConfig
+{
+	GENERATED_BODY()
+
+	FCGTerrainConfig()
+		:WaterMaterialInstance(nullptr)
+	{
+	}
+
+	/** Noise Generator configuration struct */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tattiebogle|Data Source")
+	TScriptInterface<IWorldHeightInterface> WorldHeightInterface;
+	/** Use ASync collision cooking for terrain mesh (Recommended) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	bool UseAsyncCollision = true;
+	/** Size of MeshData pool */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	uint8 MeshDataPoolSize = 5;
+	/** Average borrow wait, in milliseconds, that makes a LOD's mesh data pool grow */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	float MeshDataPoolGrowWaitMs = 1.0f;
+	/** Seconds a grown pool has to go without waits before it gives a slot back */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	float MeshDataPoolShrinkDelay = 10.0f;
+	/** Worker threads wanted. Workers are shared by all managers, there are as many as the most any of them asks for, up to the core count */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	uint8 NumberOfThreads = 1;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	uint8 MeshUpdatesPerFrame = 1;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	FTimespan TileReleaseDelay;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	float TileSweepTime;
+	/** Seconds ahead to extrapolate tracked actor velocity and prefetch sectors at low priority, 0 disables prefetching */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	float PrefetchLookaheadSeconds = 0.0f;
+	/** Fraction of a sector an actor has to move past a sector boundary before it counts as having moved, so actors sitting on a ring boundary don't flip LODs back and forth */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System", meta = (ClampMin = "0.0", ClampMax = "0.5"))
+	float SectorHysteresis = 0.1f;
+	/** Tile actors to create per frame after setup, until there are enough to cover an actor's footprint. 0 only creates tiles on demand */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	int32 PrewarmTilesPerFrame = 4;
+	/** Budget in MB for tile mesh sections, collision, splat textures and mesh data pools. Over budget, cached tile data is evicted furthest first. 0 disables the governor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|System")
+	int32 MemoryBudgetMB = 0;
+	/** Number of blocks along a zone's X axis */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scale")
+	int32 TileXUnits = 32;
+	/** Number of blocks along a zone's Y axis */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scale")
+	int32 TileYUnits = 32;
+	/** Size of a single block in world units */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scale")
+	float UnitSize = 300.0f;
+	/** Multiplier for heightmap*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scale")
+	float Amplitude = 5000.0f;
+
+	/** Material for the terrain mesh */
+	//UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	//UMaterial* TerrainMaterial;
+	/** Material for the water mesh (will be instanced)*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	UMaterialInstance* WaterMaterialInstance;
+	/** Cast Shadows */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	bool CastShadows = false;
+	/* Generate a texture including heightmap and other information */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	bool GenerateSplatMap = false;
+	/** If checked and numLODs > 1, material will be instanced and TerrainOpacity parameters used to dither LOD transitions */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	bool DitheringLODTransitions = false;
+	/** How transitions are driven. CustomPrimitiveData shares one material across all tiles and LODs */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	ECGLODTransitionMode TransitionMode = ECGLODTransitionMode::MaterialParameter;
+	/** First of three custom primitive data floats: fade start time (world seconds), direction (1 fading in, -1 fading out) and duration */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	int32 TransitionCustomDataIndex = 0;
+	/** Seconds a custom primitive data fade takes, after which the previous LOD is hidden */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	float TransitionDuration = 1.0f;
+	/** If no TerrainMaterial and LOD transitions disabled, just use the same static instance for all LODs **/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Rendering")
+	UMaterialInstance* TerrainMaterialInstance;
+	/** Make a dynamic material instance */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Water")
+	bool MakeDynamicMaterialInstance;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Water")
+	/** If checked, will use a single instanced mesh for water, otherwise a procmesh section with dynamic texture will be used */
+	bool UseInstancedWaterMesh = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Water")
+	/** If checked, will use a single instanced mesh for water, otherwise a procmesh section with dynamic texture will be used */
+	UStaticMesh* WaterMesh;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Water")
+	TEnumAsByte<ECollisionEnabled::Type> WaterCollision = ECollisionEnabled::Type::QueryAndPhysics;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs")
+	TArray<FCGLODConfig> LODs;
+
+	/** Instances the workers scatter over each tile from its heightmap, added to instanced meshes on the tile */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scatter")
+	TArray<FCGScatterRule> ScatterRules;
+	/** Seed for every rule's placement. The same seed, rules and sector always give the same instances */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Scatter")
+	int32 ScatterSeed = 0;
+	/** Pick LODs from the tile's projected geometric error instead of the ring radii alone. Rough tiles refine sooner, flat ones stay coarse */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs")
+	bool UseScreenSpaceErrorLOD = false;
+	/** Rebuild tiles at a coarser LOD once nothing needs their detail, freeing the finer section and its collision. Where the resolution divisors allow, the coarse heights are subsampled from the finer build */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs")
+	bool DowngradeLODs = true;
+	/** Fill the whole footprint at the coarsest LOD first so the world is playable almost straight away, then refine each tile to its target LOD, nearest the actors first */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs")
+	bool ProgressiveRefinement = false;
+	/** Progressive mode only lets refinements into the pending queue while it holds fewer jobs than this, so their order follows the actors as they move */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs")
+	int32 RefinementQueueDepth = 4;
+	/** Largest projected error, in pixels, a tile may have before a finer LOD is used */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs")
+	float MaxScreenSpaceError = 2.0f;
+	/** Pixels per world unit of error at unit distance: viewport height / (2 * tan(FOV / 2)) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs")
+	float ScreenSpaceErrorScale = 540.0f;
+	/** A coarser LOD is only picked once its error drops this fraction below the threshold */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|LODs", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float LODHysteresis = 0.25f;
+
+	/** If checked, collision is built on a separate mesh around each tracked actor and the per-LOD isCollisionEnabled flags are ignored */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Collision")
+	bool DecoupledCollision = false;
+	/** Default collision radius and resolution for tracked actors, can be overridden per actor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Collision")
+	FCGCollisionConfig Collision;
+	/** Dedicated servers only generate heightmaps and collision, skipping all render data, components and materials */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Collision")
+	bool CollisionOnlyOnDedicatedServer = true;
+	/** Always generate heightmaps and collision only, for headless tools and testing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen|Collision")
+	bool ForceCollisionOnly = false;
+
+	FVector TileOffset;
+
+	// Set up by the terrain manager, true when running without any rendering
+	bool IsCollisionOnly = false;
+};
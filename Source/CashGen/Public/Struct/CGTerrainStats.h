@@ -0,0 +1,56 @@
+#pragma once
+
+/**
+* Snapshot of a terrain manager's load, for profiling and the trajectory replay harness.
+*/
+struct FCGTerrainStats
+{
+	FCGTerrainStats()
+		: PendingJobs(0)
+		, PrefetchJobs(0)
+		, UpdateJobs(0)
+		, QueuedSectors(0)
+		, NumWorkerThreads(0)
+		, WorkerBusyCycles(0)
+		, TickSeconds(0.0)
+		, TilesSpawned(0)
+		, TilesRequested(0)
+		, TilesTransition(0)
+		, TilesIdle(0)
+		, FreeTiles(0)
+		, JobsPerSecond(0.0f)
+		, SecondsSinceTerrainComplete(0.0)
+		, SectionBytes(0)
+		, CollisionBytes(0)
+		, TextureBytes(0)
+		, HeightFieldBytes(0)
+	{
+	}
+
+	int32 PendingJobs;
+	int32 PrefetchJobs;
+	// Generated, waiting for the game thread to upload them
+	int32 UpdateJobs;
+	// Sectors with a job anywhere between queued and uploaded
+	int32 QueuedSectors;
+	int32 NumWorkerThreads;
+	// Cycles the workers have spent generating since setup, waits excluded. Diff two snapshots for utilisation
+	int64 WorkerBusyCycles;
+	// Game thread time of the manager's last tick
+	double TickSeconds;
+	// Live tiles by status, and tiles waiting in the free list
+	int32 TilesSpawned;
+	int32 TilesRequested;
+	int32 TilesTransition;
+	int32 TilesIdle;
+	int32 FreeTiles;
+	// Uploads per second, averaged over the last whole second
+	float JobsPerSecond;
+	// 0 until the terrain around every tracked actor is complete
+	double SecondsSinceTerrainComplete;
+	// As of the last memory budget pass. Mesh data pools can be shared, so the generation subsystem reports those
+	int64 SectionBytes;
+	int64 CollisionBytes;
+	int64 TextureBytes;
+	int64 HeightFieldBytes;
+};
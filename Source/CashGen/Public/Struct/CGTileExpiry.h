@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CashGen/Public/Struct/IntVector2.h"
+
+/** Entry in the tile expiry min-heap, ordered by the time the tile may next be released */
+struct FCGTileExpiry
+{
+	FCGTileExpiry()
+		: myExpiryTime(0.0)
+		, mySpawnId(0)
+	{
+	}
+
+	FCGTileExpiry(const double aExpiryTime, const FIntVector2& aSector, const uint32 aSpawnId)
+		: myExpiryTime(aExpiryTime)
+		, mySector(aSector)
+		, mySpawnId(aSpawnId)
+	{
+	}
+
+	FORCEINLINE bool operator<(const FCGTileExpiry& Src) const
+	{
+		return myExpiryTime < Src.myExpiryTime;
+	}
+
+	double myExpiryTime;
+	FIntVector2 mySector;
+	uint32 mySpawnId;
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include "CashGen.h"
+#include "CashGen/Public/Struct/CGHeightField.h"
+#include <Runtime/Core/Public/HAL/ThreadSafeBool.h>
 #include "CGTileHandle.generated.h"
 
 class ACGTile;
@@ -22,6 +24,16 @@ struct FCGTileHandle
 	// Handle to the tile actor
 	UPROPERTY()
 	ACGTile* myHandle;
-	// Bitmask to indicate which players require this sector
-	FDateTime myLastRequiredTimestamp;
+	// Monotonic time (FPlatformTime::Seconds) the sector was last required by an actor
+	double myLastRequiredTimestamp;
+	// Identifies this spawn of the sector, so stale expiry entries can be told apart
+	uint32 mySpawnId = 0;
+	// LOD the collision mesh is built or requested at, -1 if the tile has no collision
+	int32 myCollisionLOD = -1;
+	// RMS height curvature per unit spacing squared, measured by the worker. Negative until the tile has been generated
+	float myCurvature = -1.0f;
+	// Heightmap from the tile's last full build, downgrades are subsampled from it
+	TSharedPtr<const FCGHeightField, ESPMode::ThreadSafe> myHeightField;
+	// Set when the pending collision job for this tile is no longer wanted
+	TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> myCollisionCancelToken;
 };
\ No newline at end of file
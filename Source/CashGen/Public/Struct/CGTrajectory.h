@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CGTrajectory.generated.h"
+
+/** One recorded position of a tracked actor */
+USTRUCT(BlueprintType)
+struct FCGTrajectorySample
+{
+	GENERATED_BODY()
+
+	FCGTrajectorySample()
+		: Time(0.0f)
+		, Location(FVector::ZeroVector)
+		, IsTeleport(false)
+	{
+	}
+
+	/** Seconds since recording started */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	float Time;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	FVector Location;
+
+	/** The actor jumped here from the previous sample, so replay doesn't interpolate between them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	bool IsTeleport;
+};
+
+/**
+* A tracked actor's path, recorded by UCGTrajectoryRecorderComponent and played back by ACGTrajectoryReplay.
+* Stored as CSV, one "time,x,y,z,teleport" line per sample.
+*/
+USTRUCT(BlueprintType)
+struct CASHGEN_API FCGTrajectory
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	FString Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CashGen")
+	TArray<FCGTrajectorySample> Samples;
+
+	float GetDuration() const { return Samples.Num() > 0 ? Samples.Last().Time : 0.0f; }
+
+	/** Position at the given time, interpolated between samples. aOutIsTeleport is set when a teleport sample lies between aPreviousTime and aTime */
+	FVector GetLocation(const float aPreviousTime, const float aTime, bool& aOutIsTeleport) const;
+
+	bool SaveToFile(const FString& aFilename) const;
+	bool LoadFromFile(const FString& aFilename);
+};
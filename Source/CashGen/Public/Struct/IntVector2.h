@@ -36,6 +36,11 @@ struct FIntVector2
 		return FIntVector2(X - Src.X, Y - Src.Y);
 	}
 
+	FIntVector2 operator+(const FIntVector2& Src) const
+	{
+		return FIntVector2(X + Src.X, Y + Src.Y);
+	}
+
 	FString ToString()
 	{
 		return "[" + FString::FromInt(X) + ":" + FString::FromInt(Y) + "]";
@@ -43,7 +48,10 @@ struct FIntVector2
 
 	friend FORCEINLINE uint32 GetTypeHash(const FIntVector2& point)
 	{
-		return FCrc::MemCrc32(&point, sizeof(FIntVector2));
+		// Multiplicative mix of both coordinates, much cheaper than a CRC over the bytes
+		uint64 key = ((uint64)(uint32)point.X << 32) | (uint32)point.Y;
+		key *= 0x9E3779B97F4A7C15ull;
+		return (uint32)(key ^ (key >> 32));
 	}
 
 };
@@ -1,18 +1,22 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-using UnrealBuildTool;
-
-public class CashGen : ModuleRules
-{
-	public CashGen(ReadOnlyTargetRules Target) : base(Target)
-    {
-        
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "RenderCore", "RHI" });
-
-        PrivateDependencyModuleNames.AddRange(new string[] { "ProceduralMeshComponent"  });
-      
-        PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
-    }
-
-
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using System.IO;
+using UnrealBuildTool;
+
+public class CashGen : ModuleRules
+{
+	public CashGen(ReadOnlyTargetRules Target) : base(Target)
+    {
+        
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "RenderCore", "RHI" });
+
+        PrivateDependencyModuleNames.AddRange(new string[] { "ProceduralMeshComponent", "TraceLog" });
+
+        // Engine independent generator core, header only. Builds standalone with its benchmark through its own CMakeLists.txt
+        PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "..", "ThirdParty", "CashGenCore", "include"));
+      
+        PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+    }
+
+
+}
@@ -0,0 +1,354 @@
+// Headless benchmark for the CashGen generator core.
+// Times each stage of building a tile across tile sizes and LOD divisors, and writes one row per
+// stage and configuration as CSV (default) or JSON lines to stdout.
+// With --acmr it measures the vertex cache instead: average cache misses per triangle for the tile's
+// triangles in grid order and in the optimised order the plugin uses, for a few FIFO cache sizes.
+// --generic times the generic kernels even for sizes that have fixed width ones, to compare the two.
+//
+// Usage: CashGenBench [--sizes 16,32,64] [--divisors 1,2,4] [--min-time 0.2] [--min-iterations 5] [--format csv|json] [--acmr] [--generic]
+
+#include "CashGenCore/CashGenCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace CashGenCore;
+
+namespace
+{
+	struct Options
+	{
+		std::vector<int32_t> Sizes = { 16, 32, 64, 128, 256 };
+		std::vector<int32_t> Divisors = { 1, 2, 4 };
+		double MinSeconds = 0.2;
+		int32_t MinIterations = 5;
+		bool Json = false;
+		bool Acmr = false;
+		bool ForceGeneric = false;
+	};
+
+	struct StageResult
+	{
+		int32_t Iterations = 0;
+		double MeanMicros = 0.0;
+		double MinMicros = 0.0;
+		double MedianMicros = 0.0;
+	};
+
+	// Keeps the optimiser from dropping work whose results are never read
+	volatile float GSink = 0.0f;
+
+	uint32_t Hash(int32_t aX, int32_t aY)
+	{
+		uint32_t h = (uint32_t)aX * 0x8da6b343u ^ (uint32_t)aY * 0xd8163841u;
+		h ^= h >> 13;
+		h *= 0x2c1b3c6du;
+		h ^= h >> 16;
+		return h;
+	}
+
+	float Lattice(int32_t aX, int32_t aY)
+	{
+		return (Hash(aX, aY) & 0xffffff) / float(0xffffff) * 2.0f - 1.0f;
+	}
+
+	/** Four octaves of value noise, standing in for a height interface so sampling has a realistic cost */
+	float NoiseHeight(int32_t aWorldX, int32_t aWorldY)
+	{
+		float sum = 0.0f;
+		float amplitude = 0.5f;
+		float frequency = 1.0f / 20000.0f;
+		for (int32_t octave = 0; octave < 4; ++octave)
+		{
+			const float fx = aWorldX * frequency;
+			const float fy = aWorldY * frequency;
+			const int32_t x0 = (int32_t)std::floor(fx);
+			const int32_t y0 = (int32_t)std::floor(fy);
+			const float tx = fx - x0;
+			const float ty = fy - y0;
+			const float sx = tx * tx * (3.0f - 2.0f * tx);
+			const float sy = ty * ty * (3.0f - 2.0f * ty);
+			const float bottom = Lattice(x0, y0) + (Lattice(x0 + 1, y0) - Lattice(x0, y0)) * sx;
+			const float top = Lattice(x0, y0 + 1) + (Lattice(x0 + 1, y0 + 1) - Lattice(x0, y0 + 1)) * sx;
+			sum += (bottom + (top - bottom) * sy) * amplitude;
+			amplitude *= 0.5f;
+			frequency *= 2.0f;
+		}
+		return sum;
+	}
+
+	StageResult TimeStage(const Options& aOptions, const std::function<void()>& aStage)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		// Warm the caches and page in the buffers
+		aStage();
+
+		std::vector<double> samples;
+		const Clock::time_point start = Clock::now();
+		while ((int32_t)samples.size() < aOptions.MinIterations || std::chrono::duration<double>(Clock::now() - start).count() < aOptions.MinSeconds)
+		{
+			const Clock::time_point stageStart = Clock::now();
+			aStage();
+			samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - stageStart).count());
+		}
+
+		StageResult result;
+		result.Iterations = (int32_t)samples.size();
+		double total = 0.0;
+		for (double sample : samples)
+		{
+			total += sample;
+		}
+		result.MeanMicros = total / samples.size();
+		std::sort(samples.begin(), samples.end());
+		result.MinMicros = samples.front();
+		result.MedianMicros = samples[samples.size() / 2];
+		return result;
+	}
+
+	void PrintHeader(const Options& aOptions)
+	{
+		if (aOptions.Json)
+		{
+			return;
+		}
+		if (aOptions.Acmr)
+		{
+			std::printf("tile_units,divisor,vertices,triangles,cache_size,acmr_grid_order,acmr_optimised,atvr_optimised,index_bytes_32,index_bytes_16\n");
+		}
+		else
+		{
+			std::printf("stage,tile_units,divisor,vertices,indices,iterations,mean_us,median_us,min_us,ns_per_vertex\n");
+		}
+	}
+
+	void PrintResult(const Options& aOptions, const char* aStage, int32_t aSize, int32_t aDivisor, const TileLayout& aLayout, const StageResult& aResult)
+	{
+		const double nsPerVertex = aResult.MedianMicros * 1000.0 / aLayout.NumVertices;
+		if (aOptions.Json)
+		{
+			std::printf("{\"stage\":\"%s\",\"tile_units\":%d,\"divisor\":%d,\"vertices\":%d,\"indices\":%d,\"iterations\":%d,\"mean_us\":%.3f,\"median_us\":%.3f,\"min_us\":%.3f,\"ns_per_vertex\":%.3f}\n",
+				aStage, aSize, aDivisor, aLayout.NumVertices, aLayout.NumIndices, aResult.Iterations, aResult.MeanMicros, aResult.MedianMicros, aResult.MinMicros, nsPerVertex);
+		}
+		else
+		{
+			std::printf("%s,%d,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f\n",
+				aStage, aSize, aDivisor, aLayout.NumVertices, aLayout.NumIndices, aResult.Iterations, aResult.MeanMicros, aResult.MedianMicros, aResult.MinMicros, nsPerVertex);
+		}
+	}
+
+	void RunConfiguration(const Options& aOptions, int32_t aSize, int32_t aDivisor)
+	{
+		const TileLayout layout = MakeTileLayout(aSize, aSize, aDivisor);
+		const TileLayout sourceLayout = MakeTileLayout(aSize, aSize, 1);
+
+		const float unitSize = 300.0f;
+		const float amplitude = 5000.0f;
+		const int32_t sampleSpacing = (int32_t)(unitSize * aDivisor);
+		const int32_t sectorX = 3;
+		const int32_t sectorY = -2;
+
+		std::vector<float> heights(layout.NumHeights);
+		std::vector<float> sourceHeights(sourceLayout.NumHeights);
+		std::vector<Vec3> positions(layout.NumVertices);
+		std::vector<Vec3> normals(layout.NumVertices);
+		std::vector<Tangent> tangents(layout.NumVertices);
+		std::vector<Color> colours(layout.NumVertices);
+		std::vector<Vec2> uvs(layout.NumVertices);
+		std::vector<int32_t> triangles(layout.NumIndices);
+
+		SampleHeights(sourceLayout, sectorX, sectorY, (int32_t)unitSize, NoiseHeight, sourceHeights.data());
+		const TileKernels& kernels = GetTileKernels(layout, aOptions.ForceGeneric);
+
+		PrintResult(aOptions, "Setup", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+		{
+			BuildGridIndices(layout, triangles.data());
+			BuildGridUVs(layout, uvs.data());
+		}));
+
+		// Once per layout in the plugin, when the pools are filled
+		std::vector<int32_t> vertexOrder(layout.NumVertices);
+		PrintResult(aOptions, "IndexOrder", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+		{
+			BuildOptimizedTileIndices(layout, triangles.data(), vertexOrder.data());
+		}));
+
+		PrintResult(aOptions, "Sampling", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+		{
+			SampleHeights(layout, sectorX, sectorY, sampleSpacing, NoiseHeight, heights.data());
+		}));
+
+		if (aDivisor > 1)
+		{
+			PrintResult(aOptions, "Subsampling", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+			{
+				SubsampleHeights(layout, sectorX, sectorY, sampleSpacing, sourceHeights.data(), sourceLayout.HeightMapRowLength, aDivisor, NoiseHeight, heights.data());
+			}));
+		}
+
+		PrintResult(aOptions, "Curvature", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+		{
+			GSink = GSink + kernels.MeasureCurvature(layout, heights.data());
+		}));
+
+		PrintResult(aOptions, "Geometry", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+		{
+			kernels.BuildPositions(layout, heights.data(), (float)sampleSpacing, amplitude, positions.data());
+		}));
+
+		PrintResult(aOptions, "Normals", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+		{
+			kernels.BuildNormals(layout, heights.data(), unitSize * aDivisor, amplitude, normals.data(), tangents.data(), colours.data());
+		}));
+
+		PrintResult(aOptions, "Skirts", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+		{
+			BuildSkirts(layout, positions.data(), normals.data(), nullptr);
+		}));
+
+		// Everything a worker does for one render job, sampling included
+		PrintResult(aOptions, "Total", aSize, aDivisor, layout, TimeStage(aOptions, [&]()
+		{
+			// Picked once per job, as the workers do
+			const TileKernels& jobKernels = GetTileKernels(layout, aOptions.ForceGeneric);
+			SampleHeights(layout, sectorX, sectorY, sampleSpacing, NoiseHeight, heights.data());
+			GSink = GSink + jobKernels.MeasureCurvature(layout, heights.data());
+			jobKernels.BuildPositions(layout, heights.data(), (float)sampleSpacing, amplitude, positions.data());
+			jobKernels.BuildNormals(layout, heights.data(), unitSize * aDivisor, amplitude, normals.data(), tangents.data(), colours.data());
+			BuildSkirts(layout, positions.data(), normals.data(), nullptr);
+		}));
+
+		GSink = GSink + positions[layout.NumVertices - 1].Z + normals[layout.NumGridVertices / 2].Z + (float)triangles[layout.NumIndices - 1];
+	}
+
+	void MeasureConfiguration(const Options& aOptions, int32_t aSize, int32_t aDivisor)
+	{
+		const TileLayout layout = MakeTileLayout(aSize, aSize, aDivisor);
+
+		std::vector<int32_t> gridOrder(layout.NumIndices);
+		BuildGridIndices(layout, gridOrder.data());
+		BuildSkirtIndices(layout, gridOrder.data());
+
+		std::vector<int32_t> optimised(layout.NumIndices);
+		std::vector<int32_t> vertexOrder(layout.NumVertices);
+		BuildOptimizedTileIndices(layout, optimised.data(), vertexOrder.data());
+
+		const int32_t numTriangles = layout.NumIndices / 3;
+		const int32_t indexBytes16 = CanUse16BitIndices(layout) ? layout.NumIndices * 2 : 0;
+		for (int32_t cacheSize : { 16, 24, 32 })
+		{
+			const float gridAcmr = MeasureACMR(gridOrder.data(), gridOrder.size(), (size_t)layout.NumVertices, cacheSize);
+			const float optimisedAcmr = MeasureACMR(optimised.data(), optimised.size(), (size_t)layout.NumVertices, cacheSize);
+			const float optimisedAtvr = optimisedAcmr * numTriangles / layout.NumVertices;
+			if (aOptions.Json)
+			{
+				std::printf("{\"tile_units\":%d,\"divisor\":%d,\"vertices\":%d,\"triangles\":%d,\"cache_size\":%d,\"acmr_grid_order\":%.4f,\"acmr_optimised\":%.4f,\"atvr_optimised\":%.4f,\"index_bytes_32\":%d,\"index_bytes_16\":%d}\n",
+					aSize, aDivisor, layout.NumVertices, numTriangles, cacheSize, gridAcmr, optimisedAcmr, optimisedAtvr, layout.NumIndices * 4, indexBytes16);
+			}
+			else
+			{
+				std::printf("%d,%d,%d,%d,%d,%.4f,%.4f,%.4f,%d,%d\n",
+					aSize, aDivisor, layout.NumVertices, numTriangles, cacheSize, gridAcmr, optimisedAcmr, optimisedAtvr, layout.NumIndices * 4, indexBytes16);
+			}
+		}
+	}
+
+	std::vector<int32_t> ParseList(const char* aList)
+	{
+		std::vector<int32_t> values;
+		std::string list(aList);
+		size_t start = 0;
+		while (start < list.size())
+		{
+			size_t end = list.find(',', start);
+			if (end == std::string::npos)
+			{
+				end = list.size();
+			}
+			values.push_back(std::atoi(list.substr(start, end - start).c_str()));
+			start = end + 1;
+		}
+		return values;
+	}
+
+	bool ParseOptions(int aArgc, char** aArgv, Options& aOutOptions)
+	{
+		for (int i = 1; i < aArgc; ++i)
+		{
+			const bool hasValue = i + 1 < aArgc;
+			if (std::strcmp(aArgv[i], "--sizes") == 0 && hasValue)
+			{
+				aOutOptions.Sizes = ParseList(aArgv[++i]);
+			}
+			else if (std::strcmp(aArgv[i], "--divisors") == 0 && hasValue)
+			{
+				aOutOptions.Divisors = ParseList(aArgv[++i]);
+			}
+			else if (std::strcmp(aArgv[i], "--min-time") == 0 && hasValue)
+			{
+				aOutOptions.MinSeconds = std::atof(aArgv[++i]);
+			}
+			else if (std::strcmp(aArgv[i], "--min-iterations") == 0 && hasValue)
+			{
+				aOutOptions.MinIterations = std::max(1, std::atoi(aArgv[++i]));
+			}
+			else if (std::strcmp(aArgv[i], "--format") == 0 && hasValue)
+			{
+				aOutOptions.Json = std::strcmp(aArgv[++i], "json") == 0;
+			}
+			else if (std::strcmp(aArgv[i], "--acmr") == 0)
+			{
+				aOutOptions.Acmr = true;
+			}
+			else if (std::strcmp(aArgv[i], "--generic") == 0)
+			{
+				aOutOptions.ForceGeneric = true;
+			}
+			else
+			{
+				std::fprintf(stderr, "Usage: %s [--sizes 16,32,64] [--divisors 1,2,4] [--min-time 0.2] [--min-iterations 5] [--format csv|json] [--acmr] [--generic]\n", aArgv[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+
+	PrintHeader(options);
+	for (int32_t size : options.Sizes)
+	{
+		for (int32_t divisor : options.Divisors)
+		{
+			// Same rule as the LOD config, the divisor has to leave at least two quads a side
+			if (divisor <= 0 || size % divisor != 0 || size / divisor < 2)
+			{
+				continue;
+			}
+			if (options.Acmr)
+			{
+				MeasureConfiguration(options, size, divisor);
+			}
+			else
+			{
+				RunConfiguration(options, size, divisor);
+			}
+		}
+	}
+	return 0;
+}
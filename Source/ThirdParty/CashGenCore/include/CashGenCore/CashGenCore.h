@@ -0,0 +1,13 @@
+#pragma once
+
+/**
+* Engine independent tile generation: heightmap sampling, geometry, normals, skirts and index ordering.
+* Everything works on plain arrays laid out by a TileLayout, so it can be wrapped by the plugin's
+* workers or driven directly by the benchmark.
+*/
+#include "CashGenCore/CoreTypes.h"
+#include "CashGenCore/Geometry.h"
+#include "CashGenCore/Heights.h"
+#include "CashGenCore/IndexOrder.h"
+#include "CashGenCore/Kernels.h"
+#include "CashGenCore/TileLayout.h"
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/**
+* Plain data types for the engine independent generator core.
+* Each one matches the memory layout of the engine type it stands in for, so the plugin can hand
+* its mesh data streams straight to the core without copying.
+*/
+namespace CashGenCore
+{
+	/** FVector2D */
+	struct Vec2
+	{
+		float X;
+		float Y;
+	};
+
+	/** FVector */
+	struct Vec3
+	{
+		float X;
+		float Y;
+		float Z;
+	};
+
+	/** FProcMeshTangent */
+	struct Tangent
+	{
+		Vec3 TangentX;
+		bool bFlipTangentY;
+	};
+
+	/** FColor, which is stored BGRA on every platform the plugin ships on */
+	struct Color
+	{
+		uint8_t B;
+		uint8_t G;
+		uint8_t R;
+		uint8_t A;
+	};
+
+	inline Vec3 operator+(const Vec3& a, const Vec3& b) { return Vec3{ a.X + b.X, a.Y + b.Y, a.Z + b.Z }; }
+
+	inline Vec3 Cross(const Vec3& a, const Vec3& b)
+	{
+		return Vec3{ a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X };
+	}
+
+	/** Unit length copy of the vector given its squared length, which the caller knows isn't too short */
+	inline Vec3 Normalise(const Vec3& v, const float aLengthSq)
+	{
+		const float scale = 1.0f / std::sqrt(aLengthSq);
+		return Vec3{ v.X * scale, v.Y * scale, v.Z * scale };
+	}
+
+	/** Unit length copy of the vector, or zero if it's too short to normalise (FVector::GetSafeNormal) */
+	inline Vec3 SafeNormal(const Vec3& v)
+	{
+		const float lengthSq = v.X * v.X + v.Y * v.Y + v.Z * v.Z;
+		if (lengthSq < 1.e-8f)
+		{
+			return Vec3{ 0.0f, 0.0f, 0.0f };
+		}
+		return Normalise(v, lengthSq);
+	}
+}
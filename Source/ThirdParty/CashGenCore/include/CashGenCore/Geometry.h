@@ -0,0 +1,233 @@
+#pragma once
+
+#include "CashGenCore/CoreTypes.h"
+#include "CashGenCore/TileLayout.h"
+
+namespace CashGenCore
+{
+	/** Depth the skirts hang down to, far enough to hide any crack between neighbouring LODs */
+	static const float SkirtDepth = -30000.0f;
+
+	/** Two triangles per grid quad. These never change for a layout, so they're built once per pool slot */
+	inline void BuildGridIndices(const TileLayout& aLayout, int32_t* aOutTriangles)
+	{
+		const int32_t rowLength = aLayout.NumXVerts;
+		int32_t triCounter = 0;
+		for (int32_t y = 0; y < aLayout.YUnits; ++y)
+		{
+			for (int32_t x = 0; x < aLayout.XUnits; ++x)
+			{
+				//TR
+				aOutTriangles[triCounter++] = x + ((y + 1) * rowLength);
+				//BL
+				aOutTriangles[triCounter++] = (x + 1) + (y * rowLength);
+				//BR
+				aOutTriangles[triCounter++] = x + (y * rowLength);
+
+				//BL
+				aOutTriangles[triCounter++] = (x + 1) + (y * rowLength);
+				//TR
+				aOutTriangles[triCounter++] = x + ((y + 1) * rowLength);
+				// TL
+				aOutTriangles[triCounter++] = (x + 1) + ((y + 1) * rowLength);
+			}
+		}
+	}
+
+	/** Grid UVs, built once per pool slot like the indices */
+	inline void BuildGridUVs(const TileLayout& aLayout, Vec2* aOutUVs)
+	{
+		const int32_t rowLength = aLayout.NumXVerts;
+		for (int32_t y = 0; y < aLayout.NumYVerts; ++y)
+		{
+			for (int32_t x = 0; x < aLayout.NumXVerts; ++x)
+			{
+				aOutUVs[x + (y * rowLength)] = Vec2{ x * 1.0f / rowLength, y * 1.0f / rowLength };
+			}
+		}
+	}
+
+	/**
+	* Grid vertex positions from the heightmap, relative to the tile origin.
+	* A non zero FixedXUnits has to match aLayout.XUnits, and makes the row loops fixed length (see Kernels.h)
+	*/
+	template<int32_t FixedXUnits = 0>
+	void BuildPositions(const TileLayout& aLayout, const float* aHeights, const float aVertexSpacing, const float aAmplitude, Vec3* aOutPositions)
+	{
+		const int32_t rowLength = FixedXUnits > 0 ? FixedXUnits + 1 : aLayout.NumXVerts;
+		const int32_t heightMapRowLength = rowLength + 2;
+		for (int32_t y = 0; y < aLayout.NumYVerts; ++y)
+		{
+			// Skip the border row and column
+			const float* heights = &aHeights[1 + ((y + 1) * heightMapRowLength)];
+			Vec3* positions = &aOutPositions[y * rowLength];
+			const float positionY = y * aVertexSpacing;
+			for (int32_t x = 0; x < rowLength; ++x)
+			{
+				positions[x] = Vec3{ x * aVertexSpacing, positionY, heights[x] * aAmplitude };
+			}
+		}
+	}
+
+	/**
+	* Grid vertex normals from the four neighbouring heights, a fixed tangent, and the slope
+	* (0 flat, 255 vertical) in the colour's red channel. FixedXUnits as for BuildPositions
+	*/
+	template<int32_t FixedXUnits = 0>
+	void BuildNormals(const TileLayout& aLayout, const float* aHeights, const float aVertexSpacing, const float aAmplitude,
+		Vec3* aOutNormals, Tangent* aOutTangents, Color* aOutColours)
+	{
+		const int32_t rowLength = FixedXUnits > 0 ? FixedXUnits + 1 : aLayout.NumXVerts;
+		const int32_t heightMapRowLength = rowLength + 2;
+		const Tangent tangent = { Vec3{ 0.0f, 1.0f, 0.0f }, false };
+
+		// The normal is the sum of the crosses of the four edges to the neighbours, going round. Written out, the
+		// zero terms drop away and Z is the same for every vertex, so only the height differences are left per vertex
+		const float spacing = aVertexSpacing;
+		const float spacingSq = spacing * spacing;
+		const float normalZ = ((spacingSq + spacingSq) + spacingSq) + spacingSq;
+		const float normalZSq = normalZ * normalZ;
+		// Z alone decides whether anything can be too short to normalise, so that's settled once for the whole tile
+		const bool isDegenerate = normalZSq < 1.e-8f;
+
+		for (int32_t y = 0; y < aLayout.NumYVerts; ++y)
+		{
+			const float* heights = &aHeights[1 + ((y + 1) * heightMapRowLength)];
+			Vec3* normals = &aOutNormals[y * rowLength];
+			Tangent* tangents = &aOutTangents[y * rowLength];
+			Color* colours = &aOutColours[y * rowLength];
+			for (int32_t x = 0; x < rowLength; ++x)
+			{
+				const float* height = &heights[x];
+				const float origin = height[0] * aAmplitude;
+				const float up = height[heightMapRowLength] * aAmplitude - origin;
+				const float down = height[-heightMapRowLength] * aAmplitude - origin;
+				const float left = height[1] * aAmplitude - origin;
+				const float right = height[-1] * aAmplitude - origin;
+
+				const float normalX = ((-(left * spacing) + spacing * right) + right * spacing) + -(spacing * left);
+				const float normalY = ((-(spacing * up) + -(up * spacing)) + spacing * down) + down * spacing;
+
+				const Vec3 normal = isDegenerate
+					? SafeNormal(Vec3{ normalX, normalY, normalZ })
+					: Normalise(Vec3{ normalX, normalY, normalZ }, normalX * normalX + normalY * normalY + normalZSq);
+
+				normals[x] = normal;
+				tangents[x] = tangent;
+				// Rounded to nearest, and a vertical face wraps to 0 as it always has. The value is never negative,
+				// so truncating is the same as flooring and doesn't need a libm call
+				colours[x].R = (uint8_t)(int32_t)((1.0f - std::fabs(normal.Z)) * 256 + 0.5f);
+			}
+		}
+	}
+
+	/**
+	* Skirt vertices dropped from each edge of the grid, and the triangles joining them to it.
+	* aNormals can be null for collision meshes, otherwise skirt vertices copy the normal of the edge vertex above.
+	* aPositions or aTriangles can be null to build only the other half, skirt triangles never change for a layout.
+	*/
+	inline void BuildSkirts(const TileLayout& aLayout, Vec3* aPositions, Vec3* aNormals, int32_t* aTriangles)
+	{
+		const int32_t numXVerts = aLayout.NumXVerts;
+		const int32_t numYVerts = aLayout.NumYVerts;
+
+		int32_t startIndex = numXVerts * numYVerts;
+		int32_t triStartIndex = aLayout.NumGridIndices;
+
+		const auto dropVertex = [&](const int32_t aSkirtIndex, const int32_t aEdgeIndex)
+		{
+			if (!aPositions)
+			{
+				return;
+			}
+			aPositions[aSkirtIndex] = Vec3{ aPositions[aEdgeIndex].X, aPositions[aEdgeIndex].Y, SkirtDepth };
+			if (aNormals)
+			{
+				aNormals[aSkirtIndex] = aNormals[aEdgeIndex];
+			}
+		};
+
+		const auto setQuad = [&](const int32_t aAt, const int32_t a0, const int32_t a1, const int32_t a2, const int32_t a3, const int32_t a4, const int32_t a5)
+		{
+			if (!aTriangles)
+			{
+				return;
+			}
+			int32_t* triangles = &aTriangles[aAt];
+			triangles[0] = a0;
+			triangles[1] = a1;
+			triangles[2] = a2;
+			triangles[3] = a3;
+			triangles[4] = a4;
+			triangles[5] = a5;
+		};
+
+		// Bottom edge
+		for (int32_t i = 0; i < numXVerts; ++i)
+		{
+			dropVertex(startIndex + i, i);
+		}
+		for (int32_t i = 0; i < numXVerts - 1; ++i)
+		{
+			setQuad(triStartIndex + (i * 6), i, startIndex + i + 1, startIndex + i, i + 1, startIndex + i + 1, i);
+		}
+		triStartIndex += (numXVerts - 1) * 6;
+
+		// Top edge
+		startIndex = numXVerts * (numYVerts + 1);
+		const int32_t topRow = startIndex - (numXVerts * 2);
+		for (int32_t i = 0; i < numXVerts; ++i)
+		{
+			dropVertex(startIndex + i, topRow + i);
+		}
+		for (int32_t i = 0; i < numXVerts - 1; ++i)
+		{
+			setQuad(triStartIndex + (i * 6), topRow + i, startIndex + i, topRow + i + 1, topRow + i + 1, startIndex + i, startIndex + i + 1);
+		}
+		triStartIndex += (numXVerts - 1) * 6;
+
+		// Right edge, the corners are shared with the bottom and top rows
+		startIndex = numXVerts * (numYVerts + 2);
+		for (int32_t i = 0; i < numYVerts - 2; ++i)
+		{
+			dropVertex(startIndex + i, (i + 1) * numXVerts);
+		}
+		// Bottom right corner
+		setQuad(triStartIndex, 0, numXVerts * numYVerts, numXVerts, numXVerts, numXVerts * numYVerts, numXVerts * (numYVerts + 2));
+		triStartIndex += 6;
+		// Top right corner
+		setQuad(triStartIndex, numXVerts * (numYVerts - 1), (numXVerts * (numYVerts + 2)) + numYVerts - 3, numXVerts * (numYVerts + 1),
+			numXVerts * (numYVerts - 1), numXVerts * (numYVerts - 2), (numXVerts * (numYVerts + 2)) + numYVerts - 3);
+		triStartIndex += 6;
+		for (int32_t i = 0; i < numYVerts - 3; ++i)
+		{
+			setQuad(triStartIndex + (i * 6), numXVerts * (i + 1), startIndex + i, numXVerts * (i + 2), numXVerts * (i + 2), startIndex + i, startIndex + i + 1);
+		}
+		triStartIndex += (numYVerts - 3) * 6;
+
+		// Left edge
+		startIndex += numYVerts - 2;
+		for (int32_t i = 0; i < numYVerts - 2; ++i)
+		{
+			dropVertex(startIndex + i, ((i + 1) * numXVerts) + numXVerts - 1);
+		}
+		// Bottom left corner
+		setQuad(triStartIndex, numXVerts - 1, (numXVerts * 2) - 1, startIndex, startIndex, (numXVerts * numYVerts) + numXVerts - 1, numXVerts - 1);
+		triStartIndex += 6;
+		// Top left corner
+		setQuad(triStartIndex, (numXVerts * numYVerts) - 1, (numXVerts * (numYVerts + 2)) - 1, (numXVerts * (numYVerts + 2)) + ((numYVerts - 2) * 2) - 1,
+			(numXVerts * numYVerts) - 1, (numXVerts * (numYVerts + 2)) + ((numYVerts - 2) * 2) - 1, (numXVerts * (numYVerts - 2)) + numXVerts - 1);
+		triStartIndex += 6;
+		for (int32_t i = 0; i < numYVerts - 3; ++i)
+		{
+			setQuad(triStartIndex + (i * 6), (numXVerts * (i + 1)) + numXVerts - 1, (numXVerts * (i + 2)) + numXVerts - 1, startIndex + i + 1,
+				(numXVerts * (i + 1)) + numXVerts - 1, startIndex + i + 1, startIndex + i);
+		}
+	}
+
+	/** Just the skirt triangles, written after the grid's */
+	inline void BuildSkirtIndices(const TileLayout& aLayout, int32_t* aTriangles)
+	{
+		BuildSkirts(aLayout, nullptr, nullptr, aTriangles);
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "CashGenCore/TileLayout.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CashGenCore
+{
+	/**
+	* Fills the heightmap for a tile, border included, from aHeightAt(worldX, worldY).
+	* aSampleSpacing is the world distance between samples at the tile's LOD.
+	*/
+	template<typename HeightFunction>
+	void SampleHeights(const TileLayout& aLayout, const int32_t aSectorX, const int32_t aSectorY, const int32_t aSampleSpacing, HeightFunction&& aHeightAt, float* aOutHeights)
+	{
+		const int32_t rowLength = aLayout.HeightMapRowLength;
+		const int32_t numRows = aLayout.NumHeights / rowLength;
+		for (int32_t y = 0; y < numRows; ++y)
+		{
+			// The border sample sits one spacing before the tile origin
+			const int32_t worldY = (((aSectorY * aLayout.XUnits) + y) * aSampleSpacing) - aSampleSpacing;
+			for (int32_t x = 0; x < rowLength; ++x)
+			{
+				const int32_t worldX = (((aSectorX * aLayout.XUnits) + x) * aSampleSpacing) - aSampleSpacing;
+				aOutHeights[x + (rowLength * y)] = aHeightAt(worldX, worldY);
+			}
+		}
+	}
+
+	/**
+	* Fills the heightmap for a tile from a finer heightmap of the same tile, where the coarse spacing is
+	* aRatio times the finer one. Only the border ring lies outside the finer tile, so only that is sampled.
+	*/
+	template<typename HeightFunction>
+	void SubsampleHeights(const TileLayout& aLayout, const int32_t aSectorX, const int32_t aSectorY, const int32_t aSampleSpacing,
+		const float* aSourceHeights, const int32_t aSourceRowLength, const int32_t aRatio, HeightFunction&& aHeightAt, float* aOutHeights)
+	{
+		const int32_t rowLength = aLayout.HeightMapRowLength;
+		const int32_t numRows = aLayout.NumHeights / rowLength;
+		for (int32_t y = 0; y < numRows; ++y)
+		{
+			const bool isBorderRow = y == 0 || y == numRows - 1;
+			for (int32_t x = 0; x < rowLength; ++x)
+			{
+				if (isBorderRow || x == 0 || x == rowLength - 1)
+				{
+					const int32_t worldX = (((aSectorX * aLayout.XUnits) + x) * aSampleSpacing) - aSampleSpacing;
+					const int32_t worldY = (((aSectorY * aLayout.XUnits) + y) * aSampleSpacing) - aSampleSpacing;
+					aOutHeights[x + (rowLength * y)] = aHeightAt(worldX, worldY);
+				}
+				else
+				{
+					// Both heightmaps have the tile origin at sample 1
+					const int32_t sourceX = (x - 1) * aRatio + 1;
+					const int32_t sourceY = (y - 1) * aRatio + 1;
+					aOutHeights[x + (rowLength * y)] = aSourceHeights[sourceX + (aSourceRowLength * sourceY)];
+				}
+			}
+		}
+	}
+
+	/**
+	* RMS of the heightmap's second differences, in heightmap units per sample squared.
+	* Scale by amplitude / spacing^2 to get world units. FixedXUnits as for BuildPositions
+	*/
+	template<int32_t FixedXUnits = 0>
+	float MeasureCurvature(const TileLayout& aLayout, const float* aHeights)
+	{
+		const int32_t rowLength = FixedXUnits > 0 ? FixedXUnits + 3 : aLayout.HeightMapRowLength;
+		const int32_t numRows = aLayout.NumHeights / aLayout.HeightMapRowLength;
+
+		double sumSquares = 0.0;
+		for (int32_t y = 1; y < numRows - 1; ++y)
+		{
+			const float* heights = &aHeights[rowLength * y];
+			for (int32_t x = 1; x < rowLength - 1; ++x)
+			{
+				const float* height = &heights[x];
+				const float d2x = height[-1] - 2.0f * height[0] + height[1];
+				const float d2y = height[-rowLength] - 2.0f * height[0] + height[rowLength];
+				sumSquares += d2x * d2x + d2y * d2y;
+			}
+		}
+
+		const int32_t numSamples = (numRows - 2) * (rowLength - 2) * 2;
+		return numSamples > 0 ? (float)std::sqrt(sumSquares / numSamples) : 0.0f;
+	}
+
+	/**
+	* Bilinear height and gradient at a fractional sample position in a bordered heightmap, where sample 1 is the
+	* tile origin. Positions are clamped to the cells inside the border. The gradient is in heightmap units per sample.
+	*/
+	inline float SampleBilinear(const float* aHeights, const int32_t aRowLength, const int32_t aNumRows, const float aSampleX, const float aSampleY,
+		float& aOutGradientX, float& aOutGradientY)
+	{
+		const int32_t x0 = std::min(std::max((int32_t)std::floor(aSampleX), 1), aRowLength - 3);
+		const int32_t y0 = std::min(std::max((int32_t)std::floor(aSampleY), 1), aNumRows - 3);
+		const float fx = std::min(std::max(aSampleX - x0, 0.0f), 1.0f);
+		const float fy = std::min(std::max(aSampleY - y0, 0.0f), 1.0f);
+
+		const float* heights = &aHeights[x0 + aRowLength * y0];
+		const float h00 = heights[0];
+		const float h10 = heights[1];
+		const float h01 = heights[aRowLength];
+		const float h11 = heights[aRowLength + 1];
+
+		aOutGradientX = (h10 - h00) + ((h11 - h01) - (h10 - h00)) * fy;
+		aOutGradientY = (h01 - h00) + ((h11 - h10) - (h01 - h00)) * fx;
+
+		const float top = h00 + (h10 - h00) * fx;
+		const float bottom = h01 + (h11 - h01) * fx;
+		return top + (bottom - top) * fy;
+	}
+}
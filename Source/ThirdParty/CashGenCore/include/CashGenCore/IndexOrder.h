@@ -0,0 +1,246 @@
+#pragma once
+
+#include "CashGenCore/Geometry.h"
+#include "CashGenCore/TileLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace CashGenCore
+{
+	/** Post transform cache size the triangle order is tuned for. Larger than most real caches, which costs little on smaller ones */
+	static const int32_t VertexCacheSize = 32;
+
+	/** True if every index of the layout fits in 16 bits */
+	inline bool CanUse16BitIndices(const TileLayout& aLayout)
+	{
+		return aLayout.NumVertices <= 0x10000;
+	}
+
+	namespace Detail
+	{
+		/** Forsyth's vertex score: recently used vertices score high, and so do vertices with few triangles left, so stragglers get finished off */
+		inline float ScoreVertex(const int32_t aCachePosition, const int32_t aNumRemainingTriangles)
+		{
+			if (aNumRemainingTriangles == 0)
+			{
+				return -1.0f;
+			}
+
+			float score = 0.0f;
+			if (aCachePosition >= 0)
+			{
+				// The last triangle's vertices get a fixed score, so the next one doesn't just reuse them in the same order
+				if (aCachePosition < 3)
+				{
+					score = 0.75f;
+				}
+				else
+				{
+					const float scaler = 1.0f / (VertexCacheSize - 3);
+					score = std::pow(1.0f - (aCachePosition - 3) * scaler, 1.5f);
+				}
+			}
+
+			return score + 2.0f / std::sqrt((float)aNumRemainingTriangles);
+		}
+	}
+
+	/**
+	* Reorders triangles for the post transform vertex cache, after Forsyth's linear speed optimiser.
+	* Picks the highest scoring triangle touching the simulated cache each step, and only falls back to the
+	* next unused triangle in the input order when the cache has nothing left to offer.
+	*/
+	template<typename IndexType>
+	void OptimizeVertexCache(const IndexType* aIndices, const size_t aNumIndices, const size_t aNumVertices, IndexType* aOutIndices)
+	{
+		const size_t numTriangles = aNumIndices / 3;
+
+		// Triangles using each vertex, as offsets into one flat list
+		std::vector<int32_t> triangleOffsets(aNumVertices + 1, 0);
+		for (size_t i = 0; i < aNumIndices; ++i)
+		{
+			triangleOffsets[aIndices[i] + 1]++;
+		}
+		for (size_t v = 0; v < aNumVertices; ++v)
+		{
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		}
+		std::vector<int32_t> vertexTriangles(aNumIndices);
+		std::vector<int32_t> numRemaining(aNumVertices, 0);
+		for (size_t i = 0; i < aNumIndices; ++i)
+		{
+			const IndexType vertex = aIndices[i];
+			vertexTriangles[triangleOffsets[vertex] + numRemaining[vertex]++] = (int32_t)(i / 3);
+		}
+
+		std::vector<float> vertexScores(aNumVertices);
+		for (size_t v = 0; v < aNumVertices; ++v)
+		{
+			vertexScores[v] = Detail::ScoreVertex(-1, numRemaining[v]);
+		}
+
+		std::vector<float> triangleScores(numTriangles);
+		std::vector<bool> isEmitted(numTriangles, false);
+		for (size_t t = 0; t < numTriangles; ++t)
+		{
+			triangleScores[t] = vertexScores[aIndices[t * 3]] + vertexScores[aIndices[t * 3 + 1]] + vertexScores[aIndices[t * 3 + 2]];
+		}
+
+		// Room for the triangle being added on top of a full cache
+		std::vector<int32_t> cache;
+		std::vector<int32_t> nextCache;
+		cache.reserve(VertexCacheSize + 3);
+		nextCache.reserve(VertexCacheSize + 3);
+
+		size_t nextInputTriangle = 0;
+		int32_t bestTriangle = -1;
+		for (size_t emitted = 0; emitted < numTriangles; ++emitted)
+		{
+			if (bestTriangle < 0)
+			{
+				while (isEmitted[nextInputTriangle])
+				{
+					nextInputTriangle++;
+				}
+				bestTriangle = (int32_t)nextInputTriangle;
+			}
+
+			const IndexType* triangle = &aIndices[bestTriangle * 3];
+			aOutIndices[emitted * 3] = triangle[0];
+			aOutIndices[emitted * 3 + 1] = triangle[1];
+			aOutIndices[emitted * 3 + 2] = triangle[2];
+			isEmitted[bestTriangle] = true;
+
+			// The new triangle's vertices go to the front, everything else shuffles back
+			nextCache.assign(triangle, triangle + 3);
+			for (const int32_t vertex : cache)
+			{
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				{
+					nextCache.push_back(vertex);
+				}
+			}
+
+			for (int32_t corner = 0; corner < 3; ++corner)
+			{
+				const IndexType vertex = triangle[corner];
+				int32_t* triangles = &vertexTriangles[triangleOffsets[vertex]];
+				const int32_t numTrianglesLeft = numRemaining[vertex]--;
+				for (int32_t i = 0; i < numTrianglesLeft; ++i)
+				{
+					if (triangles[i] == bestTriangle)
+					{
+						std::swap(triangles[i], triangles[numTrianglesLeft - 1]);
+						break;
+					}
+				}
+			}
+
+			// Rescore everything in or just pushed out of the cache, and the triangles using it
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+			for (size_t i = 0; i < nextCache.size(); ++i)
+			{
+				const int32_t vertex = nextCache[i];
+				const int32_t cachePosition = i < (size_t)VertexCacheSize ? (int32_t)i : -1;
+
+				const float score = Detail::ScoreVertex(cachePosition, numRemaining[vertex]);
+				const float delta = score - vertexScores[vertex];
+				vertexScores[vertex] = score;
+
+				const int32_t* triangles = &vertexTriangles[triangleOffsets[vertex]];
+				for (int32_t j = 0; j < numRemaining[vertex]; ++j)
+				{
+					const int32_t candidate = triangles[j];
+					triangleScores[candidate] += delta;
+					if (triangleScores[candidate] > bestScore)
+					{
+						bestScore = triangleScores[candidate];
+						bestTriangle = candidate;
+					}
+				}
+			}
+
+			if (nextCache.size() > (size_t)VertexCacheSize)
+			{
+				nextCache.resize(VertexCacheSize);
+			}
+			std::swap(cache, nextCache);
+		}
+	}
+
+	/**
+	* Renumbers vertices in the order the triangles first use them, so vertex fetches walk the buffer forwards.
+	* aOutVertexOrder[new] is the old index of each vertex, and aIndices is rewritten in place. Unused vertices go last
+	*/
+	template<typename IndexType>
+	void BuildVertexOrder(IndexType* aIndices, const size_t aNumIndices, const size_t aNumVertices, int32_t* aOutVertexOrder)
+	{
+		std::vector<int32_t> newIndices(aNumVertices, -1);
+		int32_t numOrdered = 0;
+		for (size_t i = 0; i < aNumIndices; ++i)
+		{
+			int32_t& newIndex = newIndices[aIndices[i]];
+			if (newIndex < 0)
+			{
+				newIndex = numOrdered++;
+				aOutVertexOrder[newIndex] = (int32_t)aIndices[i];
+			}
+			aIndices[i] = (IndexType)newIndex;
+		}
+		for (size_t v = 0; v < aNumVertices; ++v)
+		{
+			if (newIndices[v] < 0)
+			{
+				aOutVertexOrder[numOrdered++] = (int32_t)v;
+			}
+		}
+	}
+
+	/**
+	* Average cache misses per triangle for a FIFO cache of aCacheSize, which is what most hardware has.
+	* 3 is every vertex transformed for every triangle, a regular grid can't do better than about 0.5
+	*/
+	template<typename IndexType>
+	float MeasureACMR(const IndexType* aIndices, const size_t aNumIndices, const size_t aNumVertices, const int32_t aCacheSize)
+	{
+		if (aNumIndices < 3)
+		{
+			return 0.0f;
+		}
+
+		// Timestamps instead of a real queue, a vertex is still cached if fewer than aCacheSize misses have happened since its own
+		std::vector<int64_t> missTimes(aNumVertices, -(int64_t)aCacheSize - 1);
+		int64_t numMisses = 0;
+		for (size_t i = 0; i < aNumIndices; ++i)
+		{
+			int64_t& missTime = missTimes[aIndices[i]];
+			if (numMisses - missTime > aCacheSize)
+			{
+				missTime = numMisses++;
+			}
+		}
+		return (float)((double)numMisses / (double)(aNumIndices / 3));
+	}
+
+	/**
+	* Every grid and skirt triangle of a layout in cache friendly order, numbered to match aOutVertexOrder.
+	* Built once per layout: the vertex streams stay in grid order, and aOutVertexOrder says which of them
+	* goes where when they're copied into a mesh section
+	*/
+	template<typename IndexType>
+	void BuildOptimizedTileIndices(const TileLayout& aLayout, IndexType* aOutTriangles, int32_t* aOutVertexOrder)
+	{
+		std::vector<int32_t> triangles(aLayout.NumIndices);
+		BuildGridIndices(aLayout, triangles.data());
+		BuildSkirtIndices(aLayout, triangles.data());
+
+		std::vector<IndexType> gridOrder(triangles.begin(), triangles.end());
+		OptimizeVertexCache(gridOrder.data(), gridOrder.size(), (size_t)aLayout.NumVertices, aOutTriangles);
+		BuildVertexOrder(aOutTriangles, (size_t)aLayout.NumIndices, (size_t)aLayout.NumVertices, aOutVertexOrder);
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CashGenCore/CoreTypes.h"
+#include "CashGenCore/Geometry.h"
+#include "CashGenCore/Heights.h"
+#include "CashGenCore/TileLayout.h"
+
+namespace CashGenCore
+{
+	/**
+	* The per vertex kernels for one row width. Picked once per job with GetTileKernels, after which
+	* every stage of the job calls straight through without looking at the tile size again.
+	*/
+	struct TileKernels
+	{
+		// Row width the kernels were compiled for, 0 for the generic ones
+		int32_t FixedXUnits;
+
+		float (*MeasureCurvature)(const TileLayout& aLayout, const float* aHeights);
+		void (*BuildPositions)(const TileLayout& aLayout, const float* aHeights, const float aVertexSpacing, const float aAmplitude, Vec3* aOutPositions);
+		void (*BuildNormals)(const TileLayout& aLayout, const float* aHeights, const float aVertexSpacing, const float aAmplitude,
+			Vec3* aOutNormals, Tangent* aOutTangents, Color* aOutColours);
+	};
+
+	/** Kernels with the row width fixed at compile time, so the row loops have a constant trip count and stride */
+	template<int32_t FixedXUnits>
+	const TileKernels& GetFixedTileKernels()
+	{
+		static const TileKernels kernels = { FixedXUnits, &MeasureCurvature<FixedXUnits>, &BuildPositions<FixedXUnits>, &BuildNormals<FixedXUnits> };
+		return kernels;
+	}
+
+	/**
+	* Fixed width kernels for the tile sizes people actually use, at any LOD that lands on one, and the
+	* generic ones for anything else. aForceGeneric is for comparing the two
+	*/
+	inline const TileKernels& GetTileKernels(const TileLayout& aLayout, const bool aForceGeneric = false)
+	{
+		switch (aForceGeneric ? 0 : aLayout.XUnits)
+		{
+		case 16: return GetFixedTileKernels<16>();
+		case 32: return GetFixedTileKernels<32>();
+		case 64: return GetFixedTileKernels<64>();
+		case 128: return GetFixedTileKernels<128>();
+		case 256: return GetFixedTileKernels<256>();
+		default: return GetFixedTileKernels<0>();
+		}
+	}
+}
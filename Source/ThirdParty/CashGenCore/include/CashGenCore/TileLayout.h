@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CashGenCore
+{
+	/**
+	* Sizes of everything that makes up one tile at one LOD.
+	* The grid comes first in the vertex and index streams, then the skirts hanging off its edges.
+	*/
+	struct TileLayout
+	{
+		// Quads along each side at this LOD
+		int32_t XUnits = 0;
+		int32_t YUnits = 0;
+		int32_t NumXVerts = 0;
+		int32_t NumYVerts = 0;
+
+		int32_t NumGridVertices = 0;
+		int32_t NumSkirtVertices = 0;
+		int32_t NumVertices = 0;
+
+		int32_t NumGridIndices = 0;
+		int32_t NumSkirtIndices = 0;
+		int32_t NumIndices = 0;
+
+		// The heightmap has a one sample border all round, so normals at the tile edge match the neighbours'
+		int32_t HeightMapRowLength = 0;
+		int32_t NumHeights = 0;
+	};
+
+	/** Layout of a tile of aTileXUnits by aTileYUnits full resolution quads, with every aDivisor quads merged into one */
+	inline TileLayout MakeTileLayout(const int32_t aTileXUnits, const int32_t aTileYUnits, const int32_t aDivisor)
+	{
+		const int32_t divisor = aDivisor > 0 ? aDivisor : 1;
+
+		TileLayout layout;
+		layout.XUnits = aTileXUnits / divisor;
+		layout.YUnits = aTileYUnits / divisor;
+		layout.NumXVerts = layout.XUnits + 1;
+		layout.NumYVerts = layout.YUnits + 1;
+
+		layout.NumGridVertices = layout.NumXVerts * layout.NumYVerts;
+		// Full rows along the bottom and top, the corners aren't repeated down the sides
+		layout.NumSkirtVertices = (layout.NumXVerts * 2) + ((layout.NumYVerts - 2) * 2);
+		layout.NumVertices = layout.NumGridVertices + layout.NumSkirtVertices;
+
+		layout.NumGridIndices = layout.XUnits * layout.YUnits * 6;
+		layout.NumSkirtIndices = ((layout.XUnits * 2) + (layout.YUnits * 2)) * 6;
+		layout.NumIndices = layout.NumGridIndices + layout.NumSkirtIndices;
+
+		layout.HeightMapRowLength = layout.NumXVerts + 2;
+		layout.NumHeights = layout.HeightMapRowLength * (layout.NumYVerts + 2);
+		return layout;
+	}
+}